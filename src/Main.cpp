@@ -1,5 +1,6 @@
 #include "AppProperties.h"
 #include "MainComponent.h"
+#include "cli/RenderCommand.h"
 #include "ui/LookAndFeel.h"
 #include <juce_gui_extra/juce_gui_extra.h>
 
@@ -8,10 +9,17 @@ class CalliopeApplication : public juce::JUCEApplication
 public:
     const juce::String getApplicationName() override { return "Calliope"; }
     const juce::String getApplicationVersion() override { return "0.1.0"; }
-    bool moreThanOneInstanceAllowed() override { return false; }
+    bool moreThanOneInstanceAllowed() override { return RenderCommand::isRequested(getCommandLineParameterArray()); }
 
     void initialise(const juce::String&) override
     {
+        if (RenderCommand::isRequested(getCommandLineParameterArray()))
+        {
+            setApplicationReturnValue(RenderCommand::run(getCommandLineParameterArray()));
+            quit();
+            return;
+        }
+
         juce::PropertiesFile::Options options;
         options.applicationName = getApplicationName();
         options.filenameSuffix = ".settings";
@@ -284,6 +284,7 @@ MainComponent::MainComponent()
 
     audioDeviceManager.addAudioCallback(&audioPlayer);
     audioPlayer.setProcessor(&audioGraph);
+    updatePlaybackClockSource();
 
     document.getSequence().addTrack();
     document.getSequence().addListener(this);
@@ -308,9 +309,9 @@ MainComponent::MainComponent()
     {
         if (updatingFromEventList)
             return;
-        std::set<std::pair<int, int>> noteRefs;
+        std::set<std::pair<int, NoteId>> noteRefs;
         for (const auto& ref : selected)
-            noteRefs.insert({ref.trackIndex, ref.noteIndex});
+            noteRefs.insert({ref.trackIndex, ref.noteId});
         eventList.setSelectedNotes(noteRefs);
     };
     pianoRoll.onNotePreview = [this](const MidiNote& note)
@@ -382,7 +383,7 @@ MainComponent::MainComponent()
     trackList.onMuteSoloChanged = [this]()
     {
         document.getSequence().notifyTracksChanged();
-        playbackEngine.rebuildSnapshot();
+        playbackEngine.updateTrackAudibility();
     };
     trackList.pluginNameForTrack = [this](int trackIndex) { return pluginHost.getPluginName(trackIndex); };
     trackList.onEditorButtonClicked = [this](int trackIndex) { pluginHost.showEditor(trackIndex); };
@@ -670,8 +671,8 @@ MainComponent::MainComponent()
     {
         updatingFromEventList = true;
         std::set<PianoRollComponent::NoteRef> notes;
-        for (const auto& [trackIdx, noteIdx] : noteRefs)
-            notes.insert({trackIdx, noteIdx});
+        for (const auto& [trackIdx, noteId] : noteRefs)
+            notes.insert({trackIdx, noteId});
         pianoRoll.setSelectedNotes(notes);
         updatingFromEventList = false;
     };
@@ -708,6 +709,7 @@ MainComponent::MainComponent()
         {
             playbackEngine.play();
             playButton.setActive(true);
+            lastVBlankTick = -1;
             vblankAttachment = std::make_unique<juce::VBlankAttachment>(this, [this]() { onVBlank(); });
         }
     };
@@ -951,6 +953,7 @@ void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
     {
         if (auto xml = audioDeviceManager.createStateXml())
             getAppProperties().getUserSettings()->setValue("audioDeviceState", xml.get());
+        updatePlaybackClockSource();
     }
 }
 
@@ -1048,6 +1051,18 @@ juce::PopupMenu MainComponent::getMenuForIndex(int menuIndex, const juce::String
         menu.addCommandItem(&commandManager, CommandID::zoomOutVertical);
         menu.addSeparator();
         menu.addCommandItem(&commandManager, CommandID::zoomReset);
+        menu.addSeparator();
+        menu.addItem(juce::PopupMenu::Item("Cache Piano Roll Background")
+                         .setTicked(pianoRoll.isStaticLayerCacheEnabled())
+                         .setAction([this]()
+                                    { pianoRoll.setStaticLayerCacheEnabled(!pianoRoll.isStaticLayerCacheEnabled()); }));
+        menu.addItem(juce::PopupMenu::Item("Show Frame Times")
+                         .setTicked(pianoRoll.isShowingFrameTimes())
+                         .setAction([this]() { pianoRoll.setShowFrameTimes(!pianoRoll.isShowingFrameTimes()); }));
+        menu.addItem(juce::PopupMenu::Item("OpenGL Note Rendering")
+                         .setTicked(pianoRoll.isOpenGLRenderingEnabled())
+                         .setAction([this]()
+                                    { pianoRoll.setOpenGLRenderingEnabled(!pianoRoll.isOpenGLRenderingEnabled()); }));
     }
     else if (menuIndex == 3)
     {
@@ -1702,8 +1717,14 @@ void MainComponent::onVBlank()
     pianoRoll.setPlayheadTick(tick);
     controllerLane.setPlayheadTick(tick);
     eventList.setPlayheadTick(tick);
+
+    // The transport labels and the scroll position only depend on the whole tick.
+    int wholeTick = static_cast<int>(tick);
+    if (wholeTick == lastVBlankTick)
+        return;
+    lastVBlankTick = wholeTick;
     updateTransportDisplay();
-    scrollToPlayhead(static_cast<int>(tick));
+    scrollToPlayhead(wholeTick);
 }
 
 void MainComponent::jumpToTick(int tick)
@@ -1982,6 +2003,16 @@ void MainComponent::updateTransportDisplay()
         double tempo = document.getSequence().getTempoAt(tick);
         tempoValueLabel.setText(juce::String(tempo, 2), juce::dontSendNotification);
     }
+
+    // Messages lost to a full output queue stay flagged in the position header until restart.
+    const auto dropped = midiOutput.getNumDroppedMessages() + pluginHost.getNumDroppedMessages();
+    if (dropped != shownDroppedMidiMessages)
+    {
+        shownDroppedMidiMessages = dropped;
+        positionHeaderLabel.setText("POSITION (" + juce::String(dropped) + " MIDI DROPPED)",
+                                    juce::dontSendNotification);
+        positionHeaderLabel.setColour(juce::Label::textColourId, calliope::theme::status::danger);
+    }
 }
 
 void MainComponent::setHorizontalZoom(int newBeatWidth, int anchorXInViewport)
@@ -2116,6 +2147,14 @@ void MainComponent::showAudioSettings()
     options.launchAsync();
 }
 
+void MainComponent::updatePlaybackClockSource()
+{
+    auto* device = audioDeviceManager.getCurrentAudioDevice();
+    const bool audioRunning = device != nullptr && device->isPlaying();
+    playbackEngine.setClockSource(audioRunning ? PlaybackEngine::ClockSource::AudioDevice
+                                               : PlaybackEngine::ClockSource::HighResolutionTimer);
+}
+
 void MainComponent::stopPlayback()
 {
     playbackEngine.stop();
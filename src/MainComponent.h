@@ -1,6 +1,7 @@
 #pragma once
 
 #include "audio/MidiDeviceOutput.h"
+#include "audio/PlaybackAudioPlayer.h"
 #include "audio/VstPluginHost.h"
 #include "engine/PlaybackEngine.h"
 #include "document/Document.h"
@@ -144,6 +145,7 @@ private:
     void loadPlugin();
     void managePlugins();
     void showAudioSettings();
+    void updatePlaybackClockSource();
     void stopPlayback();
     void onSequenceLoaded();
     void updateTitleBar();
@@ -154,7 +156,7 @@ private:
     MidiDeviceOutput midiOutput;
     juce::AudioDeviceManager audioDeviceManager;
     juce::AudioProcessorGraph audioGraph;
-    juce::AudioProcessorPlayer audioPlayer;
+    PlaybackAudioPlayer audioPlayer{playbackEngine};
     VstPluginHost pluginHost;
     juce::KnownPluginList knownPluginList;
     juce::Array<juce::PluginDescription> pluginMenuSnapshot;
@@ -503,6 +505,8 @@ private:
 
     std::unique_ptr<juce::FileChooser> fileChooser;
     std::unique_ptr<juce::VBlankAttachment> vblankAttachment;
+    int lastVBlankTick = -1;
+    std::uint64_t shownDroppedMidiMessages = 0;
     bool fileDragOver = false;
     bool updatingFromEventList = false;
 
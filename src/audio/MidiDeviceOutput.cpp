@@ -24,6 +24,8 @@ void sendResetMessages(juce::MidiOutput& output)
 }
 } // namespace
 
+MidiDeviceOutput::MidiDeviceOutput() : juce::Thread("MIDI Output") {}
+
 MidiDeviceOutput::~MidiDeviceOutput()
 {
     close();
@@ -46,6 +48,8 @@ bool MidiDeviceOutput::open(const juce::String& deviceIdentifier)
     if (midiOutput != nullptr)
     {
         currentDeviceIdentifier = deviceIdentifier;
+        deviceOpen = true;
+        startThread(juce::Thread::Priority::high);
         return true;
     }
     currentDeviceIdentifier.clear();
@@ -57,11 +61,20 @@ juce::String MidiDeviceOutput::getCurrentDeviceIdentifier() const
     return currentDeviceIdentifier;
 }
 
+std::uint64_t MidiDeviceOutput::getNumDroppedMessages() const
+{
+    return playbackQueue.getNumDropped() + controlQueue.getNumDropped();
+}
+
 void MidiDeviceOutput::close()
 {
+    deviceOpen = false;
+    stopThread(1000);
+
     std::lock_guard<std::mutex> lock(sendMutex);
     if (midiOutput)
     {
+        flushPending();
         sendResetMessages(*midiOutput);
         midiOutput.reset();
     }
@@ -73,59 +86,62 @@ void MidiDeviceOutput::reset()
     if (!midiOutput)
         return;
 
+    flushPending();
     sendResetMessages(*midiOutput);
 }
 
-void MidiDeviceOutput::onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note)
+void MidiDeviceOutput::run()
 {
-    std::lock_guard<std::mutex> lock(sendMutex);
-    if (!midiOutput)
-        return;
-    if (ctx.destination != MidiTrack::OutputDestination::MidiDevice)
-        return;
-    midiOutput->sendMessageNow(
-        juce::MidiMessage::noteOn(ctx.channel, note.noteNumber, static_cast<juce::uint8>(note.velocity)));
+    while (!threadShouldExit())
+    {
+        if (pending.exchange(false, std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (midiOutput)
+                flushPending();
+        }
+        wait(pollIntervalMs);
+    }
 }
 
-void MidiDeviceOutput::onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note)
+// Caller holds sendMutex, which also serialises the consumer side of both queues. Control messages
+// are only produced once the clock has stopped, so they follow everything already played and go last.
+void MidiDeviceOutput::flushPending()
 {
-    std::lock_guard<std::mutex> lock(sendMutex);
-    if (!midiOutput)
-        return;
-    if (ctx.destination != MidiTrack::OutputDestination::MidiDevice)
-        return;
-    midiOutput->sendMessageNow(juce::MidiMessage::noteOff(ctx.channel, note.noteNumber));
+    auto send = [this](const EncodedMidiMessage& m)
+    { midiOutput->sendMessageNow(juce::MidiMessage(m.bytes.data(), m.size)); };
+    auto silence = [this](int channel) { midiOutput->sendMessageNow(juce::MidiMessage::allNotesOff(channel)); };
+    playbackQueue.drain(send, silence);
+    controlQueue.drain(send, silence);
 }
 
-void MidiDeviceOutput::onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event)
+void MidiDeviceOutput::enqueue(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message)
 {
-    std::lock_guard<std::mutex> lock(sendMutex);
-    if (!midiOutput)
+    if (!deviceOpen)
         return;
     if (ctx.destination != MidiTrack::OutputDestination::MidiDevice)
         return;
 
-    const int ch = ctx.channel;
-    juce::MidiMessage msg;
+    // The playback thread only raises the flag, which the sender picks up on its next poll; signalling
+    // the thread would take a lock on every message. Control messages are rare and wake it at once.
+    const bool onMessageThread = juce::MessageManager::existsAndIsCurrentThread();
+    (onMessageThread ? controlQueue : playbackQueue).push(message);
+    pending.store(true, std::memory_order_release);
+    if (onMessageThread)
+        notify();
+}
 
-    switch (event.type)
-    {
-    case MidiEvent::Type::ControlChange:
-        msg = juce::MidiMessage::controllerEvent(ch, event.data1, event.data2);
-        break;
-    case MidiEvent::Type::ProgramChange:
-        msg = juce::MidiMessage::programChange(ch, event.data1);
-        break;
-    case MidiEvent::Type::PitchBend:
-        msg = juce::MidiMessage::pitchWheel(ch, event.data1);
-        break;
-    case MidiEvent::Type::ChannelPressure:
-        msg = juce::MidiMessage::channelPressureChange(ch, event.data1);
-        break;
-    case MidiEvent::Type::KeyPressure:
-        msg = juce::MidiMessage::aftertouchChange(ch, event.data1, event.data2);
-        break;
-    }
+void MidiDeviceOutput::onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note)
+{
+    enqueue(ctx, EncodedMidiMessage::noteOn(ctx.channel, note));
+}
+
+void MidiDeviceOutput::onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note)
+{
+    enqueue(ctx, EncodedMidiMessage::noteOff(ctx.channel, note));
+}
 
-    midiOutput->sendMessageNow(msg);
+void MidiDeviceOutput::onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event)
+{
+    enqueue(ctx, EncodedMidiMessage::fromEvent(ctx.channel, event));
 }
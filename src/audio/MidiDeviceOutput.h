@@ -1,13 +1,18 @@
 #pragma once
 
+#include "../engine/EncodedMidiMessage.h"
+#include "../engine/MidiMessageQueue.h"
 #include "../engine/PlaybackListener.h"
+#include <atomic>
+#include <cstdint>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <memory>
 #include <mutex>
 
-class MidiDeviceOutput : public PlaybackListener
+class MidiDeviceOutput : public PlaybackListener, private juce::Thread
 {
 public:
+    MidiDeviceOutput();
     ~MidiDeviceOutput() override;
 
     bool open();
@@ -16,12 +21,26 @@ public:
     void reset();
 
     juce::String getCurrentDeviceIdentifier() const;
+    std::uint64_t getNumDroppedMessages() const;
 
     void onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note) override;
     void onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note) override;
     void onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event) override;
 
 private:
+    void run() override;
+    void enqueue(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message);
+    void flushPending();
+
+    // Playback-thread and message-thread producers each get their own queue; the sender thread
+    // polls for pushes to either every millisecond, drains both and is the only place that talks to
+    // the device.
+    static constexpr int pollIntervalMs = 1;
+    MidiMessageQueue playbackQueue{4096};
+    MidiMessageQueue controlQueue{1024};
+    std::atomic<bool> pending{false};
+    std::atomic<bool> deviceOpen{false};
+
     std::unique_ptr<juce::MidiOutput> midiOutput;
     juce::String currentDeviceIdentifier;
     std::mutex sendMutex;
@@ -0,0 +1,147 @@
+#include "OfflineRenderer.h"
+#include "../engine/PlaybackEngine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+int resolveEndTick(const MidiSequence& sequence, const OfflineRenderer::Options& options)
+{
+    return options.endTick >= 0 ? options.endTick : sequence.getEndTick();
+}
+
+double passSeconds(const MidiSequence& sequence, const OfflineRenderer::Options& options)
+{
+    const auto& tempoMap = *sequence.getTempoMap();
+    const int startTick = std::max(0, options.startTick);
+    return tempoMap.ticksToSeconds(resolveEndTick(sequence, options)) - tempoMap.ticksToSeconds(startTick);
+}
+} // namespace
+
+OfflineRenderer::OfflineRenderer(const MidiSequence& seq, juce::AudioProcessorGraph& g, PlaybackListener& input)
+    : sequence(seq), graph(g), graphInput(input)
+{
+}
+
+double OfflineRenderer::getRenderedSeconds(const MidiSequence& seq, const Options& options)
+{
+    return passSeconds(seq, options) * std::max(1, options.loopCount) + std::max(0.0, options.tailSeconds);
+}
+
+std::unique_ptr<juce::AudioFormatWriter> OfflineRenderer::createWriter(const juce::File& file, const Options& options)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    auto* format = formats.findFormatForFileExtension(file.getFileExtension());
+    if (format == nullptr)
+        return nullptr;
+
+    file.deleteFile();
+    auto stream = file.createOutputStream();
+    if (stream == nullptr)
+        return nullptr;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        format->createWriterFor(stream.get(), options.sampleRate, static_cast<unsigned int>(options.numChannels),
+                                options.bitsPerSample, {}, 0));
+    if (writer != nullptr)
+        stream.release(); // now owned by the writer
+    return writer;
+}
+
+bool OfflineRenderer::run(const MidiSequence& seq, const Options& options, PlaybackListener& input,
+                          const std::function<void(int)>& renderBlock, const std::function<bool(double)>& onProgress)
+{
+    const double sampleRate = options.sampleRate;
+    const int blockSize = options.blockSize;
+    const int startTick = std::max(0, options.startTick);
+    const int endTick = resolveEndTick(seq, options);
+    if (endTick <= startTick || sampleRate <= 0.0 || blockSize <= 0)
+        return false;
+
+    const int passes = std::max(1, options.loopCount);
+    const auto passSamples = static_cast<juce::int64>(std::llround(passSeconds(seq, options) * sampleRate));
+    const juce::int64 musicSamples = passSamples * passes;
+    const juce::int64 totalSamples =
+        musicSamples + static_cast<juce::int64>(std::llround(std::max(0.0, options.tailSeconds) * sampleRate));
+    const juce::int64 lastPassStart = musicSamples - passSamples;
+
+    // A private engine on the audio clock gives the same sample-accurate timing and loop handling
+    // as device playback, with the block loop below standing in for the device.
+    PlaybackEngine engine;
+    engine.setClockSource(PlaybackEngine::ClockSource::AudioDevice);
+    engine.setSequence(&seq);
+    engine.addListener(&input);
+    engine.setLoopRange(startTick, endTick);
+    engine.setLoopEnabled(passes > 1);
+    engine.setPositionInTicks(startTick);
+    engine.play();
+
+    bool completed = true;
+    for (juce::int64 pos = 0; pos < totalSamples;)
+    {
+        // Blocks are cut at the end of the last pass so nothing past endTick is sent.
+        juce::int64 blockEnd = std::min(pos + blockSize, totalSamples);
+        if (pos < musicSamples)
+            blockEnd = std::min(blockEnd, musicSamples);
+        const int numSamples = static_cast<int>(blockEnd - pos);
+
+        if (pos >= lastPassStart)
+            engine.setLoopEnabled(false);
+        engine.processAudioBlock(numSamples, sampleRate);
+        renderBlock(numSamples);
+
+        // Note-offs go out ahead of the first tail block.
+        if (blockEnd == musicSamples)
+            engine.stop();
+
+        pos = blockEnd;
+        if (onProgress && !onProgress(static_cast<double>(pos) / static_cast<double>(totalSamples)))
+        {
+            completed = false;
+            break;
+        }
+    }
+
+    engine.stop();
+    engine.removeListener(&input);
+    engine.setSequence(nullptr);
+    return completed;
+}
+
+bool OfflineRenderer::render(const juce::File& outputFile, const Options& options,
+                             const std::function<bool(double)>& onProgress)
+{
+    if (options.numChannels <= 0)
+        return false;
+
+    auto writer = createWriter(outputFile, options);
+    if (writer == nullptr)
+        return false;
+
+    graph.setPlayConfigDetails(0, options.numChannels, options.sampleRate, options.blockSize);
+    graph.setNonRealtime(true);
+    graph.prepareToPlay(options.sampleRate, options.blockSize);
+
+    juce::AudioBuffer<float> buffer(options.numChannels, options.blockSize);
+    juce::MidiBuffer midi;
+    const bool completed = run(
+        sequence, options, graphInput,
+        [&](int numSamples)
+        {
+            buffer.setSize(options.numChannels, numSamples, false, false, true);
+            buffer.clear();
+            midi.clear();
+            graph.processBlock(buffer, midi);
+            writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+        },
+        onProgress);
+
+    graph.releaseResources();
+    graph.setNonRealtime(false);
+
+    writer.reset();
+    if (!completed)
+        outputFile.deleteFile();
+    return completed;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../engine/PlaybackListener.h"
+#include "../model/MidiSequence.h"
+#include <functional>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+
+// Bounces a sequence through an AudioProcessorGraph block by block, with no device or realtime clock,
+// and writes the result with a JUCE audio format writer chosen by file extension (.wav, .flac, ...).
+// Runs as fast as the plugins allow. Must be called on the message thread, like any graph change.
+class OfflineRenderer
+{
+public:
+    struct Options
+    {
+        double sampleRate = 44100.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        int bitsPerSample = 24;
+        int startTick = 0;
+        int endTick = -1; // -1 renders up to MidiSequence::getEndTick()
+        int loopCount = 1; // passes over [startTick, endTick)
+        double tailSeconds = 2.0;
+    };
+
+    // graphInput receives the sample-stamped playback events, normally the VstPluginHost feeding graph.
+    OfflineRenderer(const MidiSequence& sequence, juce::AudioProcessorGraph& graph, PlaybackListener& graphInput);
+
+    // onProgress gets the fraction rendered so far; returning false cancels and deletes the file.
+    bool render(const juce::File& outputFile, const Options& options,
+                const std::function<bool(double)>& onProgress = nullptr);
+
+    // Plays sequence over the render span on a private engine. Before each block callback the block's
+    // events have been sent to input, stamped with their sample offsets. Safe to run on any thread, and
+    // on several at once for the same sequence as long as nobody edits it meanwhile.
+    static bool run(const MidiSequence& sequence, const Options& options, PlaybackListener& input,
+                    const std::function<void(int numSamples)>& renderBlock,
+                    const std::function<bool(double)>& onProgress = nullptr);
+
+    static double getRenderedSeconds(const MidiSequence& sequence, const Options& options);
+    static std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, const Options& options);
+
+private:
+    const MidiSequence& sequence;
+    juce::AudioProcessorGraph& graph;
+    PlaybackListener& graphInput;
+
+    JUCE_DECLARE_NON_COPYABLE(OfflineRenderer)
+};
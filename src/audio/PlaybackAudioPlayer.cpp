@@ -0,0 +1,20 @@
+#include "PlaybackAudioPlayer.h"
+
+PlaybackAudioPlayer::PlaybackAudioPlayer(PlaybackEngine& e) : engine(e) {}
+
+void PlaybackAudioPlayer::audioDeviceAboutToStart(juce::AudioIODevice* device)
+{
+    sampleRate = device->getCurrentSampleRate();
+    AudioProcessorPlayer::audioDeviceAboutToStart(device);
+}
+
+void PlaybackAudioPlayer::audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                                           float* const* outputChannelData, int numOutputChannels,
+                                                           int numSamples,
+                                                           const juce::AudioIODeviceCallbackContext& context)
+{
+    const PlaybackEngine::ScopedAudioBlock block(engine);
+    engine.processAudioBlock(numSamples, sampleRate);
+    AudioProcessorPlayer::audioDeviceIOCallbackWithContext(inputChannelData, numInputChannels, outputChannelData,
+                                                           numOutputChannels, numSamples, context);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../engine/PlaybackEngine.h"
+#include <juce_audio_utils/juce_audio_utils.h>
+
+// AudioProcessorPlayer that advances the playback engine by each device block before the graph renders it.
+class PlaybackAudioPlayer : public juce::AudioProcessorPlayer
+{
+public:
+    explicit PlaybackAudioPlayer(PlaybackEngine& engine);
+
+    void audioDeviceAboutToStart(juce::AudioIODevice* device) override;
+    void audioDeviceIOCallbackWithContext(const float* const* inputChannelData, int numInputChannels,
+                                          float* const* outputChannelData, int numOutputChannels, int numSamples,
+                                          const juce::AudioIODeviceCallbackContext& context) override;
+
+private:
+    PlaybackEngine& engine;
+    double sampleRate = 0.0;
+};
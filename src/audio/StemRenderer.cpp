@@ -0,0 +1,194 @@
+#include "StemRenderer.h"
+#include "../engine/EncodedMidiMessage.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace
+{
+// Collects the playback events routed to one plugin track into the MIDI buffer for the next block.
+class StemInput : public PlaybackListener
+{
+public:
+    explicit StemInput(int target) : targetTrack(target) { midi.ensureSize(blockMessageCapacity); }
+
+    // Unstamped events (the note-offs sent when playback stops) go to the start of the next block.
+    void onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note) override { onNoteOnAt(ctx, note, 0); }
+    void onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note) override { onNoteOffAt(ctx, note, 0); }
+    void onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event) override
+    {
+        onMidiEventAt(ctx, event, 0);
+    }
+
+    void onNoteOnAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset) override
+    {
+        add(ctx, EncodedMidiMessage::noteOn(ctx.channel, note), sampleOffset);
+    }
+    void onNoteOffAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset) override
+    {
+        add(ctx, EncodedMidiMessage::noteOff(ctx.channel, note), sampleOffset);
+    }
+    void onMidiEventAt(const PlaybackTrackContext& ctx, const MidiEvent& event, int sampleOffset) override
+    {
+        add(ctx, EncodedMidiMessage::fromEvent(ctx.channel, event), sampleOffset);
+    }
+
+    juce::MidiBuffer midi;
+
+private:
+    void add(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message, int sampleOffset)
+    {
+        if (ctx.destination == MidiTrack::OutputDestination::Plugin && ctx.routeTarget == targetTrack)
+            midi.addEvent(message.bytes.data(), message.size, sampleOffset);
+    }
+
+    static constexpr int blockMessageCapacity = 4096;
+    int targetTrack;
+};
+} // namespace
+
+// The stems' float output, summed block by block as the workers render.
+class StemRenderer::MixBus
+{
+public:
+    MixBus(int numChannels, int capacity) : buffer(numChannels, capacity) { buffer.clear(); }
+
+    void add(const juce::AudioBuffer<float>& block, int position, int numSamples)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        numSamples = std::min(numSamples, buffer.getNumSamples() - position);
+        if (numSamples <= 0)
+            return;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            buffer.addFrom(ch, position, block, ch, 0, numSamples);
+        length = std::max(length, position + numSamples);
+    }
+
+    bool write(const juce::File& file, const OfflineRenderer::Options& options) const
+    {
+        auto writer = OfflineRenderer::createWriter(file, options);
+        return writer != nullptr && writer->writeFromAudioSampleBuffer(buffer, 0, length);
+    }
+
+private:
+    juce::AudioBuffer<float> buffer;
+    int length = 0;
+    std::mutex mutex;
+};
+
+StemRenderer::StemRenderer(const MidiSequence& seq) : sequence(seq) {}
+
+void StemRenderer::setTrackPlugin(int trackIndex, std::unique_ptr<juce::AudioPluginInstance> plugin)
+{
+    if (plugin != nullptr)
+        plugins[trackIndex] = std::move(plugin);
+    else
+        plugins.erase(trackIndex);
+}
+
+juce::File StemRenderer::getStemFile(const juce::File& outputDir, const juce::String& baseName,
+                                     const juce::String& extension, int trackIndex) const
+{
+    return outputDir.getChildFile(baseName + "-track" + juce::String(trackIndex + 1).paddedLeft('0', 2) + extension);
+}
+
+juce::File StemRenderer::getMixFile(const juce::File& outputDir, const juce::String& baseName,
+                                    const juce::String& extension) const
+{
+    return outputDir.getChildFile(baseName + "-mix" + extension);
+}
+
+bool StemRenderer::renderStem(int trackIndex, juce::AudioPluginInstance& plugin, const juce::File& file,
+                              const OfflineRenderer::Options& options, MixBus& mix) const
+{
+    auto writer = OfflineRenderer::createWriter(file, options);
+    if (writer == nullptr)
+        return false;
+
+    // Multi-output plugins render into a wider buffer; only the first numChannels are written,
+    // like the two channels the graph connects to its output.
+    const int numChannels =
+        std::max({plugin.getTotalNumInputChannels(), plugin.getTotalNumOutputChannels(), options.numChannels});
+    juce::AudioBuffer<float> buffer(numChannels, options.blockSize);
+    StemInput input(trackIndex);
+    int position = 0;
+
+    const bool completed = OfflineRenderer::run(sequence, options, input,
+                                                [&](int numSamples)
+                                                {
+                                                    buffer.setSize(numChannels, numSamples, false, false, true);
+                                                    buffer.clear();
+                                                    plugin.processBlock(buffer, input.midi);
+                                                    input.midi.clear();
+
+                                                    const juce::AudioBuffer<float> written(
+                                                        buffer.getArrayOfWritePointers(), options.numChannels,
+                                                        numSamples);
+                                                    writer->writeFromAudioSampleBuffer(written, 0, numSamples);
+                                                    mix.add(written, position, numSamples);
+                                                    position += numSamples;
+                                                });
+
+    writer.reset();
+    if (!completed)
+        file.deleteFile();
+    return completed;
+}
+
+bool StemRenderer::render(const juce::File& outputDir, const juce::String& baseName, const juce::String& extension,
+                          const OfflineRenderer::Options& options, int numThreads)
+{
+    if (plugins.empty() || options.numChannels <= 0 || !outputDir.createDirectory())
+        return false;
+
+    // Plugins are prepared and released here on the calling thread; workers only process blocks.
+    for (auto& [trackIndex, plugin] : plugins)
+    {
+        plugin->setNonRealtime(true);
+        plugin->setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+        plugin->prepareToPlay(options.sampleRate, options.blockSize);
+    }
+
+    // One block of slack over the rendered length, which run() rounds to whole samples.
+    const auto mixCapacity =
+        static_cast<int>(std::ceil(OfflineRenderer::getRenderedSeconds(sequence, options) * options.sampleRate)) +
+        options.blockSize;
+    MixBus mix(options.numChannels, mixCapacity);
+
+    std::vector<juce::File> stemFiles;
+    for (const auto& [trackIndex, plugin] : plugins)
+        stemFiles.push_back(getStemFile(outputDir, baseName, extension, trackIndex));
+
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+    numThreads = std::min(numThreads, static_cast<int>(plugins.size()));
+
+    std::atomic<int> remaining{static_cast<int>(plugins.size())};
+    std::atomic<bool> allRendered{true};
+    juce::WaitableEvent finished;
+    {
+        juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("Stem render").withNumberOfThreads(numThreads));
+        std::size_t stemIndex = 0;
+        for (auto& [trackIndex, plugin] : plugins)
+        {
+            pool.addJob(
+                [&, trackIndex, plugin = plugin.get(), file = stemFiles[stemIndex++]]
+                {
+                    if (!renderStem(trackIndex, *plugin, file, options, mix))
+                        allRendered = false;
+                    if (--remaining == 0)
+                        finished.signal();
+                });
+        }
+        finished.wait();
+    }
+
+    for (auto& [trackIndex, plugin] : plugins)
+    {
+        plugin->releaseResources();
+        plugin->setNonRealtime(false);
+    }
+
+    return allRendered && mix.write(getMixFile(outputDir, baseName, extension), options);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+#include <map>
+
+// Non-realtime stem export. An AudioProcessorGraph runs every node on one thread, but each track's
+// plugin only depends on its own MIDI, so here every plugin renders on its own worker thread straight
+// from the sequence's playback data. Writes one file per plugin track plus their sum, which is added
+// up in memory from the float output so the mix is quantised only once.
+class StemRenderer
+{
+public:
+    explicit StemRenderer(const MidiSequence& sequence);
+
+    // The plugin renders every track whose output is routed to trackIndex. Call on the message thread.
+    void setTrackPlugin(int trackIndex, std::unique_ptr<juce::AudioPluginInstance> plugin);
+
+    // Writes <baseName>-trackNN<extension> per plugin track and <baseName>-mix<extension> into outputDir.
+    // numThreads <= 0 uses one worker per CPU core. Call on the message thread.
+    bool render(const juce::File& outputDir, const juce::String& baseName, const juce::String& extension,
+                const OfflineRenderer::Options& options, int numThreads = 0);
+
+    juce::File getStemFile(const juce::File& outputDir, const juce::String& baseName, const juce::String& extension,
+                           int trackIndex) const;
+    juce::File getMixFile(const juce::File& outputDir, const juce::String& baseName,
+                          const juce::String& extension) const;
+
+private:
+    class MixBus;
+
+    bool renderStem(int trackIndex, juce::AudioPluginInstance& plugin, const juce::File& file,
+                    const OfflineRenderer::Options& options, MixBus& mix) const;
+
+    const MidiSequence& sequence;
+    std::map<int, std::unique_ptr<juce::AudioPluginInstance>> plugins;
+
+    JUCE_DECLARE_NON_COPYABLE(StemRenderer)
+};
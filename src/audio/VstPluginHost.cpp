@@ -25,21 +25,30 @@ public:
 private:
     std::function<void()> closeCallback;
 };
+} // namespace
 
-class MidiSourceProcessor : public juce::AudioProcessor
+class VstPluginHost::MidiSourceProcessor : public juce::AudioProcessor
 {
 public:
     MidiSourceProcessor() : AudioProcessor(BusesProperties()) {}
 
     const juce::String getName() const override { return "MIDI Source"; }
 
-    void prepareToPlay(double sampleRate, int) override { collector.reset(sampleRate); }
+    void prepareToPlay(double, int) override { blockMessages.ensureSize(blockMessageCapacity); }
     void releaseResources() override {}
 
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) override
     {
         midi.clear();
-        collector.removeNextBlockOfMessages(midi, buffer.getNumSamples());
+        auto addToBlockStart = [&midi](const EncodedMidiMessage& m) { midi.addEvent(m.bytes.data(), m.size, 0); };
+        auto silence = [&midi](int channel) { midi.addEvent(juce::MidiMessage::allNotesOff(channel), 0); };
+        playbackQueue.drain(addToBlockStart, silence);
+        controlQueue.drain(addToBlockStart, silence);
+        if (!blockMessages.isEmpty())
+        {
+            midi.addEvents(blockMessages, 0, buffer.getNumSamples(), 0);
+            blockMessages.clear();
+        }
     }
 
     bool acceptsMidi() const override { return false; }
@@ -55,9 +64,19 @@ public:
     void getStateInformation(juce::MemoryBlock&) override {}
     void setStateInformation(const void*, int) override {}
 
-    juce::MidiMessageCollector collector;
+    // Untimed messages, delivered at the start of the next block. The playback thread and the
+    // message thread each produce into their own queue; control messages are only produced once
+    // the clock has stopped, so they are delivered after the playback ones.
+    MidiMessageQueue playbackQueue{4096};
+    MidiMessageQueue controlQueue{1024};
+
+    // Sample-stamped messages written by the audio-clocked engine just before this block renders.
+    // Only touched on the audio thread.
+    juce::MidiBuffer blockMessages;
+
+private:
+    static constexpr int blockMessageCapacity = 4096;
 };
-} // namespace
 
 VstPluginHost::VstPluginHost()
 {
@@ -114,10 +133,10 @@ bool VstPluginHost::attachPlugin(int trackIndex, const juce::PluginDescription&
     detachPlugin(trackIndex);
 
     auto midiSourceProcessor = std::make_unique<MidiSourceProcessor>();
-    auto* collectorPtr = &midiSourceProcessor->collector;
+    auto* sourcePtr = midiSourceProcessor.get();
     auto midiSourceNode = graph->addNode(std::move(midiSourceProcessor));
     midiSourceNodes[trackIndex] = midiSourceNode->nodeID;
-    midiCollectors[trackIndex] = collectorPtr;
+    midiSources[trackIndex] = sourcePtr;
 
     auto pluginNode = graph->addNode(std::move(pluginInstance));
     pluginNodes[trackIndex] = pluginNode->nodeID;
@@ -140,7 +159,7 @@ void VstPluginHost::detachPlugin(int trackIndex)
         return;
 
     editorWindows.erase(trackIndex);
-    midiCollectors.erase(trackIndex);
+    midiSources.erase(trackIndex);
 
     if (auto sourceIt = midiSourceNodes.find(trackIndex); sourceIt != midiSourceNodes.end())
     {
@@ -185,7 +204,7 @@ void VstPluginHost::renumberTrackIndices(int from, int delta)
     };
     shiftMap(pluginNodes);
     shiftMap(midiSourceNodes);
-    shiftMap(midiCollectors);
+    shiftMap(midiSources);
 }
 
 void VstPluginHost::showEditor(int trackIndex)
@@ -228,61 +247,69 @@ juce::String VstPluginHost::getPluginName(int trackIndex) const
     return graph->getNodeForId(it->second)->getProcessor()->getName();
 }
 
-juce::MidiMessageCollector* VstPluginHost::resolveCollector(const PlaybackTrackContext& ctx) const
+VstPluginHost::MidiSourceProcessor* VstPluginHost::resolveSource(const PlaybackTrackContext& ctx) const
 {
     if (ctx.destination != MidiTrack::OutputDestination::Plugin)
         return nullptr;
 
     int targetIndex = ctx.routeTarget;
-    auto it = midiCollectors.find(targetIndex);
-    if (it == midiCollectors.end())
+    auto it = midiSources.find(targetIndex);
+    if (it == midiSources.end())
         return nullptr;
     return it->second;
 }
 
-void VstPluginHost::onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note)
+std::uint64_t VstPluginHost::getNumDroppedMessages() const
 {
-    auto* collector = resolveCollector(ctx);
-    if (collector == nullptr)
+    std::uint64_t dropped = 0;
+    for (const auto& [idx, source] : midiSources)
+        dropped += source->playbackQueue.getNumDropped() + source->controlQueue.getNumDropped();
+    return dropped;
+}
+
+void VstPluginHost::enqueue(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message)
+{
+    auto* source = resolveSource(ctx);
+    if (source == nullptr)
         return;
-    collector->addMessageToQueue(
-        juce::MidiMessage::noteOn(ctx.channel, note.noteNumber, static_cast<juce::uint8>(note.velocity)));
+    auto& queue = juce::MessageManager::existsAndIsCurrentThread() ? source->controlQueue : source->playbackQueue;
+    queue.push(message);
 }
 
-void VstPluginHost::onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note)
+void VstPluginHost::enqueueAt(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message, int sampleOffset)
 {
-    auto* collector = resolveCollector(ctx);
-    if (collector == nullptr)
+    auto* source = resolveSource(ctx);
+    if (source == nullptr)
         return;
-    collector->addMessageToQueue(juce::MidiMessage::noteOff(ctx.channel, note.noteNumber));
+    source->blockMessages.addEvent(message.bytes.data(), message.size, sampleOffset);
+}
+
+void VstPluginHost::onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note)
+{
+    enqueue(ctx, EncodedMidiMessage::noteOn(ctx.channel, note));
+}
+
+void VstPluginHost::onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note)
+{
+    enqueue(ctx, EncodedMidiMessage::noteOff(ctx.channel, note));
 }
 
 void VstPluginHost::onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event)
 {
-    auto* collector = resolveCollector(ctx);
-    if (collector == nullptr)
-        return;
+    enqueue(ctx, EncodedMidiMessage::fromEvent(ctx.channel, event));
+}
 
-    const int ch = ctx.channel;
-    juce::MidiMessage msg;
-    switch (event.type)
-    {
-    case MidiEvent::Type::ControlChange:
-        msg = juce::MidiMessage::controllerEvent(ch, event.data1, event.data2);
-        break;
-    case MidiEvent::Type::ProgramChange:
-        msg = juce::MidiMessage::programChange(ch, event.data1);
-        break;
-    case MidiEvent::Type::PitchBend:
-        msg = juce::MidiMessage::pitchWheel(ch, event.data1);
-        break;
-    case MidiEvent::Type::ChannelPressure:
-        msg = juce::MidiMessage::channelPressureChange(ch, event.data1);
-        break;
-    case MidiEvent::Type::KeyPressure:
-        msg = juce::MidiMessage::aftertouchChange(ch, event.data1, event.data2);
-        break;
-    }
+void VstPluginHost::onNoteOnAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset)
+{
+    enqueueAt(ctx, EncodedMidiMessage::noteOn(ctx.channel, note), sampleOffset);
+}
 
-    collector->addMessageToQueue(msg);
+void VstPluginHost::onNoteOffAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset)
+{
+    enqueueAt(ctx, EncodedMidiMessage::noteOff(ctx.channel, note), sampleOffset);
+}
+
+void VstPluginHost::onMidiEventAt(const PlaybackTrackContext& ctx, const MidiEvent& event, int sampleOffset)
+{
+    enqueueAt(ctx, EncodedMidiMessage::fromEvent(ctx.channel, event), sampleOffset);
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "../engine/EncodedMidiMessage.h"
+#include "../engine/MidiMessageQueue.h"
 #include "../engine/PlaybackListener.h"
+#include <cstdint>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <unordered_map>
@@ -21,6 +24,7 @@ public:
     void showEditor(int trackIndex);
 
     juce::String getPluginName(int trackIndex) const;
+    std::uint64_t getNumDroppedMessages() const;
 
     juce::AudioPluginFormatManager& getFormatManager() { return formatManager; }
 
@@ -28,14 +32,22 @@ public:
     void onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note) override;
     void onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event) override;
 
+    void onNoteOnAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset) override;
+    void onNoteOffAt(const PlaybackTrackContext& ctx, const MidiNote& note, int sampleOffset) override;
+    void onMidiEventAt(const PlaybackTrackContext& ctx, const MidiEvent& event, int sampleOffset) override;
+
 private:
-    juce::MidiMessageCollector* resolveCollector(const PlaybackTrackContext& ctx) const;
+    class MidiSourceProcessor;
+
+    MidiSourceProcessor* resolveSource(const PlaybackTrackContext& ctx) const;
+    void enqueue(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message);
+    void enqueueAt(const PlaybackTrackContext& ctx, const EncodedMidiMessage& message, int sampleOffset);
 
     juce::AudioPluginFormatManager formatManager;
     juce::AudioProcessorGraph* graph = nullptr;
     juce::AudioProcessorGraph::NodeID audioOutNodeId;
     std::unordered_map<int, juce::AudioProcessorGraph::NodeID> pluginNodes;
     std::unordered_map<int, juce::AudioProcessorGraph::NodeID> midiSourceNodes;
-    std::unordered_map<int, juce::MidiMessageCollector*> midiCollectors;
+    std::unordered_map<int, MidiSourceProcessor*> midiSources;
     std::unordered_map<int, std::unique_ptr<juce::DocumentWindow>> editorWindows;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal timing harness: one untimed warm-up run, then the median and best of a fixed number of runs.
+struct BenchResult
+{
+    std::string name;
+    int runs = 0;
+    double medianMs = 0.0;
+    double bestMs = 0.0;
+    double itemsPerRun = 0.0; // notes, conversions, steps... whatever the benchmark counts
+};
+
+template <typename Fn>
+double timeMs(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+inline BenchResult report(std::string name, std::vector<double> times, double itemsPerRun)
+{
+    std::ranges::sort(times);
+    BenchResult result{std::move(name), static_cast<int>(times.size()), times[times.size() / 2], times.front(),
+                       itemsPerRun};
+    std::printf("%-44s %10.3f ms %10.3f ms %12.2f M/s\n", result.name.c_str(), result.medianMs, result.bestMs,
+                result.itemsPerRun / (result.medianMs * 1000.0));
+    return result;
+}
+
+template <typename Fn>
+BenchResult measure(std::string name, int runs, double itemsPerRun, Fn&& fn)
+{
+    fn();
+
+    std::vector<double> times;
+    times.reserve(static_cast<std::size_t>(runs));
+    for (int i = 0; i < runs; ++i)
+        times.push_back(timeMs(fn));
+    return report(std::move(name), std::move(times), itemsPerRun);
+}
+
+// For steps that change state and can't be repeated, such as performing an undoable action.
+template <typename Fn>
+BenchResult measureOnce(std::string name, double items, Fn&& fn)
+{
+    return report(std::move(name), {timeMs(fn)}, items);
+}
@@ -0,0 +1,393 @@
+#include "../engine/PlaybackProcessor.h"
+#include "../engine/PlaybackSnapshot.h"
+#include "../io/MidiFileIO.h"
+#include "../model/EventListView.h"
+#include "../model/UndoActions.h"
+#include "Bench.h"
+#include "Workload.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+
+namespace
+{
+constexpr const char* usage =
+    "Usage: calliope-bench [--workload] [--tracks N] [--notes N] [--cc-per-beat N] [--pitch-bend]\n"
+    "                      [--tempo-changes N] [--signatures N] [--seed N] [--runs N] [--edit-notes N]\n"
+    "                      [--json file]\n"
+    "  Without --workload, runs the fixed micro-benchmarks. With it, generates one synthetic song from\n"
+    "  the given options and times loading, saving, playback, list building and undo on it.\n";
+
+// Every benchmark draws from its own fixed seed so runs are comparable across machines and commits.
+constexpr unsigned int seed = 20240601;
+
+class CountingSink : public PlaybackListener
+{
+public:
+    void onNoteOn(const PlaybackTrackContext&, const MidiNote&) override { ++count; }
+    void onNoteOff(const PlaybackTrackContext&, const MidiNote&) override { ++count; }
+    void onMidiEvent(const PlaybackTrackContext&, const MidiEvent&) override { ++count; }
+
+    long long count = 0;
+};
+
+long long countNotes(const MidiSequence& sequence)
+{
+    long long notes = 0;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+        notes += sequence.getTrack(t).getNumNotes();
+    return notes;
+}
+
+long long countEvents(const MidiSequence& sequence)
+{
+    long long events = 0;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+        events += sequence.getTrack(t).getNumEvents();
+    return events;
+}
+
+// Steps through the song from the start, stepTicks at a time, the way the clock advances it.
+void runProcessor(const PlaybackSnapshot& snapshot, int endTick, int stepTicks, CountingSink& sink)
+{
+    PlaybackProcessor processor;
+    processor.reserveScratchFor(snapshot);
+    processor.resetCursors(snapshot, 0);
+    for (int tick = 0; tick < endTick; tick += stepTicks)
+        processor.process(snapshot, tick, tick + stepTicks, sink);
+    processor.sendAllNoteOffs(sink);
+}
+
+void benchSnapshotBuild(std::vector<BenchResult>& results)
+{
+    MidiSequence sequence;
+    generateWorkload(sequence, {.numTracks = 16, .numNotes = 160000, .controllersPerBeat = 4, .seed = seed});
+    const double notes = 160000;
+
+    results.push_back(
+        measure("snapshot build (16 x 10k notes)", 20, notes, [&] { PlaybackSnapshot::build(sequence); }));
+
+    // Only the edited track is re-sorted when the previous snapshot is passed in.
+    const auto previous = PlaybackSnapshot::build(sequence);
+    results.push_back(measure("snapshot rebuild, one track edited", 20, 10000,
+                              [&]
+                              {
+                                  auto& track = sequence.getTrack(0);
+                                  track.removeNote(track.addNote({60, 100, 0, 120}));
+                                  PlaybackSnapshot::build(sequence, &previous);
+                              }));
+}
+
+void benchFileRoundTrip(std::vector<BenchResult>& results)
+{
+    MidiSequence sequence;
+    generateWorkload(sequence, {.numTracks = 16, .numNotes = 160000, .controllersPerBeat = 4, .seed = seed});
+    const auto file = juce::File::createTempFile(".mid");
+    const double notes = 160000;
+
+    results.push_back(
+        measure("MidiFileIO::save (16 x 10k notes)", 10, notes, [&] { MidiFileIO::save(sequence, file); }));
+    results.push_back(measure("MidiFileIO::load (16 x 10k notes)", 10, notes,
+                              [&]
+                              {
+                                  MidiSequence loaded;
+                                  MidiFileIO::load(loaded, file);
+                              }));
+    results.push_back(measure("MidiFileIO::load (16 x 10k notes, 1 thread)", 10, notes,
+                              [&]
+                              {
+                                  MidiSequence loaded;
+                                  MidiFileIO::load(loaded, file, 1);
+                              }));
+    file.deleteFile();
+}
+
+void benchTimingConversions(std::vector<BenchResult>& results)
+{
+    MidiSequence sequence;
+    generateWorkload(sequence, {.numTracks = 1,
+                                .numNotes = 20000,
+                                .numTempoChanges = 1000,
+                                .numTimeSignatureChanges = 200,
+                                .seed = seed});
+    const int endTick = sequence.getEndTick();
+    const int endBar = sequence.tickToBarBeatTick(endTick).bar;
+    constexpr int lookups = 100000;
+
+    std::mt19937 rng(seed + 2);
+    std::vector<int> ticks(lookups);
+    for (auto& tick : ticks)
+        tick = static_cast<int>(rng() % static_cast<unsigned int>(endTick));
+    const double endSeconds = sequence.ticksToSeconds(endTick);
+
+    volatile double sink = 0.0;
+    results.push_back(measure("ticksToSeconds (1000 tempo changes)", 20, lookups,
+                              [&]
+                              {
+                                  for (int tick : ticks)
+                                      sink = sink + sequence.ticksToSeconds(tick);
+                              }));
+    results.push_back(measure("secondsToTicks (1000 tempo changes)", 20, lookups,
+                              [&]
+                              {
+                                  for (int tick : ticks)
+                                      sink = sink + sequence.secondsToTicks(endSeconds * tick / endTick);
+                              }));
+    results.push_back(measure("tickToBarBeatTick (200 signatures)", 20, lookups,
+                              [&]
+                              {
+                                  for (int tick : ticks)
+                                      sink = sink + sequence.tickToBarBeatTick(tick).bar;
+                              }));
+    results.push_back(measure("barStartToTick (200 signatures)", 20, lookups,
+                              [&]
+                              {
+                                  for (int tick : ticks)
+                                      sink = sink + sequence.barStartToTick(tick % endBar + 1);
+                              }));
+}
+
+void benchProcessorThroughput(std::vector<BenchResult>& results)
+{
+    MidiSequence sequence;
+    generateWorkload(sequence, {.numTracks = 16, .numNotes = 160000, .controllersPerBeat = 4, .seed = seed});
+    const auto snapshot = PlaybackSnapshot::build(sequence);
+    const int endTick = sequence.getEndTick();
+
+    // One tick per step is the 1 ms clock at 120 bpm.
+    CountingSink sink;
+    results.push_back(measure("process full song (16 x 10k notes)", 5, endTick,
+                              [&] { runProcessor(snapshot, endTick, 1, sink); }));
+}
+
+// All notes overlap: they start one tick apart and each sounds for 2n ticks, so the active set
+// ramps up to n, holds, and drains one expiry per tick.
+void benchActiveNotes(std::vector<BenchResult>& results, int numNotes)
+{
+    MidiSequence sequence;
+    auto& track = sequence.addTrack();
+    for (int i = 0; i < numNotes; ++i)
+        track.addNote({36 + i % 60, 100, i, 2 * numNotes});
+    const auto snapshot = PlaybackSnapshot::build(sequence);
+    const int endTick = sequence.getEndTick() + 1;
+
+    CountingSink sink;
+    results.push_back(measure("process with " + std::to_string(numNotes) + " active notes", 10, endTick,
+                              [&] { runProcessor(snapshot, endTick, 1, sink); }));
+}
+
+void runMicroBenchmarks(std::vector<BenchResult>& results)
+{
+    benchSnapshotBuild(results);
+    benchFileRoundTrip(results);
+    benchTimingConversions(results);
+    benchProcessorThroughput(results);
+    for (int numNotes : {1000, 2000, 5000, 10000})
+        benchActiveNotes(results, numNotes);
+}
+
+void runWorkloadBenchmarks(std::vector<BenchResult>& results, const WorkloadSpec& spec, int runs, int editNotes)
+{
+    MidiSequence sequence;
+    results.push_back(
+        measureOnce("generate", static_cast<double>(spec.numNotes), [&] { generateWorkload(sequence, spec); }));
+
+    const double notes = static_cast<double>(countNotes(sequence));
+    const double items = notes + static_cast<double>(countEvents(sequence));
+    const int endTick = sequence.getEndTick();
+
+    const auto file = juce::File::createTempFile(".mid");
+    results.push_back(measure("MidiFileIO::save", runs, items, [&] { MidiFileIO::save(sequence, file); }));
+    results.push_back(measure("MidiFileIO::load", runs, items,
+                              [&]
+                              {
+                                  MidiSequence loaded;
+                                  MidiFileIO::load(loaded, file);
+                              }));
+    results.push_back(measure("MidiFileIO::load (1 thread)", runs, items,
+                              [&]
+                              {
+                                  MidiSequence loaded;
+                                  MidiFileIO::load(loaded, file, 1);
+                              }));
+    file.deleteFile();
+
+    results.push_back(measure("PlaybackSnapshot::build", runs, items, [&] { PlaybackSnapshot::build(sequence); }));
+
+    // A 512-sample block at 44.1 kHz and 120 bpm covers about 11 ticks; stepping per block keeps
+    // ten-million-note songs to a few seconds while still crossing every note and event.
+    const auto snapshot = PlaybackSnapshot::build(sequence);
+    CountingSink sink;
+    results.push_back(measure("PlaybackProcessor::process (full song)", runs, items,
+                              [&] { runProcessor(snapshot, endTick, 11, sink); }));
+
+    // The event list over every track: a full rebuild, then scrolling to random rows, seeking by tick
+    // and re-reading a bar of one track after an edit.
+    std::set<int> allTracks;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+        allTracks.insert(t);
+    EventListView view;
+    results.push_back(measure("EventListView::rebuild", runs, items, [&] { view.rebuild(sequence, allTracks); }));
+
+    constexpr int numLookups = 10000;
+    std::mt19937 lookupRng(seed + 3);
+    std::vector<int> lookupRows(numLookups);
+    std::vector<int> lookupTicks(numLookups);
+    for (auto& row : lookupRows)
+        row = static_cast<int>(lookupRng() % static_cast<unsigned int>(std::max(1, view.getNumRows())));
+    for (auto& tick : lookupTicks)
+        tick = static_cast<int>(lookupRng() % static_cast<unsigned int>(std::max(1, endTick)));
+    volatile long long lookupSink = 0;
+    results.push_back(measure("EventListView::getItem (random rows)", runs, numLookups,
+                              [&]
+                              {
+                                  for (int row : lookupRows)
+                                      lookupSink = lookupSink + view.getItem(sequence, row).tick;
+                              }));
+    results.push_back(measure("EventListView::countRowsBefore", runs, numLookups,
+                              [&]
+                              {
+                                  for (int tick : lookupTicks)
+                                      lookupSink = lookupSink + view.countRowsBefore(tick);
+                              }));
+    const int barTicks = 4 * sequence.getTicksPerQuarterNote();
+    results.push_back(measure("EventListView::patchNotes (one bar) + getItem", runs, 1,
+                              [&]
+                              {
+                                  view.patchNotes(sequence, 0, endTick / 2, endTick / 2 + barTicks);
+                                  lookupSink = lookupSink + view.getItem(sequence, view.getNumRows() / 2).tick;
+                              }));
+
+    // The first editNotes notes in track order, moved up an octave and then deleted as one action each.
+    struct NoteRef
+    {
+        int trackIndex;
+        NoteId noteId;
+    };
+    std::vector<NoteRef> refs;
+    std::vector<NoteModification> mods;
+    for (int t = 0; t < sequence.getNumTracks() && std::ssize(refs) < editNotes; ++t)
+    {
+        const auto& track = sequence.getTrack(t);
+        for (int slot = 0; slot < track.getNumNotes() && std::ssize(refs) < editNotes; ++slot)
+        {
+            const auto id = track.getNoteId(slot);
+            auto moved = track.getNote(id);
+            moved.noteNumber = std::min(127, moved.noteNumber + 12);
+            refs.push_back({t, id});
+            mods.push_back({t, id, track.getNote(id), moved});
+        }
+    }
+
+    juce::UndoManager undoManager(0, 4);
+    const double numEdits = static_cast<double>(refs.size());
+    results.push_back(measureOnce("multi-note move perform", numEdits,
+                                  [&]
+                                  {
+                                      undoManager.beginNewTransaction();
+                                      undoManager.perform(new MultiNoteModifyAction(&sequence, mods));
+                                  }));
+    results.push_back(measure("multi-note move undo + redo", runs, 2 * numEdits,
+                              [&]
+                              {
+                                  undoManager.undo();
+                                  undoManager.redo();
+                              }));
+    results.push_back(measureOnce("multi-note delete perform", numEdits,
+                                  [&]
+                                  {
+                                      undoManager.beginNewTransaction();
+                                      undoManager.perform(new MultiNoteDeleteAction(&sequence, refs));
+                                  }));
+    results.push_back(measure("multi-note delete undo + redo", runs, 2 * numEdits,
+                              [&]
+                              {
+                                  undoManager.undo();
+                                  undoManager.redo();
+                              }));
+}
+
+juce::var toJson(const std::vector<BenchResult>& results)
+{
+    juce::Array<juce::var> list;
+    for (const auto& r : results)
+    {
+        juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+        entry->setProperty("name", juce::String(r.name));
+        entry->setProperty("runs", r.runs);
+        entry->setProperty("medianMs", r.medianMs);
+        entry->setProperty("bestMs", r.bestMs);
+        entry->setProperty("items", r.itemsPerRun);
+        entry->setProperty("itemsPerSecond", r.medianMs > 0.0 ? r.itemsPerRun * 1000.0 / r.medianMs : 0.0);
+        list.add(juce::var(entry.get()));
+    }
+    return list;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    const auto intOption = [&](const char* option, long long fallback)
+    { return args.containsOption(option) ? args.getValueForOption(option).getLargeIntValue() : fallback; };
+
+    juce::DynamicObject::Ptr output = new juce::DynamicObject();
+    std::vector<BenchResult> results;
+    std::printf("%-44s %13s %13s %14s\n", "benchmark", "median", "best", "throughput");
+
+    if (args.containsOption("--workload"))
+    {
+        const WorkloadSpec defaults;
+        WorkloadSpec spec;
+        spec.numTracks = static_cast<int>(std::clamp(intOption("--tracks", defaults.numTracks), 1LL,
+                                                     static_cast<long long>(WorkloadSpec::maxTracks)));
+        spec.numNotes = std::clamp(intOption("--notes", defaults.numNotes), 0LL, WorkloadSpec::maxNotes);
+        spec.controllersPerBeat = static_cast<int>(std::max(0LL, intOption("--cc-per-beat", 0)));
+        spec.pitchBend = args.containsOption("--pitch-bend");
+        spec.numTempoChanges = static_cast<int>(std::max(1LL, intOption("--tempo-changes", 1)));
+        spec.numTimeSignatureChanges = static_cast<int>(std::max(1LL, intOption("--signatures", 1)));
+        spec.seed = static_cast<unsigned int>(intOption("--seed", defaults.seed));
+        const int runs = static_cast<int>(std::max(1LL, intOption("--runs", 3)));
+        const int editNotes = static_cast<int>(std::max(1LL, intOption("--edit-notes", 100000)));
+
+        runWorkloadBenchmarks(results, spec, runs, editNotes);
+
+        juce::DynamicObject::Ptr workload = new juce::DynamicObject();
+        workload->setProperty("tracks", spec.numTracks);
+        workload->setProperty("notes", static_cast<juce::int64>(spec.numNotes));
+        workload->setProperty("controllersPerBeat", spec.controllersPerBeat);
+        workload->setProperty("pitchBend", spec.pitchBend);
+        workload->setProperty("tempoChanges", spec.numTempoChanges);
+        workload->setProperty("timeSignatureChanges", spec.numTimeSignatureChanges);
+        workload->setProperty("seed", static_cast<juce::int64>(spec.seed));
+        workload->setProperty("editNotes", editNotes);
+        output->setProperty("suite", "workload");
+        output->setProperty("workload", juce::var(workload.get()));
+    }
+    else
+    {
+        runMicroBenchmarks(results);
+        output->setProperty("suite", "micro");
+    }
+
+    output->setProperty("results", toJson(results));
+
+    if (args.containsOption("--json"))
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--json"));
+        if (!file.replaceWithText(juce::JSON::toString(juce::var(output.get()))))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "Workload.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+
+namespace
+{
+int addNotes(MidiTrack& track, long long numNotes, int ppq, std::mt19937& rng)
+{
+    // Chords of one to four notes, each step 1/8 to 5/8 of a beat after the last: about 70 ticks per
+    // note at 480 PPQ, which keeps ten million notes on a single track inside the int tick range.
+    int tick = 0;
+    for (long long added = 0; added < numNotes;)
+    {
+        const auto chordSize = std::min<long long>(1 + rng() % 4, numNotes - added);
+        for (long long i = 0; i < chordSize; ++i, ++added)
+            track.addNote({static_cast<int>(36 + rng() % 60), static_cast<int>(1 + rng() % 127), tick,
+                           static_cast<int>(ppq / 8 + rng() % static_cast<unsigned int>(ppq * 2))});
+        tick += static_cast<int>(ppq / 8 + rng() % static_cast<unsigned int>(ppq / 2));
+    }
+    return tick;
+}
+
+void addControllerStreams(MidiTrack& track, const WorkloadSpec& spec, int endTick, int ppq)
+{
+    if (spec.controllersPerBeat <= 0)
+        return;
+
+    const int step = std::max(1, ppq / spec.controllersPerBeat);
+    for (int tick = 0; tick < endTick; tick += step)
+    {
+        // One slow sweep every four bars of 4/4, so consecutive values differ like a recorded wheel.
+        const double phase = std::sin(2.0 * std::numbers::pi * tick / (ppq * 16));
+        track.addEvent({MidiEvent::Type::ControlChange, tick, 1, static_cast<int>(std::lround(63.5 + 63.5 * phase))});
+        if (spec.pitchBend)
+            track.addEvent({MidiEvent::Type::PitchBend, tick, static_cast<int>(std::lround(8192 + 8191 * phase)), 0});
+    }
+}
+
+void addTimeline(MidiSequence& sequence, const WorkloadSpec& spec, int endTick, std::mt19937& rng)
+{
+    const int ppq = sequence.getTicksPerQuarterNote();
+
+    std::vector<TempoChange> tempos{{0, 120.0}};
+    for (int i = 1; i < spec.numTempoChanges; ++i)
+        tempos.push_back({static_cast<int>(static_cast<long long>(endTick) * i / spec.numTempoChanges),
+                          60.0 + rng() % 120});
+    sequence.setTempoChanges(std::move(tempos));
+
+    // Signature changes have to land on bar lines, so each one is rounded to whole bars of the last; with
+    // more changes than bars in the song, the extra ones run on past its end.
+    std::vector<TimeSignatureChange> signatures{{0, 4, 4}};
+    const int spacing = endTick / std::max(1, spec.numTimeSignatureChanges);
+    for (int i = 1; i < spec.numTimeSignatureChanges; ++i)
+    {
+        const auto& last = signatures.back();
+        const int ticksPerBar = last.numerator * ppq * 4 / last.denominator;
+        const int bars = std::max(1, spacing / ticksPerBar);
+        signatures.push_back({last.tick + bars * ticksPerBar, static_cast<int>(2 + rng() % 6), rng() % 2 ? 4 : 8});
+    }
+    sequence.setTimeSignatureChanges(std::move(signatures));
+}
+} // namespace
+
+void generateWorkload(MidiSequence& sequence, const WorkloadSpec& spec)
+{
+    sequence.clear();
+    std::mt19937 rng(spec.seed);
+
+    const int ppq = sequence.getTicksPerQuarterNote();
+    const int numTracks = std::clamp(spec.numTracks, 1, WorkloadSpec::maxTracks);
+    const long long numNotes = std::clamp(spec.numNotes, 0LL, WorkloadSpec::maxNotes);
+
+    int endTick = ppq * 4;
+    for (int t = 0; t < numTracks; ++t)
+    {
+        auto& track = sequence.addTrack();
+        track.setName("Track " + std::to_string(t + 1));
+        track.setChannel(t % 16 + 1);
+
+        const long long notesForTrack = numNotes / numTracks + (t < numNotes % numTracks ? 1 : 0);
+        const int trackEnd = addNotes(track, notesForTrack, ppq, rng) + ppq * 2;
+        addControllerStreams(track, spec, trackEnd, ppq);
+        endTick = std::max(endTick, trackEnd);
+    }
+
+    addTimeline(sequence, spec, endTick, rng);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../model/MidiSequence.h"
+
+// Shape of a synthetic song. Everything is derived from seed, so the same spec always produces the
+// same sequence.
+struct WorkloadSpec
+{
+    int numTracks = 16;
+    long long numNotes = 100000; // spread evenly over the tracks
+    int controllersPerBeat = 0;  // CC 1 stream on every track; 0 for none
+    bool pitchBend = false;      // a pitch bend stream at the same density as the controllers
+    int numTempoChanges = 1;
+    int numTimeSignatureChanges = 1;
+    unsigned int seed = 20240601;
+
+    static constexpr int maxTracks = 1000;
+    static constexpr long long maxNotes = 10000000;
+};
+
+void generateWorkload(MidiSequence& sequence, const WorkloadSpec& spec);
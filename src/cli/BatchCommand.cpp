@@ -0,0 +1,317 @@
+#include "BatchCommand.h"
+#include "../io/MidiFileIO.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+namespace
+{
+constexpr const char* usage =
+    "Usage: calliope-batch <stats | normalize | resave | events> <file.mid | dir>... [--out dir] [--threads N]\n"
+    "  stats      print a summary of each file\n"
+    "  normalize  rewrite format 0 files as format 1, one track per channel, into --out\n"
+    "  resave     load and save every file into --out\n"
+    "  events     write an event list per file into --out, or to stdout without --out\n";
+
+enum class Action
+{
+    Stats,
+    Normalize,
+    Resave,
+    Events
+};
+
+// An input file and its path below the directory argument it was found in, or just its name when
+// it was named directly. Outputs keep that path, so same-named files in different subdirectories
+// don't overwrite each other.
+struct Input
+{
+    juce::File file;
+    juce::String relativePath;
+};
+
+struct FileResult
+{
+    bool ok = false;
+    juce::String text;
+    juce::int64 bytes = 0;
+    int notes = 0;
+};
+
+int readFormat(const juce::File& file)
+{
+    juce::FileInputStream in(file);
+    char header[10] = {};
+    if (!in.openedOk() || in.read(header, sizeof(header)) != static_cast<int>(sizeof(header)) ||
+        std::memcmp(header, "MThd", 4) != 0)
+        return -1;
+    return (static_cast<juce::uint8>(header[8]) << 8) | static_cast<juce::uint8>(header[9]);
+}
+
+int countNotes(const MidiSequence& sequence)
+{
+    int notes = 0;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+        notes += sequence.getTrack(t).getNumNotes();
+    return notes;
+}
+
+juce::String formatPosition(const MidiSequence& sequence, int tick)
+{
+    const auto bbt = sequence.tickToBarBeatTick(tick);
+    return juce::String(bbt.bar).paddedLeft('0', 3) + "." + juce::String(bbt.beat).paddedLeft('0', 2) + "." +
+           juce::String(bbt.tick).paddedLeft('0', 4);
+}
+
+juce::String formatEvent(const MidiEvent& event)
+{
+    switch (event.type)
+    {
+    case MidiEvent::Type::ControlChange:
+        return "CC " + juce::String(event.data1) + " = " + juce::String(event.data2);
+    case MidiEvent::Type::ProgramChange:
+        return "Program " + juce::String(event.data1);
+    case MidiEvent::Type::PitchBend:
+        return "Pitch bend " + juce::String(event.data1);
+    case MidiEvent::Type::ChannelPressure:
+        return "Channel pressure " + juce::String(event.data1);
+    case MidiEvent::Type::KeyPressure:
+        return "Key pressure " + juce::MidiMessage::getMidiNoteName(event.data1, true, true, 4) + " = " +
+               juce::String(event.data2);
+    }
+    return {};
+}
+
+juce::String describe(const juce::File& file, int format, const MidiSequence& sequence)
+{
+    int events = 0;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+        events += sequence.getTrack(t).getNumEvents();
+
+    const int endTick = sequence.getEndTick();
+    return file.getFileName() + ": format " + juce::String(format) + ", " + juce::String(sequence.getNumTracks()) +
+           " tracks, " + juce::String(countNotes(sequence)) + " notes, " + juce::String(events) + " events, " +
+           juce::String(sequence.getTempoChanges().size()) + " tempo changes, PPQ " +
+           juce::String(sequence.getTicksPerQuarterNote()) + ", " +
+           juce::String(sequence.tickToBarBeatTick(endTick).bar) + " bars, " +
+           juce::String(sequence.ticksToSeconds(endTick), 2) + " s";
+}
+
+juce::String listEvents(const MidiSequence& sequence)
+{
+    juce::String text;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+    {
+        const auto& track = sequence.getTrack(t);
+        text << "Track " << (t + 1) << " \"" << juce::String(track.getName()) << "\" (channel " << track.getChannel()
+             << ")\n";
+
+        const auto noteView = track.getNotes();
+        std::vector<MidiNote> notes(noteView.begin(), noteView.end());
+        std::ranges::stable_sort(notes, {}, &MidiNote::startTick);
+        auto events = track.getEvents();
+        std::ranges::stable_sort(events, {}, &MidiEvent::tick);
+
+        // Two sorted runs merged by tick, notes first on ties.
+        auto note = notes.begin();
+        auto event = events.begin();
+        while (note != notes.end() || event != events.end())
+        {
+            if (event == events.end() || (note != notes.end() && note->startTick <= event->tick))
+            {
+                text << formatPosition(sequence, note->startTick) << "  Note "
+                     << juce::MidiMessage::getMidiNoteName(note->noteNumber, true, true, 4) << " vel "
+                     << note->velocity << " len " << note->duration << "\n";
+                ++note;
+            }
+            else
+            {
+                text << formatPosition(sequence, event->tick) << "  " << formatEvent(*event) << "\n";
+                ++event;
+            }
+        }
+    }
+    return text;
+}
+
+juce::File outputFileFor(Action action, const Input& input, const juce::File& outDir)
+{
+    const auto target = outDir.getChildFile(input.relativePath);
+    return action == Action::Events ? target.withFileExtension(".txt") : target;
+}
+
+FileResult processFile(Action action, const Input& input, const juce::File& outDir, int loadThreads)
+{
+    const auto& file = input.file;
+    FileResult result;
+    result.bytes = file.getSize();
+
+    const int format = readFormat(file);
+    MidiSequence sequence;
+    if (!MidiFileIO::load(sequence, file, loadThreads))
+    {
+        result.text = file.getFileName() + ": could not read";
+        return result;
+    }
+    result.notes = countNotes(sequence);
+    result.ok = true;
+
+    switch (action)
+    {
+    case Action::Stats:
+        result.text = describe(file, format, sequence);
+        break;
+    case Action::Normalize:
+        if (format != 0)
+        {
+            result.text = file.getFileName() + ": format " + juce::String(format) + ", left as is";
+            break;
+        }
+        [[fallthrough]];
+    case Action::Resave:
+    {
+        const auto target = outputFileFor(action, input, outDir);
+        result.ok = target.getParentDirectory().createDirectory() && MidiFileIO::save(sequence, target);
+        result.text = file.getFileName() + (result.ok ? " -> " + target.getFullPathName() : ": could not write");
+        break;
+    }
+    case Action::Events:
+        if (outDir == juce::File())
+        {
+            result.text = "== " + file.getFileName() + "\n" + listEvents(sequence);
+        }
+        else
+        {
+            const auto target = outputFileFor(action, input, outDir);
+            result.ok =
+                target.getParentDirectory().createDirectory() && target.replaceWithText(listEvents(sequence));
+            result.text = file.getFileName() + (result.ok ? " -> " + target.getFullPathName() : ": could not write");
+        }
+        break;
+    }
+    return result;
+}
+} // namespace
+
+int BatchCommand::run(const juce::ArgumentList& args)
+{
+    static const std::pair<const char*, Action> actions[] = {
+        {"stats", Action::Stats}, {"normalize", Action::Normalize}, {"resave", Action::Resave}, {"events", Action::Events}};
+
+    const auto* action = args.size() > 0 ? std::ranges::find_if(actions, [&](const auto& a)
+                                                                { return args[0].text == a.first; })
+                                         : std::end(actions);
+    if (action == std::end(actions))
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    juce::File outDir;
+    if (args.containsOption("--out"))
+        outDir = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--out"));
+    if (outDir == juce::File() && (action->second == Action::Normalize || action->second == Action::Resave))
+    {
+        std::cerr << "--out is required for " << action->first << "\n";
+        return 1;
+    }
+    if (outDir != juce::File() && !outDir.createDirectory())
+    {
+        std::cerr << "Could not create " << outDir.getFullPathName() << "\n";
+        return 1;
+    }
+
+    std::vector<Input> inputs;
+    for (int i = 1; i < args.size(); ++i)
+    {
+        if (args[i].isOption())
+        {
+            ++i; // skip the option's value
+            continue;
+        }
+        const auto path = args[i].resolveAsFile();
+        if (path.isDirectory())
+        {
+            auto found = path.findChildFiles(juce::File::findFiles, true, "*.mid;*.midi");
+            found.sort();
+            for (const auto& file : found)
+                inputs.push_back({file, file.getRelativePathFrom(path)});
+        }
+        else
+        {
+            inputs.push_back({path, path.getFileName()});
+        }
+    }
+    if (inputs.empty())
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    // Jobs run concurrently, so inputs bound for the same output file are refused before anything is
+    // written. Paths are compared ignoring case, as some file systems do.
+    if (outDir != juce::File())
+    {
+        std::map<juce::String, const Input*> targets;
+        for (const auto& input : inputs)
+        {
+            const auto key = outputFileFor(action->second, input, outDir).getFullPathName().toLowerCase();
+            if (const auto [it, added] = targets.emplace(key, &input); !added)
+            {
+                std::cerr << input.file.getFullPathName() << " and " << it->second->file.getFullPathName()
+                          << " would be written to the same file\n";
+                return 1;
+            }
+        }
+    }
+    const int numInputs = static_cast<int>(inputs.size());
+
+    int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue() : 0;
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+    // With several files the pool already keeps every thread busy, so each file is decoded on its own
+    // worker; a single file gets the threads for its track chunks instead.
+    const int loadThreads = numInputs == 1 ? numThreads : 1;
+    numThreads = std::min(numThreads, numInputs);
+
+    // One file per job; results are printed in input order once everything has finished.
+    std::vector<FileResult> results(inputs.size());
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    {
+        std::atomic<int> remaining{numInputs};
+        juce::WaitableEvent finished;
+        juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("Batch").withNumberOfThreads(numThreads));
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+        {
+            pool.addJob(
+                [&, i]
+                {
+                    results[i] = processFile(action->second, inputs[i], outDir, loadThreads);
+                    if (--remaining == 0)
+                        finished.signal();
+                });
+        }
+        finished.wait();
+    }
+    const double elapsedSeconds = juce::jmax((juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0, 0.001);
+
+    int failures = 0;
+    juce::int64 bytes = 0;
+    juce::int64 notes = 0;
+    for (const auto& result : results)
+    {
+        (result.ok ? std::cout : std::cerr) << result.text << "\n";
+        failures += result.ok ? 0 : 1;
+        bytes += result.bytes;
+        notes += result.notes;
+    }
+
+    std::cerr << numInputs << " files, " << juce::String(bytes / 1048576.0, 2) << " MB, " << notes
+              << " notes in " << juce::String(elapsedSeconds, 3) << " s on " << numThreads << " threads: "
+              << juce::String(numInputs / elapsedSeconds, 1) << " files/s, "
+              << juce::String(bytes / 1048576.0 / elapsedSeconds, 2) << " MB/s, "
+              << juce::String(notes / elapsedSeconds, 0) << " notes/s\n";
+    return failures == 0 ? 0 : 1;
+}
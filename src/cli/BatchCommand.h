@@ -0,0 +1,12 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Console batch analysis and conversion of MIDI files. Built into calliope-batch, which links the
+// model, IO and engine code without juce_gui_*, so it runs on machines without a display.
+class BatchCommand
+{
+public:
+    // Returns the process exit code.
+    static int run(const juce::ArgumentList& args);
+};
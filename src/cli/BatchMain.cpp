@@ -0,0 +1,6 @@
+#include "BatchCommand.h"
+
+int main(int argc, char* argv[])
+{
+    return BatchCommand::run(juce::ArgumentList(argc, argv));
+}
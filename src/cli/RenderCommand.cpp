@@ -0,0 +1,189 @@
+#include "RenderCommand.h"
+#include "../audio/OfflineRenderer.h"
+#include "../audio/StemRenderer.h"
+#include "../audio/VstPluginHost.h"
+#include "../io/MidiFileIO.h"
+#include <iostream>
+
+namespace
+{
+constexpr const char* usage =
+    "Usage: Calliope --render <input.mid | input-dir> <output.wav | output.flac | output-dir> --plugin <file>\n"
+    "         [--format wav|flac] [--sample-rate 44100] [--block-size 512] [--bits 24]\n"
+    "         [--start-tick 0] [--end-tick N] [--loops 1] [--tail 2.0] [--stems [--threads N]]\n"
+    "With --stems the output is a directory that receives one file per track plus the mix.\n";
+
+struct RenderSettings
+{
+    juce::File plugin;
+    OfflineRenderer::Options options;
+    juce::String extension;
+    bool stems = false;
+    int numThreads = 0;
+};
+
+int intOption(const juce::ArgumentList& list, const char* option, int fallback)
+{
+    return list.containsOption(option) ? list.getValueForOption(option).getIntValue() : fallback;
+}
+
+double doubleOption(const juce::ArgumentList& list, const char* option, double fallback)
+{
+    return list.containsOption(option) ? list.getValueForOption(option).getDoubleValue() : fallback;
+}
+
+// Routes every track that has something to play to a plugin instance of its own.
+std::vector<int> routeTracksToOwnPlugins(MidiSequence& sequence)
+{
+    std::vector<int> routed;
+    for (int t = 0; t < sequence.getNumTracks(); ++t)
+    {
+        auto& track = sequence.getTrack(t);
+        if (track.getNumNotes() == 0 && track.getNumEvents() == 0)
+            continue;
+        track.setOutputDestination(MidiTrack::OutputDestination::Plugin);
+        track.setRouteTargetTrackIndex(-1);
+        routed.push_back(t);
+    }
+    return routed;
+}
+
+bool renderMix(MidiSequence& sequence, const juce::File& output, const RenderSettings& settings)
+{
+    const auto& options = settings.options;
+    juce::AudioProcessorGraph graph;
+    graph.setPlayConfigDetails(0, options.numChannels, options.sampleRate, options.blockSize);
+    VstPluginHost host;
+    host.prepare(graph);
+
+    for (int t : routeTracksToOwnPlugins(sequence))
+    {
+        if (!host.attachPlugin(t, settings.plugin))
+        {
+            std::cerr << "Could not load plugin " << settings.plugin.getFullPathName() << "\n";
+            return false;
+        }
+    }
+
+    OfflineRenderer renderer(sequence, graph, host);
+    return renderer.render(output, options);
+}
+
+bool renderStems(MidiSequence& sequence, const juce::File& outputDir, const juce::String& baseName,
+                 const RenderSettings& settings)
+{
+    const auto& options = settings.options;
+    juce::AudioPluginFormatManager formatManager;
+    juce::addDefaultFormatsToManager(formatManager);
+
+    juce::OwnedArray<juce::PluginDescription> descriptions;
+    for (int i = 0; i < formatManager.getNumFormats(); ++i)
+        formatManager.getFormat(i)->findAllTypesForFile(descriptions, settings.plugin.getFullPathName());
+    if (descriptions.isEmpty())
+    {
+        std::cerr << "Could not load plugin " << settings.plugin.getFullPathName() << "\n";
+        return false;
+    }
+
+    StemRenderer renderer(sequence);
+    for (int t : routeTracksToOwnPlugins(sequence))
+    {
+        juce::String error;
+        auto instance =
+            formatManager.createPluginInstance(*descriptions[0], options.sampleRate, options.blockSize, error);
+        if (instance == nullptr)
+        {
+            std::cerr << "Could not load plugin " << settings.plugin.getFullPathName() << ": " << error << "\n";
+            return false;
+        }
+        renderer.setTrackPlugin(t, std::move(instance));
+    }
+
+    return renderer.render(outputDir, baseName, settings.extension, options, settings.numThreads);
+}
+
+bool renderFile(const juce::File& input, const juce::File& output, const RenderSettings& settings)
+{
+    MidiSequence sequence;
+    if (!MidiFileIO::load(sequence, input))
+    {
+        std::cerr << "Could not read " << input.getFullPathName() << "\n";
+        return false;
+    }
+
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    const bool rendered = settings.stems
+                              ? renderStems(sequence, output, input.getFileNameWithoutExtension(), settings)
+                              : renderMix(sequence, output, settings);
+    if (!rendered)
+    {
+        std::cerr << "Could not render " << input.getFullPathName() << " to " << output.getFullPathName() << "\n";
+        return false;
+    }
+    const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0;
+
+    const double audioSeconds = OfflineRenderer::getRenderedSeconds(sequence, settings.options);
+    std::cout << input.getFileName() << " -> " << output.getFullPathName() << " ("
+              << juce::String(audioSeconds, 1) << " s in " << juce::String(elapsedSeconds, 2) << " s, "
+              << juce::String(audioSeconds / juce::jmax(elapsedSeconds, 0.001), 1) << "x realtime)\n";
+    return true;
+}
+} // namespace
+
+bool RenderCommand::isRequested(const juce::StringArray& args)
+{
+    return args.contains("--render");
+}
+
+int RenderCommand::run(const juce::StringArray& args)
+{
+    const juce::ArgumentList list("Calliope", args);
+    const int renderIndex = list.indexOfOption("--render");
+    if (renderIndex < 0 || renderIndex + 2 >= list.size() || !list.containsOption("--plugin"))
+    {
+        std::cerr << usage;
+        return 1;
+    }
+
+    const auto input = list.arguments[renderIndex + 1].resolveAsFile();
+    const auto output = list.arguments[renderIndex + 2].resolveAsFile();
+
+    RenderSettings settings;
+    settings.plugin = juce::File::getCurrentWorkingDirectory().getChildFile(list.getValueForOption("--plugin"));
+    settings.stems = list.containsOption("--stems");
+    settings.numThreads = intOption(list, "--threads", 0);
+    settings.extension = "." + (list.containsOption("--format") ? list.getValueForOption("--format") : "wav");
+
+    auto& options = settings.options;
+    options.sampleRate = doubleOption(list, "--sample-rate", options.sampleRate);
+    options.blockSize = intOption(list, "--block-size", options.blockSize);
+    options.bitsPerSample = intOption(list, "--bits", options.bitsPerSample);
+    options.startTick = intOption(list, "--start-tick", options.startTick);
+    options.endTick = intOption(list, "--end-tick", options.endTick);
+    options.loopCount = juce::jmax(1, intOption(list, "--loops", options.loopCount));
+    options.tailSeconds = doubleOption(list, "--tail", options.tailSeconds);
+
+    if (!input.isDirectory())
+        return renderFile(input, output, settings) ? 0 : 1;
+
+    if (!output.createDirectory())
+    {
+        std::cerr << "Could not create " << output.getFullPathName() << "\n";
+        return 1;
+    }
+
+    auto inputs = input.findChildFiles(juce::File::findFiles, false, "*.mid;*.midi");
+    inputs.sort();
+
+    int failures = 0;
+    for (const auto& file : inputs)
+    {
+        const auto target =
+            settings.stems ? output : output.getChildFile(file.getFileNameWithoutExtension() + settings.extension);
+        if (!renderFile(file, target, settings))
+            ++failures;
+    }
+
+    std::cout << inputs.size() - failures << " of " << inputs.size() << " files rendered\n";
+    return failures == 0 ? 0 : 1;
+}
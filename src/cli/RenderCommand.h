@@ -0,0 +1,13 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Handles `Calliope --render <input.mid | dir> <output.wav | .flac | dir> --plugin <file> [options]`
+// without opening a window, so a build box can batch-render MIDI files.
+class RenderCommand
+{
+public:
+    static bool isRequested(const juce::StringArray& args);
+    // Returns the process exit code.
+    static int run(const juce::StringArray& args);
+};
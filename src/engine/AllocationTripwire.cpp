@@ -0,0 +1,201 @@
+#include "AllocationTripwire.h"
+
+#if JUCE_DEBUG
+
+#include <cstdlib>
+#include <new>
+#if JUCE_WINDOWS
+#include <malloc.h>
+#endif
+
+namespace
+{
+thread_local int tripwireDepth = 0;
+thread_local int tripCount = 0;
+
+void checkRealtimeAllocation()
+{
+    if (tripwireDepth == 0)
+        return;
+
+    // Disarm while reporting so the assertion's own logging can allocate.
+    ++tripCount;
+    const int depth = tripwireDepth;
+    tripwireDepth = 0;
+    jassertfalse; // the realtime playback callback hit the heap
+    tripwireDepth = depth;
+}
+
+void* allocate(std::size_t size)
+{
+    checkRealtimeAllocation();
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    checkRealtimeAllocation();
+#if JUCE_WINDOWS
+    if (auto* p = _aligned_malloc(size == 0 ? 1 : size, static_cast<std::size_t>(alignment)))
+        return p;
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, static_cast<std::size_t>(alignment), size == 0 ? 1 : size) == 0)
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void release(void* p) noexcept
+{
+    if (p != nullptr)
+        checkRealtimeAllocation();
+    std::free(p);
+}
+
+void releaseAligned(void* p) noexcept
+{
+    if (p != nullptr)
+        checkRealtimeAllocation();
+#if JUCE_WINDOWS
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+ScopedAllocationTripwire::ScopedAllocationTripwire()
+{
+    ++tripwireDepth;
+}
+
+ScopedAllocationTripwire::~ScopedAllocationTripwire()
+{
+    --tripwireDepth;
+}
+
+int ScopedAllocationTripwire::getNumTrips()
+{
+    return tripCount;
+}
+
+// Every replaceable form is covered, so nothrow and over-aligned allocations trip the wire too and
+// each allocation is released by the matching deallocator.
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocateAligned(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return operator new(size, alignment, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    releaseAligned(p);
+}
+
+#endif
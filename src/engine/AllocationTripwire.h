@@ -0,0 +1,21 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// While an instance is alive, debug builds assert if the current thread touches the heap.
+// Release builds compile it away.
+class ScopedAllocationTripwire
+{
+public:
+#if JUCE_DEBUG
+    ScopedAllocationTripwire();
+    ~ScopedAllocationTripwire();
+
+    // Heap operations the tripwire has caught on the calling thread so far.
+    static int getNumTrips();
+#else
+    ScopedAllocationTripwire() = default;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedAllocationTripwire)
+};
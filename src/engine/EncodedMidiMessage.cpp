@@ -0,0 +1,48 @@
+#include "EncodedMidiMessage.h"
+#include <algorithm>
+
+namespace
+{
+std::uint8_t statusByte(int status, int channel)
+{
+    return static_cast<std::uint8_t>(status | (std::clamp(channel, 1, 16) - 1));
+}
+
+std::uint8_t dataByte(int value)
+{
+    return static_cast<std::uint8_t>(std::clamp(value, 0, 127));
+}
+} // namespace
+
+EncodedMidiMessage EncodedMidiMessage::noteOn(int channel, const MidiNote& note)
+{
+    return {{statusByte(0x90, channel), dataByte(note.noteNumber), dataByte(note.velocity)}, 3};
+}
+
+EncodedMidiMessage EncodedMidiMessage::noteOff(int channel, const MidiNote& note)
+{
+    return {{statusByte(0x80, channel), dataByte(note.noteNumber), 0}, 3};
+}
+
+EncodedMidiMessage EncodedMidiMessage::fromEvent(int channel, const MidiEvent& event)
+{
+    switch (event.type)
+    {
+    case MidiEvent::Type::ControlChange:
+        return {{statusByte(0xB0, channel), dataByte(event.data1), dataByte(event.data2)}, 3};
+    case MidiEvent::Type::ProgramChange:
+        return {{statusByte(0xC0, channel), dataByte(event.data1), 0}, 2};
+    case MidiEvent::Type::PitchBend:
+    {
+        const int value = std::clamp(event.data1, 0, 16383);
+        return {{statusByte(0xE0, channel), static_cast<std::uint8_t>(value & 0x7F),
+                 static_cast<std::uint8_t>((value >> 7) & 0x7F)},
+                3};
+    }
+    case MidiEvent::Type::ChannelPressure:
+        return {{statusByte(0xD0, channel), dataByte(event.data1), 0}, 2};
+    case MidiEvent::Type::KeyPressure:
+        return {{statusByte(0xA0, channel), dataByte(event.data1), dataByte(event.data2)}, 3};
+    }
+    return {};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../model/MidiEvent.h"
+#include "../model/MidiNote.h"
+#include <array>
+#include <cstdint>
+
+// Channel message encoded on the playback thread so sinks can forward raw bytes.
+struct EncodedMidiMessage
+{
+    std::array<std::uint8_t, 3> bytes{};
+    int size = 0;
+
+    bool isNoteOff() const { return (bytes[0] & 0xF0) == 0x80 || ((bytes[0] & 0xF0) == 0x90 && bytes[2] == 0); }
+    int getChannel() const { return (bytes[0] & 0x0F) + 1; }
+
+    static EncodedMidiMessage noteOn(int channel, const MidiNote& note);
+    static EncodedMidiMessage noteOff(int channel, const MidiNote& note);
+    static EncodedMidiMessage fromEvent(int channel, const MidiEvent& event);
+};
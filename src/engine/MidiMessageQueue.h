@@ -0,0 +1,45 @@
+#pragma once
+
+#include "EncodedMidiMessage.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer queue of channel messages that never loses a note-off quietly.
+// Everything but note-offs leaves a quarter of the slots free, so under overload the note-ons are
+// dropped first. If a note-off is dropped all the same, the next drain ends with all-notes-off on
+// its channel.
+class MidiMessageQueue
+{
+public:
+    explicit MidiMessageQueue(int capacity) : queue(capacity), noteOffHeadroom(capacity / 4) {}
+
+    void push(const EncodedMidiMessage& message)
+    {
+        if (!message.isNoteOff())
+            queue.push(message, noteOffHeadroom);
+        else if (!queue.push(message))
+            lostNoteOffChannels.fetch_or(1u << (message.getChannel() - 1), std::memory_order_release);
+    }
+
+    // silenceChannel(channel) runs after the drained messages for every channel that lost a note-off.
+    // The lost channels are collected before draining, so the note-on the lost note-off belonged to
+    // has already gone out when the channel is silenced.
+    template <typename Fn, typename SilenceFn>
+    int drain(Fn&& fn, SilenceFn&& silenceChannel)
+    {
+        const auto lost = lostNoteOffChannels.exchange(0, std::memory_order_acquire);
+        const int drained = queue.drain(fn);
+        for (int ch = 1; ch <= 16; ++ch)
+            if ((lost & (1u << (ch - 1))) != 0)
+                silenceChannel(ch);
+        return drained;
+    }
+
+    std::uint64_t getNumDropped() const { return queue.getNumDropped(); }
+
+private:
+    SpscQueue<EncodedMidiMessage> queue;
+    const int noteOffHeadroom;
+    std::atomic<std::uint32_t> lostNoteOffChannels{0};
+};
@@ -0,0 +1,17 @@
+#include "PlaybackClock.h"
+
+void PlaybackClock::anchor(const TempoMap& map, double tick, double clockSeconds)
+{
+    anchorClockSeconds = clockSeconds;
+    anchorSongSeconds = map.ticksToSeconds(tick);
+}
+
+double PlaybackClock::tickAt(const TempoMap& map, double clockSeconds) const
+{
+    return map.secondsToTicks(anchorSongSeconds + (clockSeconds - anchorClockSeconds));
+}
+
+double PlaybackClock::clockSecondsAt(const TempoMap& map, double tick) const
+{
+    return anchorClockSeconds + (map.ticksToSeconds(tick) - anchorSongSeconds);
+}
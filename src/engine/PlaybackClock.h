@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../model/TempoMap.h"
+
+// Maps a monotonic clock onto song position through a tempo map. The position is always derived
+// from the clock time elapsed since the anchor instead of being accumulated per callback, so tempo
+// changes inside one callback interval and stalled callbacks don't make it drift.
+class PlaybackClock
+{
+public:
+    void anchor(const TempoMap& map, double tick, double clockSeconds);
+
+    double tickAt(const TempoMap& map, double clockSeconds) const;
+    double clockSecondsAt(const TempoMap& map, double tick) const;
+
+private:
+    double anchorClockSeconds = 0.0;
+    double anchorSongSeconds = 0.0;
+};
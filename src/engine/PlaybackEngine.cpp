@@ -1,4 +1,8 @@
 #include "PlaybackEngine.h"
+#include "AllocationTripwire.h"
+#include <cmath>
+#include <limits>
+#include <thread>
 
 namespace
 {
@@ -27,6 +31,64 @@ private:
 };
 } // namespace
 
+// Maps ticks inside the block being rendered to sample offsets and forwards events with them.
+class PlaybackEngine::BlockSink : public PlaybackListener
+{
+public:
+    BlockSink(const std::vector<PlaybackListener*>& l, const TempoMap& map, double startTick, double sampleRate,
+              int numSamples)
+        : listeners(l), tempoMap(map), originSeconds(map.ticksToSeconds(startTick)), sampleRate(sampleRate),
+          numSamples(numSamples)
+    {
+    }
+
+    // Goes through the tempo map, so events after a tempo change inside the block land on the right sample.
+    double sampleAt(double tick) const
+    {
+        return originSample + (tempoMap.ticksToSeconds(std::min(tick, limitTick)) - originSeconds) * sampleRate;
+    }
+
+    // Events past limitTick (e.g. note-offs flushed at a loop end) are pinned to that tick.
+    void limitTo(double tick) { limitTick = tick; }
+
+    void rebase(double tick, double sample)
+    {
+        originSeconds = tempoMap.ticksToSeconds(tick);
+        originSample = sample;
+        limitTick = std::numeric_limits<double>::max();
+    }
+
+    void onNoteOn(const PlaybackTrackContext& c, const MidiNote& n) override
+    {
+        const int offset = offsetFor(n.startTick);
+        for (auto* x : listeners)
+            x->onNoteOnAt(c, n, offset);
+    }
+    void onNoteOff(const PlaybackTrackContext& c, const MidiNote& n) override
+    {
+        const int offset = offsetFor(n.endTick());
+        for (auto* x : listeners)
+            x->onNoteOffAt(c, n, offset);
+    }
+    void onMidiEvent(const PlaybackTrackContext& c, const MidiEvent& e) override
+    {
+        const int offset = offsetFor(e.tick);
+        for (auto* x : listeners)
+            x->onMidiEventAt(c, e, offset);
+    }
+
+private:
+    int offsetFor(int tick) const { return juce::jlimit(0, numSamples - 1, static_cast<int>(sampleAt(tick))); }
+
+    const std::vector<PlaybackListener*>& listeners;
+    const TempoMap& tempoMap;
+    double originSeconds;
+    double originSample = 0.0;
+    double sampleRate;
+    double limitTick = std::numeric_limits<double>::max();
+    int numSamples;
+};
+
 PlaybackEngine::PlaybackEngine() = default;
 
 PlaybackEngine::~PlaybackEngine()
@@ -39,14 +101,14 @@ void PlaybackEngine::setSequence(const MidiSequence* seq)
     sequence = seq;
     if (sequence == nullptr)
     {
-        if (isTimerRunning())
-            stopTimer();
+        stopClock();
         playing = false;
         FanOut sink(listeners);
         processor.sendAllNoteOffs(sink);
         snapshot.store(nullptr);
         currentOwner.reset();
         lastSeenSnapshot.reset();
+        retiredSnapshots.clear();
         pendingSeekTick.store(-1);
         return;
     }
@@ -57,9 +119,44 @@ void PlaybackEngine::rebuildSnapshot()
 {
     if (sequence == nullptr)
         return;
-    auto fresh = std::make_shared<const PlaybackSnapshot>(PlaybackSnapshot::build(*sequence));
+    // Only tracks whose revision or context changed since the current snapshot are re-sorted.
+    auto fresh = std::make_shared<PlaybackSnapshot>(PlaybackSnapshot::build(*sequence, currentOwner.get()));
+
+    if (!processor.hasScratchFor(*fresh) || fresh->getNumTracks() > numReleaseFlags)
+    {
+        // Grow the processor here so the clock thread never allocates; only pauses the clock
+        // when an edit raises the peak polyphony or the track count.
+        const bool wasRunning = stopClock();
+        processor.reserveScratchFor(*fresh);
+        reserveReleaseFlags(fresh->getNumTracks());
+        if (wasRunning)
+            startClock();
+    }
+
+    retireSnapshot(std::move(currentOwner));
     currentOwner = fresh;
-    snapshot.store(fresh);
+    snapshot.store(std::move(fresh));
+}
+
+void PlaybackEngine::updateTrackAudibility()
+{
+    if (sequence == nullptr || currentOwner == nullptr)
+        return;
+    if (currentOwner->getNumTracks() != sequence->getNumTracks())
+    {
+        rebuildSnapshot();
+        return;
+    }
+    currentOwner->refreshAudibility(*sequence);
+}
+
+void PlaybackEngine::retireSnapshot(std::shared_ptr<const PlaybackSnapshot> old)
+{
+    // The clock thread may still hold the previous snapshot; keeping a reference here makes sure
+    // the last release, and the deallocation with it, happens on the message thread.
+    std::erase_if(retiredSnapshots, [](const auto& s) { return s.use_count() == 1; });
+    if (old)
+        retiredSnapshots.push_back(std::move(old));
 }
 
 void PlaybackEngine::play()
@@ -71,15 +168,63 @@ void PlaybackEngine::play()
 
     playing = true;
     lastSeenSnapshot.reset();
-    lastCallbackTimeMs = juce::Time::getMillisecondCounterHiRes();
+    anchorPending = true;
+    startClock();
+}
+
+void PlaybackEngine::startClock()
+{
+    if (clockSource.load() == ClockSource::AudioDevice)
+    {
+        audioClockRunning = true;
+        return;
+    }
     startTimer(1);
 }
 
-bool PlaybackEngine::suspendForStructuralChange()
+bool PlaybackEngine::stopClock()
 {
-    const bool wasRunning = isTimerRunning();
-    if (wasRunning)
+    if (isTimerRunning())
+    {
         stopTimer();
+        return true;
+    }
+    if (audioClockRunning.exchange(false))
+    {
+        // Pairs with ScopedAudioBlock: once this returns, no block is touching the processor and the
+        // last block's sample-stamped MIDI has been handed to the graph.
+        while (renderingBlock.load())
+            std::this_thread::yield();
+        return true;
+    }
+    return false;
+}
+
+bool PlaybackEngine::isClockRunning() const
+{
+    return isTimerRunning() || audioClockRunning.load();
+}
+
+void PlaybackEngine::setClockSource(ClockSource source)
+{
+    if (clockSource.load() == source)
+        return;
+
+    const bool wasRunning = stopClock();
+    clockSource.store(source);
+    anchorPending = true;
+    if (wasRunning)
+        startClock();
+}
+
+PlaybackEngine::ClockSource PlaybackEngine::getClockSource() const
+{
+    return clockSource.load();
+}
+
+bool PlaybackEngine::suspendForStructuralChange()
+{
+    const bool wasRunning = stopClock();
 
     FanOut sink(listeners);
     processor.sendAllNoteOffs(sink);
@@ -92,8 +237,8 @@ void PlaybackEngine::resumeAfterStructuralChange(bool wasRunning)
     if (wasRunning)
     {
         lastSeenSnapshot.reset();
-        lastCallbackTimeMs = juce::Time::getMillisecondCounterHiRes();
-        startTimer(1);
+        anchorPending = true;
+        startClock();
     }
 }
 
@@ -102,7 +247,7 @@ void PlaybackEngine::stop()
     if (!playing)
         return;
 
-    stopTimer();
+    stopClock();
     playing = false;
 
     FanOut sink(listeners);
@@ -187,66 +332,150 @@ void PlaybackEngine::removeListener(PlaybackListener* listener)
 
 void PlaybackEngine::releaseActiveNotesForTrack(int trackIndex)
 {
+    // While the clock runs the processor belongs to the clock thread, which applies the release
+    // at the start of its next callback. A track past the flags has never been in a snapshot, so it
+    // has no notes to release.
+    if (isClockRunning())
+    {
+        if (trackIndex >= 0 && trackIndex < numReleaseFlags)
+        {
+            releaseRequested[static_cast<std::size_t>(trackIndex)].store(true, std::memory_order_relaxed);
+            anyReleaseRequested.store(true, std::memory_order_release);
+        }
+        return;
+    }
     FanOut sink(listeners);
     processor.releaseActiveNotesForTrack(trackIndex, sink);
 }
 
-void PlaybackEngine::hiResTimerCallback()
+// Only called with the clock stopped. Flags never shrink, so every track index that has had notes
+// playing keeps one.
+void PlaybackEngine::reserveReleaseFlags(int numTracks)
 {
-    if (!playing)
+    if (numTracks <= numReleaseFlags)
         return;
+    auto grown = std::make_unique<std::atomic<bool>[]>(static_cast<std::size_t>(numTracks));
+    for (int t = 0; t < numReleaseFlags; ++t)
+        grown[static_cast<std::size_t>(t)].store(releaseRequested[static_cast<std::size_t>(t)].load());
+    releaseRequested = std::move(grown);
+    numReleaseFlags = numTracks;
+}
 
-    auto snap = snapshot.load();
-    if (!snap)
+void PlaybackEngine::applyPendingReleases(PlaybackListener& sink)
+{
+    if (!anyReleaseRequested.exchange(false, std::memory_order_acquire))
         return;
+    for (int t = 0; t < numReleaseFlags; ++t)
+        if (releaseRequested[static_cast<std::size_t>(t)].exchange(false, std::memory_order_relaxed))
+            processor.releaseActiveNotesForTrack(t, sink);
+}
 
-    FanOut sink(listeners);
+std::shared_ptr<const PlaybackSnapshot> PlaybackEngine::acquireSnapshot(PlaybackListener& sink, double clockSeconds)
+{
+    auto snap = snapshot.load();
+    if (!snap)
+        return nullptr;
 
     if (snap != lastSeenSnapshot)
     {
         processor.resetCursors(*snap, (int)tickPosition.load());
+        // A tempo edit applies from the position last reached rather than retroactively.
+        if (lastSeenSnapshot == nullptr || lastSeenSnapshot->tempoMap != snap->tempoMap)
+            playbackClock.anchor(*snap->tempoMap, tickPosition.load(), lastClockSeconds);
         lastSeenSnapshot = snap;
     }
 
+    if (anchorPending.exchange(false))
+        playbackClock.anchor(*snap->tempoMap, tickPosition.load(), clockSeconds);
+
     int seek = pendingSeekTick.exchange(-1);
     if (seek >= 0)
     {
         processor.sendAllNoteOffs(sink);
         tickPosition.store((double)seek);
         processor.resetCursors(*snap, seek);
+        playbackClock.anchor(*snap->tempoMap, seek, clockSeconds);
     }
+    return snap;
+}
+
+void PlaybackEngine::advanceTo(const PlaybackSnapshot& snap, double clockSeconds, PlaybackListener& sink,
+                               BlockSink* blockSink)
+{
+    // The audio clock dispatches every event whose tick lies before the block end; the timer clock
+    // only dispatches ticks that have fully elapsed.
+    auto toTick = [blockSink](double pos) { return blockSink != nullptr ? (int)std::ceil(pos) : (int)pos; };
 
-    const double now = juce::Time::getMillisecondCounterHiRes();
-    const double elapsedMs = now - lastCallbackTimeMs;
-    lastCallbackTimeMs = now;
+    const auto& tempoMap = *snap.tempoMap;
+    const double newPos = playbackClock.tickAt(tempoMap, clockSeconds);
+    lastClockSeconds = clockSeconds;
 
-    const int previousTick = (int)tickPosition.load();
-    const double ticksPerMs = (snap->getTempoAt(previousTick) * snap->ticksPerQuarterNote) / 60000.0;
-    const double newPos = tickPosition.load() + elapsedMs * ticksPerMs;
+    const int previousTick = toTick(tickPosition.load());
 
     const std::uint64_t lr = loopRange.load();
     const int ls = loopStartOf(lr);
     const int le = loopEndOf(lr);
     if (loopEnabled.load() && le > ls && newPos >= le)
     {
-        processor.process(*snap, previousTick, le, sink);
+        if (blockSink != nullptr)
+            blockSink->limitTo(le);
+        processor.process(snap, previousTick, le, sink);
         processor.sendAllNoteOffs(sink);
 
-        double overshoot = newPos - le;
-        if (overshoot > (double)(le - ls))
-            overshoot = 0.0;
-        const double wrapped = (double)ls + overshoot;
+        // Re-anchor at the moment the loop end was crossed so the time past it carries over.
+        playbackClock.anchor(tempoMap, ls, playbackClock.clockSecondsAt(tempoMap, le));
+        double wrapped = playbackClock.tickAt(tempoMap, clockSeconds);
+        if (wrapped >= le)
+        {
+            wrapped = ls;
+            playbackClock.anchor(tempoMap, ls, clockSeconds);
+        }
         tickPosition.store(wrapped);
-        processor.resetCursors(*snap, ls);
+        processor.resetCursors(snap, ls);
+        if (blockSink != nullptr)
+            blockSink->rebase(ls, blockSink->sampleAt(le));
 
-        const int headEnd = (int)wrapped;
+        const int headEnd = toTick(wrapped);
         if (headEnd > ls)
-            processor.process(*snap, ls, headEnd, sink);
+            processor.process(snap, ls, headEnd, sink);
         return;
     }
 
     tickPosition.store(newPos);
-    const int currentTick = (int)newPos;
+    const int currentTick = toTick(newPos);
     if (currentTick > previousTick)
-        processor.process(*snap, previousTick, currentTick, sink);
+        processor.process(snap, previousTick, currentTick, sink);
+}
+
+void PlaybackEngine::hiResTimerCallback()
+{
+    if (!playing)
+        return;
+
+    [[maybe_unused]] ScopedAllocationTripwire tripwire;
+    FanOut sink(listeners);
+    applyPendingReleases(sink);
+    const double now = juce::Time::getMillisecondCounterHiRes() / 1000.0;
+    auto snap = acquireSnapshot(sink, now);
+    if (!snap)
+        return;
+
+    advanceTo(*snap, now, sink, nullptr);
+}
+
+void PlaybackEngine::processAudioBlock(int numSamples, double sampleRate)
+{
+    if (playing && audioClockRunning && numSamples > 0 && sampleRate > 0.0)
+    {
+        [[maybe_unused]] ScopedAllocationTripwire tripwire;
+        FanOut immediate(listeners);
+        applyPendingReleases(immediate);
+        const double blockStart = audioClockSeconds;
+        audioClockSeconds += numSamples / sampleRate;
+        if (auto snap = acquireSnapshot(immediate, blockStart))
+        {
+            BlockSink sink(listeners, *snap->tempoMap, tickPosition.load(), sampleRate, numSamples);
+            advanceTo(*snap, audioClockSeconds, sink, &sink);
+        }
+    }
 }
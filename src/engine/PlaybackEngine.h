@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../model/MidiSequence.h"
+#include "PlaybackClock.h"
 #include "PlaybackListener.h"
 #include "PlaybackProcessor.h"
 #include "PlaybackSnapshot.h"
@@ -13,11 +14,19 @@
 class PlaybackEngine : private juce::HighResolutionTimer
 {
 public:
+    enum class ClockSource
+    {
+        HighResolutionTimer,
+        AudioDevice
+    };
+
     PlaybackEngine();
     ~PlaybackEngine() override;
 
     void setSequence(const MidiSequence* seq);
     void rebuildSnapshot();
+    // Applies mute/solo changes to the playing snapshot without rebuilding it.
+    void updateTrackAudibility();
 
     void play();
     void stop();
@@ -40,8 +49,40 @@ public:
     bool suspendForStructuralChange();
     void resumeAfterStructuralChange(bool wasRunning);
 
+    void setClockSource(ClockSource source);
+    ClockSource getClockSource() const;
+
+    // Advances playback by one audio block. Called from the audio thread before the plugin graph
+    // renders the same block, so plugin-bound MIDI is stamped at its exact sample offset.
+    void processAudioBlock(int numSamples, double sampleRate);
+
+    // Held by the audio thread from processAudioBlock until the graph has rendered that block. Stopping
+    // the audio clock waits for it, so the note-offs sent on stop can't reach a plugin ahead of note-ons
+    // still waiting in the block being rendered.
+    class ScopedAudioBlock
+    {
+    public:
+        explicit ScopedAudioBlock(PlaybackEngine& e) : engine(e) { engine.renderingBlock = true; }
+        ~ScopedAudioBlock() { engine.renderingBlock = false; }
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioBlock)
+
+    private:
+        PlaybackEngine& engine;
+    };
+
 private:
+    class BlockSink;
+
     void hiResTimerCallback() override;
+    void startClock();
+    bool stopClock();
+    bool isClockRunning() const;
+    void reserveReleaseFlags(int numTracks);
+    void applyPendingReleases(PlaybackListener& sink);
+    void retireSnapshot(std::shared_ptr<const PlaybackSnapshot> old);
+    std::shared_ptr<const PlaybackSnapshot> acquireSnapshot(PlaybackListener& sink, double clockSeconds);
+    void advanceTo(const PlaybackSnapshot& snap, double clockSeconds, PlaybackListener& sink, BlockSink* blockSink);
 
     const MidiSequence* sequence = nullptr;
 
@@ -52,12 +93,29 @@ private:
     std::atomic<bool> loopEnabled{false};
     std::atomic<std::uint64_t> loopRange{0};
 
-    double lastCallbackTimeMs = 0.0;
+    std::atomic<ClockSource> clockSource{ClockSource::HighResolutionTimer};
+    std::atomic<bool> audioClockRunning{false};
+    std::atomic<bool> renderingBlock{false};
+
+    // Owned by the clock thread. Clock time is the hi-res millisecond counter for the timer and the
+    // running sample count for the audio device.
+    PlaybackClock playbackClock;
+    double lastClockSeconds = 0.0;
+    double audioClockSeconds = 0.0;
+    std::atomic<bool> anchorPending{true};
     std::shared_ptr<const PlaybackSnapshot> lastSeenSnapshot;
 
-    std::shared_ptr<const PlaybackSnapshot> currentOwner;
+    // The message thread's writable handle on the published snapshot, for mute/solo updates.
+    std::shared_ptr<PlaybackSnapshot> currentOwner;
+    std::vector<std::shared_ptr<const PlaybackSnapshot>> retiredSnapshots;
     std::atomic<std::shared_ptr<const PlaybackSnapshot>> snapshot;
 
     PlaybackProcessor processor;
+    // One flag per track, set by releaseActiveNotesForTrack while the clock runs and cleared by the
+    // clock thread. Repeated requests coalesce, so unlike a queue they can't overflow. Only grown
+    // while the clock is stopped.
+    std::unique_ptr<std::atomic<bool>[]> releaseRequested;
+    int numReleaseFlags = 0;
+    std::atomic<bool> anyReleaseRequested{false};
     std::vector<PlaybackListener*> listeners;
 };
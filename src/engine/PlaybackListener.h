@@ -11,4 +11,20 @@ public:
     virtual void onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note) = 0;
     virtual void onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note) = 0;
     virtual void onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event) = 0;
+
+    // Called from the audio thread when playback is clocked by the audio device.
+    // sampleOffset is the position within the block currently being rendered.
+    virtual void onNoteOnAt(const PlaybackTrackContext& ctx, const MidiNote& note, [[maybe_unused]] int sampleOffset)
+    {
+        onNoteOn(ctx, note);
+    }
+    virtual void onNoteOffAt(const PlaybackTrackContext& ctx, const MidiNote& note, [[maybe_unused]] int sampleOffset)
+    {
+        onNoteOff(ctx, note);
+    }
+    virtual void onMidiEventAt(const PlaybackTrackContext& ctx, const MidiEvent& event,
+                               [[maybe_unused]] int sampleOffset)
+    {
+        onMidiEvent(ctx, event);
+    }
 };
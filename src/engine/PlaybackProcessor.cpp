@@ -1,80 +1,209 @@
 #include "PlaybackProcessor.h"
 #include <algorithm>
+#include <functional>
+
+namespace
+{
+// Notes from the previous snapshot may still be sounding when a new one takes over.
+std::size_t scratchCapacityFor(const PlaybackSnapshot& snap)
+{
+    return static_cast<std::size_t>(snap.maxConcurrentNotes) * 2;
+}
+
+// activeNotes is a min-heap on end tick, so the next note to expire is always at the front.
+bool endsLater(const ScheduledNote& a, const ScheduledNote& b)
+{
+    return a.note.endTick() > b.note.endTick();
+}
+
+std::size_t firstNoteAtOrAfter(const std::vector<MidiNote>& notes, std::size_t from, int tick)
+{
+    return static_cast<std::size_t>(std::lower_bound(notes.begin() + static_cast<std::ptrdiff_t>(from), notes.end(),
+                                                     tick, [](const MidiNote& n, int t) { return n.startTick < t; }) -
+                                    notes.begin());
+}
+
+std::size_t firstEventAtOrAfter(const std::vector<MidiEvent>& events, std::size_t from, int tick)
+{
+    return static_cast<std::size_t>(std::lower_bound(events.begin() + static_cast<std::ptrdiff_t>(from), events.end(),
+                                                     tick, [](const MidiEvent& e, int t) { return e.tick < t; }) -
+                                    events.begin());
+}
+} // namespace
+
+// Ties go to the lower track index, matching a stable sort over all tracks in order.
+bool PlaybackProcessor::CursorEntry::operator>(const CursorEntry& other) const
+{
+    return tick != other.tick ? tick > other.tick : trackIndex > other.trackIndex;
+}
+
+bool PlaybackProcessor::hasScratchFor(const PlaybackSnapshot& snap) const
+{
+    const auto numTracks = static_cast<std::size_t>(snap.getNumTracks());
+    return activeNotes.capacity() >= scratchCapacityFor(snap) && cursors.capacity() >= numTracks &&
+           noteQueue.capacity() >= numTracks && eventQueue.capacity() >= numTracks;
+}
+
+void PlaybackProcessor::reserveScratchFor(const PlaybackSnapshot& snap)
+{
+    const auto numTracks = static_cast<std::size_t>(snap.getNumTracks());
+    activeNotes.reserve(scratchCapacityFor(snap));
+    cursors.reserve(numTracks);
+    noteQueue.reserve(numTracks);
+    eventQueue.reserve(numTracks);
+}
+
+void PlaybackProcessor::seekTrack(const PlaybackSnapshot& snap, int trackIndex, int tick)
+{
+    const auto& segment = *snap.segments[static_cast<std::size_t>(trackIndex)];
+    auto& cursor = cursors[static_cast<std::size_t>(trackIndex)];
+    cursor.note = firstNoteAtOrAfter(segment.notes, 0, tick);
+    cursor.event = firstEventAtOrAfter(segment.events, 0, tick);
+
+    if (cursor.note < segment.notes.size())
+    {
+        noteQueue.push_back({segment.notes[cursor.note].startTick, trackIndex});
+        std::push_heap(noteQueue.begin(), noteQueue.end(), std::greater<>{});
+    }
+    if (cursor.event < segment.events.size())
+    {
+        eventQueue.push_back({segment.events[cursor.event].tick, trackIndex});
+        std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<>{});
+    }
+}
 
 void PlaybackProcessor::resetCursors(const PlaybackSnapshot& snap, int tick)
 {
-    noteCursor = (std::size_t)(std::lower_bound(snap.notes.begin(), snap.notes.end(), tick,
-                                                [](const ScheduledNote& n, int t) { return n.note.startTick < t; }) -
-                               snap.notes.begin());
-    eventCursor = (std::size_t)(std::lower_bound(snap.events.begin(), snap.events.end(), tick,
-                                                 [](const ScheduledEvent& e, int t) { return e.event.tick < t; }) -
-                                snap.events.begin());
+    cursorTick = tick;
+    noteQueue.clear();
+    eventQueue.clear();
+    cursors.assign(static_cast<std::size_t>(snap.getNumTracks()), TrackCursor{});
+    for (int t = 0; t < snap.getNumTracks(); ++t)
+    {
+        cursors[static_cast<std::size_t>(t)].audible = snap.isTrackAudible(t);
+        if (cursors[static_cast<std::size_t>(t)].audible)
+            seekTrack(snap, t, tick);
+    }
+}
+
+void PlaybackProcessor::disableTrack(int trackIndex, PlaybackListener& sink)
+{
+    auto belongsToTrack = [trackIndex](const CursorEntry& e) { return e.trackIndex == trackIndex; };
+    std::erase_if(noteQueue, belongsToTrack);
+    std::make_heap(noteQueue.begin(), noteQueue.end(), std::greater<>{});
+    std::erase_if(eventQueue, belongsToTrack);
+    std::make_heap(eventQueue.begin(), eventQueue.end(), std::greater<>{});
+    releaseActiveNotesForTrack(trackIndex, sink);
+}
+
+// Mute and solo toggles only switch cursors on or off; a re-enabled track resumes from the
+// current position instead of replaying what it skipped.
+void PlaybackProcessor::syncAudibility(const PlaybackSnapshot& snap, PlaybackListener& sink)
+{
+    for (int t = 0; t < static_cast<int>(cursors.size()); ++t)
+    {
+        auto& cursor = cursors[static_cast<std::size_t>(t)];
+        const bool audible = snap.isTrackAudible(t);
+        if (audible == cursor.audible)
+            continue;
+        cursor.audible = audible;
+        if (audible)
+            seekTrack(snap, t, cursorTick);
+        else
+            disableTrack(t, sink);
+    }
 }
 
 void PlaybackProcessor::offExpired(int toTick, PlaybackListener& sink)
 {
-    std::vector<ScheduledNote> expired;
+    while (!activeNotes.empty() && activeNotes.front().note.endTick() <= toTick)
     {
-        std::lock_guard<std::mutex> lock(activeNotesMutex);
-        auto it = std::stable_partition(activeNotes.begin(), activeNotes.end(),
-                                        [&](const ScheduledNote& a) { return a.note.endTick() > toTick; });
-        expired.assign(it, activeNotes.end());
-        activeNotes.erase(it, activeNotes.end());
+        std::pop_heap(activeNotes.begin(), activeNotes.end(), endsLater);
+        const ScheduledNote expired = activeNotes.back();
+        activeNotes.pop_back();
+        sink.onNoteOff(expired.ctx, expired.note);
     }
-    for (const auto& a : expired)
-        sink.onNoteOff(a.ctx, a.note);
 }
 
 void PlaybackProcessor::process(const PlaybackSnapshot& snap, int fromTick, int toTick, PlaybackListener& sink)
 {
+    syncAudibility(snap, sink);
     offExpired(toTick, sink);
 
-    while (eventCursor < snap.events.size() && snap.events[eventCursor].event.tick < fromTick)
-        ++eventCursor;
-    while (eventCursor < snap.events.size() && snap.events[eventCursor].event.tick < toTick)
+    while (!eventQueue.empty() && eventQueue.front().tick < toTick)
     {
-        const auto& se = snap.events[eventCursor];
-        sink.onMidiEvent(se.ctx, se.event);
-        ++eventCursor;
-    }
+        std::pop_heap(eventQueue.begin(), eventQueue.end(), std::greater<>{});
+        auto& entry = eventQueue.back();
+        const auto& segment = *snap.segments[static_cast<std::size_t>(entry.trackIndex)];
+        auto& cursor = cursors[static_cast<std::size_t>(entry.trackIndex)];
 
-    while (noteCursor < snap.notes.size() && snap.notes[noteCursor].note.startTick < fromTick)
-        ++noteCursor;
-    std::vector<ScheduledNote> started;
-    while (noteCursor < snap.notes.size() && snap.notes[noteCursor].note.startTick < toTick)
-    {
-        started.push_back(snap.notes[noteCursor]);
-        ++noteCursor;
+        if (entry.tick < fromTick)
+            cursor.event = firstEventAtOrAfter(segment.events, cursor.event, fromTick);
+        else
+            sink.onMidiEvent(segment.ctx, segment.events[cursor.event++]);
+
+        if (cursor.event < segment.events.size())
+        {
+            entry.tick = segment.events[cursor.event].tick;
+            std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<>{});
+        }
+        else
+            eventQueue.pop_back();
     }
-    if (!started.empty())
+
+    while (!noteQueue.empty() && noteQueue.front().tick < toTick)
     {
-        std::lock_guard<std::mutex> lock(activeNotesMutex);
-        for (const auto& s : started)
-            activeNotes.push_back(s);
-        for (const auto& s : started)
-            sink.onNoteOn(s.ctx, s.note);
+        std::pop_heap(noteQueue.begin(), noteQueue.end(), std::greater<>{});
+        auto& entry = noteQueue.back();
+        const auto& segment = *snap.segments[static_cast<std::size_t>(entry.trackIndex)];
+        auto& cursor = cursors[static_cast<std::size_t>(entry.trackIndex)];
+
+        if (entry.tick < fromTick)
+            cursor.note = firstNoteAtOrAfter(segment.notes, cursor.note, fromTick);
+        else
+        {
+            // Notes that also end inside this window never become active, which keeps activeNotes
+            // bounded by the snapshot's polyphony.
+            const auto& note = segment.notes[cursor.note++];
+            sink.onNoteOn(segment.ctx, note);
+            if (note.endTick() > toTick)
+            {
+                activeNotes.push_back({segment.ctx, note});
+                std::push_heap(activeNotes.begin(), activeNotes.end(), endsLater);
+            }
+            else
+                sink.onNoteOff(segment.ctx, note);
+        }
+
+        if (cursor.note < segment.notes.size())
+        {
+            entry.tick = segment.notes[cursor.note].startTick;
+            std::push_heap(noteQueue.begin(), noteQueue.end(), std::greater<>{});
+        }
+        else
+            noteQueue.pop_back();
     }
 
-    offExpired(toTick, sink);
+    cursorTick = toTick;
 }
 
 void PlaybackProcessor::sendAllNoteOffs(PlaybackListener& sink)
 {
-    std::vector<ScheduledNote> toOff;
-    {
-        std::lock_guard<std::mutex> lock(activeNotesMutex);
-        toOff.swap(activeNotes);
-    }
-    for (const auto& a : toOff)
+    for (const auto& a : activeNotes)
         sink.onNoteOff(a.ctx, a.note);
+    activeNotes.clear();
 }
 
 void PlaybackProcessor::releaseActiveNotesForTrack(int trackIndex, PlaybackListener& sink)
 {
-    std::lock_guard<std::mutex> lock(activeNotesMutex);
-    auto it = std::stable_partition(activeNotes.begin(), activeNotes.end(),
-                                    [&](const ScheduledNote& a) { return a.ctx.trackIndex != trackIndex; });
-    for (auto i = it; i != activeNotes.end(); ++i)
-        sink.onNoteOff(i->ctx, i->note);
-    activeNotes.erase(it, activeNotes.end());
+    std::size_t kept = 0;
+    for (const auto& a : activeNotes)
+    {
+        if (a.ctx.trackIndex != trackIndex)
+            activeNotes[kept++] = a;
+        else
+            sink.onNoteOff(a.ctx, a.note);
+    }
+    activeNotes.resize(kept);
+    std::make_heap(activeNotes.begin(), activeNotes.end(), endsLater);
 }
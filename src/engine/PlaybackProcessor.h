@@ -3,9 +3,10 @@
 #include "PlaybackListener.h"
 #include "PlaybackSnapshot.h"
 #include <cstddef>
-#include <mutex>
 #include <vector>
 
+// Not thread-safe: PlaybackEngine only touches it from the running clock thread, or from the
+// message thread while the clock is stopped.
 class PlaybackProcessor
 {
 public:
@@ -14,11 +15,35 @@ public:
     void sendAllNoteOffs(PlaybackListener& sink);
     void releaseActiveNotesForTrack(int trackIndex, PlaybackListener& sink);
 
+    // Scratch storage must be grown off the clock thread so that process() never allocates.
+    bool hasScratchFor(const PlaybackSnapshot& snap) const;
+    void reserveScratchFor(const PlaybackSnapshot& snap);
+
 private:
+    struct TrackCursor
+    {
+        std::size_t note = 0;
+        std::size_t event = 0;
+        bool audible = false;
+    };
+
+    // Next pending tick of one track; the queues below are min-heaps of these.
+    struct CursorEntry
+    {
+        int tick;
+        int trackIndex;
+
+        bool operator>(const CursorEntry& other) const;
+    };
+
+    void seekTrack(const PlaybackSnapshot& snap, int trackIndex, int tick);
+    void disableTrack(int trackIndex, PlaybackListener& sink);
+    void syncAudibility(const PlaybackSnapshot& snap, PlaybackListener& sink);
     void offExpired(int toTick, PlaybackListener& sink);
 
-    std::size_t noteCursor = 0;
-    std::size_t eventCursor = 0;
+    std::vector<TrackCursor> cursors;
+    std::vector<CursorEntry> noteQueue;
+    std::vector<CursorEntry> eventQueue;
+    int cursorTick = 0;
     std::vector<ScheduledNote> activeNotes;
-    std::mutex activeNotesMutex;
 };
@@ -1,37 +1,100 @@
 #include "PlaybackSnapshot.h"
 #include <algorithm>
 
+namespace
+{
+int countMaxConcurrentNotes(const std::vector<MidiNote>& notes)
+{
+    std::vector<int> starts;
+    std::vector<int> ends;
+    starts.reserve(notes.size());
+    ends.reserve(notes.size());
+    for (const auto& note : notes)
+    {
+        if (note.duration <= 0)
+            continue;
+        starts.push_back(note.startTick);
+        ends.push_back(note.endTick());
+    }
+    std::sort(ends.begin(), ends.end());
+
+    // starts is already ordered because notes is sorted by start tick.
+    int active = 0;
+    int maxActive = 0;
+    std::size_t e = 0;
+    for (int start : starts)
+    {
+        while (e < ends.size() && ends[e] <= start)
+        {
+            ++e;
+            --active;
+        }
+        maxActive = std::max(maxActive, ++active);
+    }
+    return maxActive;
+}
+
+std::shared_ptr<const PlaybackTrackSegment> buildSegment(const MidiTrack& track, const PlaybackTrackContext& ctx)
+{
+    auto segment = std::make_shared<PlaybackTrackSegment>();
+    segment->revision = track.getRevision();
+    segment->ctx = ctx;
+    const auto notes = track.getNotes();
+    segment->notes.reserve(notes.size());
+    for (const int slot : track.getStartOrder())
+        segment->notes.push_back(notes[static_cast<std::size_t>(slot)]);
+
+    // Events have no index; they are kept in the order they were added, which is tick order for
+    // loaded files, so the sort only runs once something was added out of order.
+    segment->events = track.getEvents();
+    auto byTick = [](const MidiEvent& a, const MidiEvent& b) { return a.tick < b.tick; };
+    if (!std::is_sorted(segment->events.begin(), segment->events.end(), byTick))
+        std::stable_sort(segment->events.begin(), segment->events.end(), byTick);
+    segment->maxConcurrentNotes = countMaxConcurrentNotes(segment->notes);
+    return segment;
+}
+} // namespace
+
+int PlaybackSnapshot::getNumTracks() const
+{
+    return static_cast<int>(segments.size());
+}
+
 double PlaybackSnapshot::getTempoAt(int tick) const
 {
-    double bpm = 120.0;
-    for (const auto& tc : tempoChanges)
+    return tempoMap->getTempoAt(tick);
+}
+
+bool PlaybackSnapshot::isTrackAudible(int trackIndex) const
+{
+    return audible[static_cast<std::size_t>(trackIndex)].load(std::memory_order_relaxed);
+}
+
+void PlaybackSnapshot::refreshAudibility(const MidiSequence& seq)
+{
+    const bool anySolo = seq.isAnySolo();
+    for (int t = 0; t < getNumTracks(); ++t)
     {
-        if (tc.tick <= tick)
-            bpm = tc.bpm;
-        else
-            break;
+        const auto& track = seq.getTrack(t);
+        audible[static_cast<std::size_t>(t)].store(!track.isMuted() && (!anySolo || track.isSolo()),
+                                                   std::memory_order_relaxed);
     }
-    return bpm;
 }
 
-PlaybackSnapshot PlaybackSnapshot::build(const MidiSequence& seq)
+PlaybackSnapshot PlaybackSnapshot::build(const MidiSequence& seq, const PlaybackSnapshot* previous)
 {
     PlaybackSnapshot snap;
     snap.ticksPerQuarterNote = seq.getTicksPerQuarterNote();
-    snap.tempoChanges = seq.getTempoChanges();
-    std::stable_sort(snap.tempoChanges.begin(), snap.tempoChanges.end(),
-                     [](const TempoChange& a, const TempoChange& b) { return a.tick < b.tick; });
+    snap.tempoMap = seq.getTempoMap();
 
-    const bool anySolo = seq.isAnySolo();
     const int numTracks = seq.getNumTracks();
 
+    snap.segments.reserve(static_cast<std::size_t>(numTracks));
+    snap.audible = std::make_unique<std::atomic<bool>[]>(static_cast<std::size_t>(numTracks));
+
     for (int t = 0; t < numTracks; ++t)
     {
         const auto& track = seq.getTrack(t);
-        if (track.isMuted())
-            continue;
-        if (anySolo && !track.isSolo())
-            continue;
 
         PlaybackTrackContext ctx;
         ctx.trackIndex = t;
@@ -40,16 +103,20 @@ PlaybackSnapshot PlaybackSnapshot::build(const MidiSequence& seq)
         const int rt = track.getRouteTargetTrackIndex();
         ctx.routeTarget = (rt >= 0 && rt < numTracks) ? rt : t;
 
-        for (const auto& note : track.getNotes())
-            snap.notes.push_back({ctx, note});
-        for (const auto& event : track.getEvents())
-            snap.events.push_back({ctx, event});
-    }
+        std::shared_ptr<const PlaybackTrackSegment> segment;
+        if (previous != nullptr && t < previous->getNumTracks())
+        {
+            const auto& cached = previous->segments[static_cast<std::size_t>(t)];
+            if (cached->revision == track.getRevision() && cached->ctx == ctx)
+                segment = cached;
+        }
+        if (segment == nullptr)
+            segment = buildSegment(track, ctx);
 
-    std::stable_sort(snap.notes.begin(), snap.notes.end(), [](const ScheduledNote& a, const ScheduledNote& b)
-                     { return a.note.startTick < b.note.startTick; });
-    std::stable_sort(snap.events.begin(), snap.events.end(),
-                     [](const ScheduledEvent& a, const ScheduledEvent& b) { return a.event.tick < b.event.tick; });
+        snap.maxConcurrentNotes += segment->maxConcurrentNotes;
+        snap.segments.push_back(std::move(segment));
+    }
+    snap.refreshAudibility(seq);
 
     return snap;
 }
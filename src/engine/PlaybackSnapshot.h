@@ -4,6 +4,9 @@
 #include "../model/MidiNote.h"
 #include "../model/MidiSequence.h"
 #include "../model/MidiTrack.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 struct PlaybackTrackContext
@@ -12,27 +15,50 @@ struct PlaybackTrackContext
     int channel = 1;
     int routeTarget = 0;
     MidiTrack::OutputDestination destination = MidiTrack::OutputDestination::MidiDevice;
+
+    bool operator==(const PlaybackTrackContext&) const = default;
 };
 
+// A note that has been started and still needs its note-off. Carries its context by value so that
+// it outlives the snapshot it came from.
 struct ScheduledNote
 {
     PlaybackTrackContext ctx;
     MidiNote note;
 };
 
-struct ScheduledEvent
+// One track's notes and events sorted by tick. Immutable once built, so unchanged tracks share their
+// segment between successive snapshots.
+struct PlaybackTrackSegment
 {
+    std::uint64_t revision = 0;
     PlaybackTrackContext ctx;
-    MidiEvent event;
+    std::vector<MidiNote> notes;
+    std::vector<MidiEvent> events;
+    int maxConcurrentNotes = 0;
 };
 
 struct PlaybackSnapshot
 {
-    std::vector<ScheduledNote> notes;
-    std::vector<ScheduledEvent> events;
-    std::vector<TempoChange> tempoChanges;
+    // Indexed by track, including muted ones; PlaybackProcessor merges them with per-track cursors.
+    std::vector<std::shared_ptr<const PlaybackTrackSegment>> segments;
+    // Shared with the sequence that built it; never null.
+    std::shared_ptr<const TempoMap> tempoMap = std::make_shared<const TempoMap>();
     int ticksPerQuarterNote = MidiSequence::defaultTicksPerQuarterNote;
+    // Upper bound over all tracks, since any of them can be unmuted without a rebuild.
+    int maxConcurrentNotes = 0;
 
+    int getNumTracks() const;
     double getTempoAt(int tick) const;
-    static PlaybackSnapshot build(const MidiSequence& seq);
+
+    // Mute/solo state is the only part of a published snapshot that changes: the message thread
+    // writes it through its non-const owner and the clock thread picks it up on its next callback.
+    bool isTrackAudible(int trackIndex) const;
+    void refreshAudibility(const MidiSequence& seq);
+
+    // Segments of tracks whose revision and context match those in previous are reused as-is.
+    static PlaybackSnapshot build(const MidiSequence& seq, const PlaybackSnapshot* previous = nullptr);
+
+private:
+    std::unique_ptr<std::atomic<bool>[]> audible;
 };
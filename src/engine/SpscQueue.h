@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Wait-free ring buffer for exactly one producer thread and one consumer thread.
+// A push into a full queue is dropped and counted rather than blocking the producer. A push can
+// also ask for headroom, failing while fewer than that many slots would be left for other pushes.
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity) : fifo(capacity + 1), storage(static_cast<std::size_t>(capacity + 1)) {}
+
+    bool push(const T& item, int headroom = 0)
+    {
+        int start1, size1, start2, size2;
+        if (fifo.getFreeSpace() <= headroom)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        storage[static_cast<std::size_t>(size1 > 0 ? start1 : start2)] = item;
+        fifo.finishedWrite(1);
+        return true;
+    }
+
+    template <typename Fn>
+    int drain(Fn&& fn)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+        for (int i = 0; i < size1; ++i)
+            fn(storage[static_cast<std::size_t>(start1 + i)]);
+        for (int i = 0; i < size2; ++i)
+            fn(storage[static_cast<std::size_t>(start2 + i)]);
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    bool isEmpty() const { return fifo.getNumReady() == 0; }
+    std::uint64_t getNumDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<T> storage;
+    std::atomic<std::uint64_t> dropped{0};
+};
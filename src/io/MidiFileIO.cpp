@@ -1,6 +1,11 @@
 #include "MidiFileIO.h"
-#include <map>
-#include <set>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <optional>
+#include <span>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -45,10 +50,9 @@ bool isValidUtf8(const char* data, int length)
     return true;
 }
 
-juce::String decodeMetaText(const juce::MidiMessage& msg)
+juce::String decodeMetaText(const uint8_t* bytes, int length)
 {
-    auto* data = reinterpret_cast<const char*>(msg.getMetaEventData());
-    int length = msg.getMetaEventLength();
+    auto* data = reinterpret_cast<const char*>(bytes);
 
     if (data == nullptr || length <= 0)
         return {};
@@ -90,6 +94,406 @@ juce::String decodeMetaText(const juce::MidiMessage& msg)
     return juce::String::fromUTF8(data, length);
 }
 
+struct SmfHeader
+{
+    int format = 0;
+    int timeFormat = 0;
+};
+
+// 読み込み中の 1 トラック分のデータ。ノートは note-on の順に並ぶ
+struct TrackData
+{
+    int channel = 0; // 最初のチャンネルメッセージのチャンネル (1-16)。0 はまだ無い
+    std::vector<MidiNote> notes;
+    std::vector<MidiEvent> events;
+};
+
+struct MetaLists
+{
+    std::vector<TempoChange> tempos;
+    std::vector<TimeSignatureChange> timeSignatures;
+    std::vector<KeySignatureChange> keySignatures;
+    std::vector<ChordChange> chords;
+};
+
+class ByteReader
+{
+public:
+    explicit ByteReader(std::span<const uint8_t> bytes) : data(bytes) {}
+
+    bool atEnd() const { return pos >= data.size(); }
+    size_t remaining() const { return data.size() - pos; }
+    const uint8_t* current() const { return data.data() + pos; }
+
+    bool readByte(uint8_t& value)
+    {
+        if (atEnd())
+            return false;
+        value = data[pos++];
+        return true;
+    }
+
+    bool readVarLen(uint32_t& value)
+    {
+        value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint8_t byte;
+            if (!readByte(byte))
+                return false;
+            value = (value << 7) | (byte & 0x7F);
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool skip(size_t count)
+    {
+        if (count > remaining())
+            return false;
+        pos += count;
+        return true;
+    }
+
+private:
+    std::span<const uint8_t> data;
+    size_t pos = 0;
+};
+
+// note-on と note-off を同じチャンネル・ノート番号で対応付ける。juce::MidiMessageSequence::updateMatchedPairs
+// と同じく、鳴っているノートは次の note-off か同じ音の次の note-on で閉じ、閉じられなかったノートは 1 拍の長さにする
+class NotePairing
+{
+public:
+    explicit NotePairing(int ticksPerQuarterNote) : ppq(ticksPerQuarterNote) { clearOpenNotes(); }
+
+    // 同じ tick では note-off を先に処理するため、note-on は tick が進むまで保留する
+    void noteOn(TrackData& track, int channel, int noteNumber, int velocity, int tick)
+    {
+        if (tick != pendingTick)
+            flush();
+        pendingTick = tick;
+        pending.push_back({&track, channel, noteNumber, velocity});
+    }
+
+    void noteOff(int channel, int noteNumber, int tick)
+    {
+        if (tick != pendingTick)
+            flush();
+        close(channel, noteNumber, tick);
+    }
+
+    void finish()
+    {
+        flush();
+        for (auto& open : openNotes)
+            if (open.track != nullptr)
+                open.track->notes[open.index].duration = ppq;
+        clearOpenNotes();
+    }
+
+private:
+    struct OpenNote
+    {
+        TrackData* track;
+        size_t index;
+    };
+
+    struct PendingNoteOn
+    {
+        TrackData* track;
+        int channel;
+        int noteNumber;
+        int velocity;
+    };
+
+    OpenNote& slot(int channel, int noteNumber)
+    {
+        return openNotes[static_cast<size_t>((channel - 1) * 128 + noteNumber)];
+    }
+
+    void close(int channel, int noteNumber, int tick)
+    {
+        auto& open = slot(channel, noteNumber);
+        if (open.track == nullptr)
+            return;
+        auto& note = open.track->notes[open.index];
+        note.duration = tick - note.startTick;
+        open.track = nullptr;
+    }
+
+    void flush()
+    {
+        for (const auto& on : pending)
+        {
+            close(on.channel, on.noteNumber, pendingTick);
+            on.track->notes.push_back({on.noteNumber, on.velocity, pendingTick, 0});
+            slot(on.channel, on.noteNumber) = {on.track, on.track->notes.size() - 1};
+        }
+        pending.clear();
+    }
+
+    void clearOpenNotes() { openNotes.fill({nullptr, 0}); }
+
+    int ppq;
+    std::array<OpenNote, 16 * 128> openNotes;
+    std::vector<PendingNoteOn> pending;
+    int pendingTick = -1;
+};
+
+void decodeMetaEvent(int type, const uint8_t* data, uint32_t length, int tick, MetaLists& meta,
+                     juce::String& trackName)
+{
+    if (type == 0x51 && length >= 3)
+    {
+        const int microsecondsPerBeat = (data[0] << 16) | (data[1] << 8) | data[2];
+        if (microsecondsPerBeat > 0)
+            meta.tempos.push_back({tick, 60000000.0 / microsecondsPerBeat});
+    }
+    else if (type == 0x58 && length >= 2)
+    {
+        if (data[0] > 0 && data[1] <= 6)
+            meta.timeSignatures.push_back({tick, data[0], 1 << data[1]});
+    }
+    else if (type == 0x59 && length >= 2)
+    {
+        meta.keySignatures.push_back(
+            {tick, MidiSequence::normalizeSharpsOrFlats(static_cast<int8_t>(data[0])), data[1] != 0});
+    }
+    else if (type == 0x7F && length >= 7 && data[0] == 0x43 && data[1] == 0x7B && data[2] == 0x01)
+    {
+        // XF Chord: 43 7B 01 cr ct bn bt
+        meta.chords.push_back({tick, data[3], data[4], data[5], data[6]});
+    }
+    else if (type == 0x03)
+    {
+        trackName = decodeMetaText(data, static_cast<int>(length));
+    }
+}
+
+// MTrk チャンクを 1 回の走査でデコードする。チャンネルメッセージの行き先は trackFor(channel) が決める。
+// 途中で切れている・壊れている場合は false を返す。End of Track が無くてもイベントの切れ目で終わっていれば良い
+template <typename TrackFor>
+bool decodeTrackChunk(std::span<const uint8_t> chunk, int ppq, MetaLists& meta, juce::String& trackName,
+                      TrackFor&& trackFor)
+{
+    ByteReader reader(chunk);
+    NotePairing pairing(ppq);
+    long long tick = 0;
+    uint8_t runningStatus = 0;
+
+    while (!reader.atEnd())
+    {
+        uint32_t delta;
+        uint8_t status;
+        if (!reader.readVarLen(delta) || !reader.readByte(status))
+            return false;
+        tick = std::min<long long>(tick + delta, INT_MAX);
+        const int t = static_cast<int>(tick);
+
+        if (status == 0xFF)
+        {
+            uint8_t type;
+            uint32_t length;
+            if (!reader.readByte(type) || !reader.readVarLen(length) || length > reader.remaining())
+                return false;
+            if (type == 0x2F)
+                break;
+            decodeMetaEvent(type, reader.current(), length, t, meta, trackName);
+            reader.skip(length);
+            continue;
+        }
+
+        if (status == 0xF0 || status == 0xF7)
+        {
+            uint32_t length;
+            if (!reader.readVarLen(length) || !reader.skip(length))
+                return false;
+            continue;
+        }
+
+        if (status >= 0xF0)
+        {
+            // システムコモンメッセージ（SMF では本来使われない）は読み飛ばす
+            if (!reader.skip(status == 0xF2 ? 2 : (status == 0xF1 || status == 0xF3) ? 1 : 0))
+                return false;
+            continue;
+        }
+
+        uint8_t data1;
+        if (status < 0x80)
+        {
+            // ランニングステータス
+            if (runningStatus == 0)
+                return false;
+            data1 = status;
+            status = runningStatus;
+        }
+        else if (!reader.readByte(data1))
+        {
+            return false;
+        }
+        runningStatus = status;
+
+        const int kind = status & 0xF0;
+        const int channel = (status & 0x0F) + 1;
+        uint8_t data2 = 0;
+        if (kind != 0xC0 && kind != 0xD0 && !reader.readByte(data2))
+            return false;
+
+        switch (kind)
+        {
+        case 0x80:
+            pairing.noteOff(channel, data1 & 0x7F, t);
+            break;
+        case 0x90:
+            if (data2 == 0)
+                pairing.noteOff(channel, data1 & 0x7F, t);
+            else
+                pairing.noteOn(trackFor(channel), channel, data1 & 0x7F, data2, t);
+            break;
+        case 0xA0:
+            trackFor(channel).events.push_back(
+                {.type = MidiEvent::Type::KeyPressure, .tick = t, .data1 = data1, .data2 = data2});
+            break;
+        case 0xB0:
+            trackFor(channel).events.push_back(
+                {.type = MidiEvent::Type::ControlChange, .tick = t, .data1 = data1, .data2 = data2});
+            break;
+        case 0xC0:
+            trackFor(channel).events.push_back({.type = MidiEvent::Type::ProgramChange, .tick = t, .data1 = data1});
+            break;
+        case 0xD0:
+            trackFor(channel).events.push_back({.type = MidiEvent::Type::ChannelPressure, .tick = t, .data1 = data1});
+            break;
+        case 0xE0:
+            trackFor(channel).events.push_back(
+                {.type = MidiEvent::Type::PitchBend, .tick = t, .data1 = (data1 & 0x7F) | ((data2 & 0x7F) << 7)});
+            break;
+        default:
+            break;
+        }
+    }
+
+    pairing.finish();
+    return true;
+}
+
+// 同じ tick の変更は後から読んだものを優先する（add*Change と同じ挙動）
+template <typename Change>
+std::vector<Change> sortedByTick(std::vector<Change> changes)
+{
+    std::ranges::stable_sort(changes, {}, &Change::tick);
+    std::vector<Change> result;
+    result.reserve(changes.size());
+    for (const auto& change : changes)
+    {
+        if (!result.empty() && result.back().tick == change.tick)
+            result.back() = change;
+        else
+            result.push_back(change);
+    }
+    return result;
+}
+
+// 拍子の変更は直前の拍子での小節の頭に揃える（addTimeSignatureChange と同じ挙動）
+std::vector<TimeSignatureChange> snapToBars(std::vector<TimeSignatureChange> changes, int ppq)
+{
+    std::vector<TimeSignatureChange> result;
+    result.reserve(changes.size());
+    for (auto change : sortedByTick(std::move(changes)))
+    {
+        if (!result.empty())
+        {
+            const auto& prev = result.back();
+            const int ticksPerBar = std::max(1, ppq * 4 / prev.denominator * prev.numerator);
+            change.tick = prev.tick + (change.tick - prev.tick) / ticksPerBar * ticksPerBar;
+            if (change.tick == prev.tick)
+            {
+                result.back() = change;
+                continue;
+            }
+        }
+        result.push_back(change);
+    }
+    return result;
+}
+
+void fillTrack(MidiTrack& track, const TrackData& data)
+{
+    track.setChannel(data.channel);
+    for (const auto& note : data.notes)
+        track.addNote(note);
+    for (const auto& event : data.events)
+        track.addEvent(event);
+}
+
+template <typename T>
+void appendAll(std::vector<T>& into, std::vector<T>&& from)
+{
+    if (into.empty())
+        into = std::move(from);
+    else
+        into.insert(into.end(), from.begin(), from.end());
+}
+
+// 1 つの MTrk チャンクのデコード結果。Format 0 ではチャンネル 1-16 の 16 トラック、それ以外は 1 トラック
+struct DecodedChunk
+{
+    bool complete = false;
+    std::vector<TrackData> tracks;
+    juce::String trackName;
+    MetaLists meta;
+};
+
+DecodedChunk decodeChunk(std::span<const uint8_t> chunk, int format, int ppq)
+{
+    DecodedChunk decoded;
+    decoded.tracks.resize(format == 0 ? 16 : 1);
+    decoded.complete = decodeTrackChunk(chunk, ppq, decoded.meta, decoded.trackName,
+                                        [&](int channel) -> TrackData&
+                                        {
+                                            auto& data =
+                                                decoded.tracks[format == 0 ? static_cast<size_t>(channel - 1) : 0];
+                                            if (data.channel == 0)
+                                                data.channel = channel;
+                                            return data;
+                                        });
+    return decoded;
+}
+
+// 小さいファイルではスレッドを起こすコストの方が大きいので、この量ごとに 1 スレッドまでにする
+constexpr size_t minBytesPerThread = 256 * 1024;
+
+// job(0..numJobs-1) を最大 numThreads スレッドで実行する。1 スレッドなら呼び出し元のスレッドで順に実行する
+template <typename Job>
+void runJobs(int numJobs, int numThreads, const Job& job)
+{
+    numThreads = std::min(numThreads, numJobs);
+    if (numThreads <= 1)
+    {
+        for (int i = 0; i < numJobs; ++i)
+            job(i);
+        return;
+    }
+
+    std::atomic<int> remaining{numJobs};
+    juce::WaitableEvent finished;
+    juce::ThreadPool pool(juce::ThreadPoolOptions{}.withThreadName("MIDI load").withNumberOfThreads(numThreads));
+    for (int i = 0; i < numJobs; ++i)
+    {
+        pool.addJob(
+            [&, i]
+            {
+                job(i);
+                if (--remaining == 0)
+                    finished.signal();
+            });
+    }
+    finished.wait();
+}
+
 } // anonymous namespace
 
 bool MidiFileIO::save(const MidiSequence& sequence, const juce::File& file)
@@ -162,10 +566,12 @@ bool MidiFileIO::save(const MidiSequence& sequence, const juce::File& file)
 
         const int trackChannel = track.getChannel();
 
-        for (int i = 0; i < track.getNumNotes(); ++i)
+        // Walked in start order so same-tick notes are written in the order they were added, whatever
+        // removals have done to their slots.
+        const auto notes = track.getNotes();
+        for (const int slot : track.getStartOrder())
         {
-            const auto& note = track.getNote(i);
-
+            const auto note = notes[static_cast<std::size_t>(slot)];
             auto noteOn =
                 juce::MidiMessage::noteOn(trackChannel, note.noteNumber, static_cast<juce::uint8>(note.velocity));
             noteOn.setTimeStamp(note.startTick);
@@ -227,299 +633,147 @@ bool MidiFileIO::save(const MidiSequence& sequence, const juce::File& file)
     return midiFile.writeTo(stream, 1);
 }
 
-bool MidiFileIO::load(MidiSequence& sequence, const juce::File& file)
+bool MidiFileIO::load(MidiSequence& sequence, const juce::File& file, int numThreads)
 {
-    juce::MemoryBlock fileData;
-    if (!file.loadFileAsData(fileData))
+    // ファイル全体をメモリに読み込まず、マップしたまま 1 回の走査でデコードする
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr)
         return false;
 
-    auto* data = static_cast<const uint8_t*>(fileData.getData());
-    size_t size = fileData.getSize();
+    auto* data = static_cast<const uint8_t*>(mapped.getData());
+    size_t size = mapped.getSize();
 
-    // MThd や MTrk 以外の非標準チャンクをフィルタリング（YAMAHA XG ファイルの XFIH 等）
-    juce::MemoryBlock filteredData;
+    // 先にチャンクの境界だけを調べる。MThd や MTrk 以外の非標準チャンクは読み飛ばす（YAMAHA XG ファイルの XFIH 等）
+    std::optional<SmfHeader> header;
+    std::vector<std::span<const uint8_t>> trackChunks;
+    size_t trackBytes = 0;
     {
         size_t pos = 0;
         while (pos + 8 <= size)
         {
             uint32_t chunkSize = (data[pos + 4] << 24) | (data[pos + 5] << 16) | (data[pos + 6] << 8) | data[pos + 7];
-            size_t totalSize = 8 + chunkSize;
-            if (pos + totalSize > size)
+            if (chunkSize > size - pos - 8)
+            {
+                // 途中で切れた MTrk は失敗にする。それ以外は末尾のゴミとして無視する
+                if (memcmp(data + pos, "MTrk", 4) == 0)
+                    return false;
                 break;
+            }
 
-            if (memcmp(data + pos, "MThd", 4) == 0 || memcmp(data + pos, "MTrk", 4) == 0)
-                filteredData.append(data + pos, totalSize);
+            const auto* body = data + pos + 8;
+            if (memcmp(data + pos, "MThd", 4) == 0 && !header && chunkSize >= 6)
+            {
+                header = SmfHeader{(body[0] << 8) | body[1], static_cast<int16_t>((body[4] << 8) | body[5])};
+            }
+            else if (memcmp(data + pos, "MTrk", 4) == 0)
+            {
+                if (!header)
+                    return false;
+                trackChunks.emplace_back(body, chunkSize);
+                trackBytes += chunkSize;
+            }
 
-            pos += totalSize;
+            pos += 8 + chunkSize;
         }
     }
 
-    int format = 0;
-    if (filteredData.getSize() >= 10)
-    {
-        auto* hdr = static_cast<const uint8_t*>(filteredData.getData());
-        format = (hdr[8] << 8) | hdr[9];
-    }
-
-    juce::MemoryInputStream stream(filteredData.getData(), filteredData.getSize(), false);
-
-    juce::MidiFile midiFile;
-    if (!midiFile.readFrom(stream))
+    if (!header)
         return false;
 
-    sequence.clear();
+    if (numThreads <= 0)
+        numThreads = juce::SystemStats::getNumCpus();
+    numThreads = static_cast<int>(std::min<size_t>(static_cast<size_t>(numThreads),
+                                                   std::max<size_t>(1, trackBytes / minBytesPerThread)));
 
-    int ppq = midiFile.getTimeFormat();
+    int ppq = header->timeFormat;
     if (ppq <= 0)
         ppq = MidiSequence::defaultTicksPerQuarterNote;
+
+    // チャンクは互いに独立しているので、ノートの対応付けまで並列にデコードする
+    std::vector<DecodedChunk> decoded(trackChunks.size());
+    runJobs(static_cast<int>(trackChunks.size()), numThreads,
+            [&](int i)
+            {
+                const auto index = static_cast<size_t>(i);
+                decoded[index] = decodeChunk(trackChunks[index], header->format, ppq);
+            });
+
+    // 壊れたトラックが 1 つでもあれば、sequence には触らずに失敗する
+    if (!std::ranges::all_of(decoded, &DecodedChunk::complete))
+        return false;
+
+    sequence.clear();
     sequence.setTicksPerQuarterNote(ppq);
 
-    for (int t = 0; t < midiFile.getNumTracks(); ++t)
+    // 結果はチャンクの順にまとめるので、逐次デコードした場合と同じになる
+    MetaLists meta;
+    meta.tempos = sequence.getTempoChanges();
+    meta.timeSignatures = sequence.getTimeSignatureChanges();
+    for (auto& chunk : decoded)
     {
-        const auto* msgSeq = midiFile.getTrack(t);
-        for (int i = 0; i < msgSeq->getNumEvents(); ++i)
-        {
-            const auto& msg = msgSeq->getEventPointer(i)->message;
-            if (msg.isTempoMetaEvent())
-            {
-                double bpm = 60000000.0 / msg.getTempoSecondsPerQuarterNote() / 1000000.0;
-                int tick = static_cast<int>(msg.getTimeStamp());
-                sequence.addTempoChange(tick, bpm);
-            }
-            else if (msg.isTimeSignatureMetaEvent())
-            {
-                int numerator, denominator;
-                msg.getTimeSignatureInfo(numerator, denominator);
-                int tick = static_cast<int>(msg.getTimeStamp());
-                sequence.addTimeSignatureChange(tick, numerator, denominator);
-            }
-            else if (msg.isKeySignatureMetaEvent())
-            {
-                int tick = static_cast<int>(msg.getTimeStamp());
-                int sf = msg.getKeySignatureNumberOfSharpsOrFlats();
-                bool isMinor = !msg.isKeySignatureMajorKey();
-                sequence.addKeySignatureChange(tick, sf, isMinor);
-            }
-            else if (msg.getMetaEventType() == 0x7F)
-            {
-                auto* metaData = msg.getMetaEventData();
-                int len = msg.getMetaEventLength();
-                // XF Chord: 43 7B 01 cr ct bn bt
-                if (metaData != nullptr && len >= 7 && metaData[0] == 0x43 && metaData[1] == 0x7B &&
-                    metaData[2] == 0x01)
-                {
-                    int tick = static_cast<int>(msg.getTimeStamp());
-                    sequence.addChordChange(tick, metaData[3], metaData[4], metaData[5], metaData[6]);
-                }
-            }
-        }
+        appendAll(meta.tempos, std::move(chunk.meta.tempos));
+        appendAll(meta.timeSignatures, std::move(chunk.meta.timeSignatures));
+        appendAll(meta.keySignatures, std::move(chunk.meta.keySignatures));
+        appendAll(meta.chords, std::move(chunk.meta.chords));
     }
 
-    if (format == 0)
+    std::vector<TrackData> tracks;
+    std::vector<juce::String> trackNames;
+    if (header->format == 0)
     {
         // Format 0: チャンネル別にトラックを分割
-        std::set<int> usedChannels;
-        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+        std::vector<TrackData> channels(16);
+        for (auto& chunk : decoded)
         {
-            const auto* msgSeq = midiFile.getTrack(t);
-            for (int i = 0; i < msgSeq->getNumEvents(); ++i)
+            for (size_t ch = 0; ch < channels.size(); ++ch)
             {
-                const auto& msg = msgSeq->getEventPointer(i)->message;
-                if (msg.isNoteOn() || msg.isController() || msg.isProgramChange() || msg.isPitchWheel() ||
-                    msg.isChannelPressure() || msg.isAftertouch())
-                {
-                    usedChannels.insert(msg.getChannel());
-                }
+                auto& from = chunk.tracks[ch];
+                if (from.channel == 0)
+                    continue;
+                channels[ch].channel = from.channel;
+                appendAll(channels[ch].notes, std::move(from.notes));
+                appendAll(channels[ch].events, std::move(from.events));
             }
         }
 
-        std::map<int, int> channelTrackIndex;
-        for (int ch : usedChannels)
-        {
-            int index = sequence.getNumTracks();
-            auto& track = sequence.addTrack();
-            track.setName("Ch." + std::to_string(ch));
-            track.setChannel(ch);
-            channelTrackIndex[ch] = index;
-        }
-
-        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+        for (auto& channelData : channels)
         {
-            const auto* msgSeq = midiFile.getTrack(t);
-            juce::MidiMessageSequence sorted(*msgSeq);
-            sorted.updateMatchedPairs();
-
-            for (int i = 0; i < sorted.getNumEvents(); ++i)
-            {
-                const auto* event = sorted.getEventPointer(i);
-                const auto& msg = event->message;
-
-                if (msg.isNoteOn())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    int noteNumber = msg.getNoteNumber();
-                    int velocity = msg.getVelocity();
-                    int startTick = static_cast<int>(msg.getTimeStamp());
-                    int endTick = startTick + ppq;
-
-                    if (event->noteOffObject != nullptr)
-                        endTick = static_cast<int>(event->noteOffObject->message.getTimeStamp());
-
-                    track.addNote({noteNumber, velocity, startTick, endTick - startTick});
-                }
-                else if (msg.isController())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    track.addEvent({.type = MidiEvent::Type::ControlChange,
-                                    .tick = static_cast<int>(msg.getTimeStamp()),
-                                    .data1 = msg.getControllerNumber(),
-                                    .data2 = msg.getControllerValue()});
-                }
-                else if (msg.isProgramChange())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    track.addEvent({.type = MidiEvent::Type::ProgramChange,
-                                    .tick = static_cast<int>(msg.getTimeStamp()),
-                                    .data1 = msg.getProgramChangeNumber()});
-                }
-                else if (msg.isPitchWheel())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    track.addEvent({.type = MidiEvent::Type::PitchBend,
-                                    .tick = static_cast<int>(msg.getTimeStamp()),
-                                    .data1 = msg.getPitchWheelValue()});
-                }
-                else if (msg.isChannelPressure())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    track.addEvent({.type = MidiEvent::Type::ChannelPressure,
-                                    .tick = static_cast<int>(msg.getTimeStamp()),
-                                    .data1 = msg.getChannelPressureValue()});
-                }
-                else if (msg.isAftertouch())
-                {
-                    auto& track = sequence.getTrack(channelTrackIndex[msg.getChannel()]);
-
-                    track.addEvent({.type = MidiEvent::Type::KeyPressure,
-                                    .tick = static_cast<int>(msg.getTimeStamp()),
-                                    .data1 = msg.getNoteNumber(),
-                                    .data2 = msg.getAfterTouchValue()});
-                }
-            }
+            if (channelData.channel == 0)
+                continue;
+            trackNames.push_back("Ch." + juce::String(channelData.channel));
+            tracks.push_back(std::move(channelData));
         }
     }
     else
     {
         // Format 1 以降: MIDI ファイルのトラックをそのまま使用
-        for (int t = 0; t < midiFile.getNumTracks(); ++t)
+        for (auto& chunk : decoded)
         {
-            const auto* msgSeq = midiFile.getTrack(t);
-            juce::MidiMessageSequence sorted(*msgSeq);
-            sorted.updateMatchedPairs();
-
-            MidiTrack* track = nullptr;
-            juce::String trackName;
-
-            for (int i = 0; i < sorted.getNumEvents(); ++i)
-            {
-                const auto* event = sorted.getEventPointer(i);
-                const auto& msg = event->message;
-
-                if (msg.isTrackNameEvent())
-                {
-                    trackName = decodeMetaText(msg);
-                }
-                else if (msg.isNoteOn())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    int noteNumber = msg.getNoteNumber();
-                    int velocity = msg.getVelocity();
-                    int startTick = static_cast<int>(msg.getTimeStamp());
-                    int endTick = startTick + ppq;
-
-                    if (event->noteOffObject != nullptr)
-                        endTick = static_cast<int>(event->noteOffObject->message.getTimeStamp());
-
-                    track->addNote({noteNumber, velocity, startTick, endTick - startTick});
-                }
-                else if (msg.isController())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    track->addEvent({.type = MidiEvent::Type::ControlChange,
-                                     .tick = static_cast<int>(msg.getTimeStamp()),
-                                     .data1 = msg.getControllerNumber(),
-                                     .data2 = msg.getControllerValue()});
-                }
-                else if (msg.isProgramChange())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    track->addEvent({.type = MidiEvent::Type::ProgramChange,
-                                     .tick = static_cast<int>(msg.getTimeStamp()),
-                                     .data1 = msg.getProgramChangeNumber()});
-                }
-                else if (msg.isPitchWheel())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    track->addEvent({.type = MidiEvent::Type::PitchBend,
-                                     .tick = static_cast<int>(msg.getTimeStamp()),
-                                     .data1 = msg.getPitchWheelValue()});
-                }
-                else if (msg.isChannelPressure())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    track->addEvent({.type = MidiEvent::Type::ChannelPressure,
-                                     .tick = static_cast<int>(msg.getTimeStamp()),
-                                     .data1 = msg.getChannelPressureValue()});
-                }
-                else if (msg.isAftertouch())
-                {
-                    if (!track)
-                    {
-                        track = &sequence.addTrack();
-                        track->setChannel(msg.getChannel());
-                    }
-
-                    track->addEvent({.type = MidiEvent::Type::KeyPressure,
-                                     .tick = static_cast<int>(msg.getTimeStamp()),
-                                     .data1 = msg.getNoteNumber(),
-                                     .data2 = msg.getAfterTouchValue()});
-                }
-            }
-
-            if (track && trackName.isNotEmpty())
-                track->setName(trackName.toStdString());
+            if (chunk.tracks[0].channel == 0)
+                continue;
+            trackNames.push_back(chunk.trackName);
+            tracks.push_back(std::move(chunk.tracks[0]));
         }
     }
+    decoded.clear();
+
+    // トラックの追加は先に済ませ、トラックごとに独立した詰め替えだけを並列に行う
+    for (size_t i = 0; i < tracks.size(); ++i)
+        sequence.addTrack();
+    runJobs(static_cast<int>(tracks.size()), numThreads,
+            [&](int i)
+            {
+                const auto index = static_cast<size_t>(i);
+                auto& track = sequence.getTrack(i);
+                fillTrack(track, tracks[index]);
+                if (trackNames[index].isNotEmpty())
+                    track.setName(trackNames[index].toStdString());
+            });
+
+    sequence.setTempoChanges(sortedByTick(std::move(meta.tempos)));
+    sequence.setTimeSignatureChanges(snapToBars(std::move(meta.timeSignatures), ppq));
+    sequence.setKeySignatureChanges(sortedByTick(std::move(meta.keySignatures)));
+    sequence.setChordChanges(sortedByTick(std::move(meta.chords)));
 
     if (sequence.getNumTracks() == 0)
         sequence.addTrack();
@@ -7,5 +7,8 @@ class MidiFileIO
 {
 public:
     static bool save(const MidiSequence& sequence, const juce::File& file);
-    static bool load(MidiSequence& sequence, const juce::File& file);
+    // Track chunks are decoded on up to numThreads threads (0 = one per core); small files and
+    // numThreads == 1 decode on the calling thread. Fails without touching sequence if the file has
+    // no header or any track chunk is truncated or corrupt.
+    static bool load(MidiSequence& sequence, const juce::File& file, int numThreads = 0);
 };
@@ -0,0 +1,319 @@
+#include "EventListView.h"
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+namespace
+{
+EventListItem::Kind kindOf(MidiEvent::Type type)
+{
+    switch (type)
+    {
+    case MidiEvent::Type::ControlChange:
+        return EventListItem::ControlChange;
+    case MidiEvent::Type::ProgramChange:
+        return EventListItem::ProgramChange;
+    case MidiEvent::Type::PitchBend:
+        return EventListItem::PitchBend;
+    case MidiEvent::Type::ChannelPressure:
+        return EventListItem::ChannelPressure;
+    case MidiEvent::Type::KeyPressure:
+        return EventListItem::KeyPressure;
+    }
+    return EventListItem::ControlChange;
+}
+
+template <typename Keys>
+auto firstAtOrAfter(const Keys& keys, int tick)
+{
+    return std::ranges::lower_bound(keys, tick, {}, [](const auto& key) { return key.tick; });
+}
+
+template <typename Keys>
+auto firstAfter(const Keys& keys, int tick)
+{
+    return std::ranges::upper_bound(keys, tick, {}, [](const auto& key) { return key.tick; });
+}
+} // namespace
+
+void EventListView::rebuild(const MidiSequence& seq, const std::set<int>& trackIndices)
+{
+    runs.clear();
+    for (int trackIndex : trackIndices)
+    {
+        if (trackIndex < 0 || trackIndex >= seq.getNumTracks())
+            continue;
+        runs.push_back({trackIndex, {}});
+        readTrack(seq, runs.back());
+    }
+    runsChanged();
+}
+
+void EventListView::rebuildTrack(const MidiSequence& seq, int trackIndex)
+{
+    if (auto* run = findRun(trackIndex); run != nullptr && trackIndex < seq.getNumTracks())
+    {
+        readTrack(seq, *run);
+        runsChanged();
+    }
+}
+
+void EventListView::patchNotes(const MidiSequence& seq, int trackIndex, int startTick, int endTick)
+{
+    auto* run = findRun(trackIndex);
+    if (run == nullptr || trackIndex >= seq.getNumTracks())
+        return;
+
+    // notifyNotesChanged inside a transaction covers the whole track and may have changed events too.
+    if (startTick <= 0 && endTick == INT_MAX)
+    {
+        readTrack(seq, *run);
+        runsChanged();
+        return;
+    }
+
+    if (endTick <= startTick)
+        return;
+
+    auto& keys = run->keys;
+    const auto first = std::distance(keys.cbegin(), firstAtOrAfter(keys, startTick));
+    const auto last = std::distance(keys.cbegin(), firstAtOrAfter(keys, endTick));
+
+    // The range's events stay; its notes come from the track's start-order index, so nothing outside
+    // the range is read or sorted.
+    patchedKeys.clear();
+    std::copy_if(keys.begin() + first, keys.begin() + last, std::back_inserter(patchedKeys),
+                 [](const Key& key) { return key.kind != EventListItem::Note; });
+    const auto& track = seq.getTrack(trackIndex);
+    track.findNotesStartingIn(startTick, endTick, patchedNoteIds);
+    for (const NoteId id : patchedNoteIds)
+        patchedKeys.push_back({track.getNote(id).startTick, EventListItem::Note, static_cast<int>(id)});
+    std::ranges::sort(patchedKeys);
+
+    // Edits that keep the range's size are overwritten in place; otherwise the tail shifts once.
+    const auto delta = static_cast<std::ptrdiff_t>(patchedKeys.size()) - (last - first);
+    if (delta > 0)
+        keys.insert(keys.begin() + last, static_cast<std::size_t>(delta), Key{});
+    else if (delta < 0)
+        keys.erase(keys.begin() + last + delta, keys.begin() + last);
+    std::ranges::copy(patchedKeys, keys.begin() + first);
+
+    numRows += static_cast<int>(delta);
+    if (tickRowsValid)
+        patchTickRows(startTick, endTick, static_cast<int>(delta));
+}
+
+EventListItem EventListView::getItem(const MidiSequence& seq, int row) const
+{
+    EventListItem result;
+    forEachItem(seq, row, row + 1, [&](const EventListItem& item) { result = item; });
+    return result;
+}
+
+int EventListView::findNoteRow(const MidiSequence& seq, int trackIndex, NoteId id) const
+{
+    const auto* run = findRun(trackIndex);
+    if (run == nullptr || trackIndex >= seq.getNumTracks() || !seq.getTrack(trackIndex).hasNote(id))
+        return -1;
+
+    const Key key{seq.getTrack(trackIndex).getNote(id).startTick, EventListItem::Note, static_cast<int>(id)};
+    const auto it = std::ranges::lower_bound(run->keys, key);
+    if (it == run->keys.end() || key < *it)
+        return -1;
+
+    // Rows at the same tick come from lower-numbered tracks first.
+    auto row = std::distance(run->keys.begin(), it);
+    for (const auto& other : runs)
+    {
+        if (other.trackIndex < trackIndex)
+            row += std::distance(other.keys.begin(), firstAfter(other.keys, key.tick));
+        else if (other.trackIndex > trackIndex)
+            row += std::distance(other.keys.begin(), firstAtOrAfter(other.keys, key.tick));
+    }
+    return static_cast<int>(row);
+}
+
+int EventListView::countRowsBefore(int tick) const
+{
+    ensureTickRows();
+    const auto it = std::ranges::lower_bound(tickRows, tick, {}, &TickRows::tick);
+    return it != tickRows.end() ? it->rowsBefore : numRows;
+}
+
+EventListView::Run* EventListView::findRun(int trackIndex)
+{
+    auto it = std::ranges::find(runs, trackIndex, &Run::trackIndex);
+    return it != runs.end() ? &*it : nullptr;
+}
+
+const EventListView::Run* EventListView::findRun(int trackIndex) const
+{
+    auto it = std::ranges::find(runs, trackIndex, &Run::trackIndex);
+    return it != runs.end() ? &*it : nullptr;
+}
+
+void EventListView::readTrack(const MidiSequence& seq, Run& run)
+{
+    const auto& track = seq.getTrack(run.trackIndex);
+    auto& keys = run.keys;
+    keys.clear();
+    keys.reserve(static_cast<std::size_t>(track.getNumNotes() + track.getNumEvents()));
+
+    const auto starts = track.getNotes().startTicks();
+    for (std::size_t slot = 0; slot < starts.size(); ++slot)
+        keys.push_back({starts[slot], EventListItem::Note, static_cast<int>(track.getNoteId(static_cast<int>(slot)))});
+    for (int i = 0; i < track.getNumEvents(); ++i)
+    {
+        const auto& event = track.getEvent(i);
+        keys.push_back({event.tick, kindOf(event.type), static_cast<int>(track.getEventId(i))});
+    }
+    std::ranges::sort(keys);
+}
+
+void EventListView::runsChanged()
+{
+    std::size_t total = 0;
+    for (const auto& run : runs)
+        total += run.keys.size();
+    numRows = static_cast<int>(total);
+    tickRowsValid = false;
+}
+
+void EventListView::ensureTickRows() const
+{
+    if (tickRowsValid)
+        return;
+    tickRows.clear();
+    countTickRows(INT_MIN, INT_MAX, 0, tickRows);
+    tickRowsValid = true;
+}
+
+// Merges the runs a tick at a time, taking every key on the smallest tick left from each run, and
+// appends an entry for each tick in [firstTick, lastTick].
+void EventListView::countTickRows(int firstTick, int lastTick, int rowsBefore, std::vector<TickRows>& out) const
+{
+    mergePositions.resize(runs.size());
+    for (std::size_t i = 0; i < runs.size(); ++i)
+        mergePositions[i] = static_cast<std::size_t>(
+            std::distance(runs[i].keys.begin(), firstAtOrAfter(runs[i].keys, firstTick)));
+
+    int rows = rowsBefore;
+    for (;;)
+    {
+        int tick = INT_MAX;
+        bool any = false;
+        for (std::size_t i = 0; i < runs.size(); ++i)
+        {
+            const auto& keys = runs[i].keys;
+            if (mergePositions[i] < keys.size() && keys[mergePositions[i]].tick <= lastTick)
+            {
+                tick = std::min(tick, keys[mergePositions[i]].tick);
+                any = true;
+            }
+        }
+        if (!any)
+            break;
+
+        out.push_back({tick, rows});
+        for (std::size_t i = 0; i < runs.size(); ++i)
+        {
+            const auto& keys = runs[i].keys;
+            for (; mergePositions[i] < keys.size() && keys[mergePositions[i]].tick == tick; ++mergePositions[i])
+                ++rows;
+        }
+    }
+}
+
+// Rows before startTick are unchanged, so only the entries for ticks in the range are recounted and
+// the ones after it shift by the change in rows.
+void EventListView::patchTickRows(int startTick, int endTick, int rowDelta)
+{
+    const auto first = std::ranges::lower_bound(tickRows, startTick, {}, &TickRows::tick);
+    const auto last = std::ranges::lower_bound(first, tickRows.end(), endTick, {}, &TickRows::tick);
+    const int rowsBefore = first != tickRows.end() ? first->rowsBefore : numRows - rowDelta;
+    const auto from = std::distance(tickRows.begin(), first);
+    const auto to = std::distance(tickRows.begin(), last);
+
+    patchedTickRows.clear();
+    countTickRows(startTick, endTick - 1, rowsBefore, patchedTickRows);
+
+    const auto delta = static_cast<std::ptrdiff_t>(patchedTickRows.size()) - (to - from);
+    if (delta > 0)
+        tickRows.insert(tickRows.begin() + to, static_cast<std::size_t>(delta), TickRows{});
+    else if (delta < 0)
+        tickRows.erase(tickRows.begin() + to + delta, tickRows.begin() + to);
+    std::ranges::copy(patchedTickRows, tickRows.begin() + from);
+
+    if (rowDelta != 0)
+        for (auto it = tickRows.begin() + to + delta; it != tickRows.end(); ++it)
+            it->rowsBefore += rowDelta;
+}
+
+std::vector<std::size_t>& EventListView::positionsAt(int row) const
+{
+    // The tick the row sits on is the last one with at most row rows before it.
+    ensureTickRows();
+    auto& positions = rowPositions;
+    positions.assign(runs.size(), 0);
+    const auto after = std::ranges::upper_bound(tickRows, row, {}, &TickRows::rowsBefore);
+    if (after == tickRows.begin())
+        return positions;
+    const auto& onTick = *std::prev(after);
+
+    // Rows on that tick go through the tracks in order; skip the ones before row.
+    auto remaining = static_cast<std::ptrdiff_t>(row - onTick.rowsBefore);
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const auto& keys = runs[i].keys;
+        const auto begin = std::distance(keys.begin(), firstAtOrAfter(keys, onTick.tick));
+        const auto count = std::distance(keys.begin(), firstAfter(keys, onTick.tick)) - begin;
+        const auto skipped = std::clamp<std::ptrdiff_t>(remaining, 0, count);
+        positions[i] = static_cast<std::size_t>(begin + skipped);
+        remaining -= skipped;
+    }
+    return positions;
+}
+
+std::size_t EventListView::nextRun(const std::vector<std::size_t>& positions) const
+{
+    std::size_t best = runs.size();
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        if (positions[i] < runs[i].keys.size() &&
+            (best == runs.size() || runs[i].keys[positions[i]].tick < runs[best].keys[positions[best]].tick))
+            best = i;
+    }
+    return best;
+}
+
+EventListItem EventListView::makeItem(const MidiSequence& seq, int trackIndex, const Key& key)
+{
+    EventListItem item;
+    item.kind = key.kind;
+    item.tick = key.tick;
+    item.trackIndex = trackIndex;
+
+    const auto& track = seq.getTrack(trackIndex);
+    if (key.kind == EventListItem::Note)
+    {
+        item.noteId = static_cast<NoteId>(key.id);
+        if (track.hasNote(item.noteId))
+        {
+            const auto note = track.getNote(item.noteId);
+            item.noteNumber = note.noteNumber;
+            item.duration = note.duration;
+            item.velocity = note.velocity;
+        }
+    }
+    else
+    {
+        item.eventId = static_cast<EventId>(key.id);
+        if (const int slot = track.findEventSlot(item.eventId); slot >= 0)
+        {
+            const auto& event = track.getEvent(slot);
+            item.data1 = event.data1;
+            item.data2 = event.data2;
+        }
+    }
+    return item;
+}
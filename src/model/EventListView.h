@@ -0,0 +1,122 @@
+#pragma once
+
+#include "MidiSequence.h"
+#include <compare>
+#include <cstddef>
+#include <set>
+#include <vector>
+
+struct EventListItem
+{
+    enum Kind
+    {
+        Note,
+        ControlChange,
+        ProgramChange,
+        PitchBend,
+        ChannelPressure,
+        KeyPressure
+    };
+
+    Kind kind = Note;
+    int tick = 0;
+    int trackIndex = 0;
+    NoteId noteId = NoteId::invalid;
+    EventId eventId = EventId::invalid;
+    int noteNumber = 0;
+    int duration = 0;
+    int velocity = 0;
+    int data1 = 0;
+    int data2 = 0;
+};
+
+// The event list's rows: the notes and events of a set of tracks ordered by tick, then track, then
+// kind. Each track keeps its own sorted run of (tick, kind, id) keys and rows are found by merging the
+// runs on demand, so nothing is stored per row beyond the key and an edit only touches its own run.
+// Row lookups go through a per-tick row count over all runs, built on the first lookup in O(n + d k)
+// for n rows, d distinct ticks and k shown tracks. Patches recount only their own ticks and shift the
+// counts after them, so editing a bar costs O(k log n + m + d) for m rows in the bar. Lookups reuse
+// scratch buffers, so only the thread that edits the view may query it.
+class EventListView
+{
+public:
+    void rebuild(const MidiSequence& seq, const std::set<int>& trackIndices);
+    // Re-reads one track's notes and events; ignored for tracks that aren't shown.
+    void rebuildTrack(const MidiSequence& seq, int trackIndex);
+    // Replaces the track's note rows starting in [startTick, endTick) with its current notes there.
+    void patchNotes(const MidiSequence& seq, int trackIndex, int startTick, int endTick);
+
+    int getNumRows() const { return numRows; }
+    // O(log d + k log n).
+    EventListItem getItem(const MidiSequence& seq, int row) const;
+    // Row of a shown note, or -1. O(k log n).
+    int findNoteRow(const MidiSequence& seq, int trackIndex, NoteId id) const;
+    // Number of rows before the first one at or after tick. O(log d).
+    int countRowsBefore(int tick) const;
+
+    // Calls fn(item) for rows [firstRow, endRow) in order, merging the runs one row at a time. fn must
+    // not query the view.
+    template <typename Fn>
+    void forEachItem(const MidiSequence& seq, int firstRow, int endRow, Fn&& fn) const
+    {
+        if (firstRow < 0 || firstRow >= endRow || firstRow >= numRows)
+            return;
+        auto& positions = positionsAt(firstRow);
+        for (int row = firstRow; row < endRow && row < numRows; ++row)
+        {
+            const std::size_t run = nextRun(positions);
+            fn(makeItem(seq, runs[run].trackIndex, runs[run].keys[positions[run]]));
+            ++positions[run];
+        }
+    }
+
+private:
+    struct Key
+    {
+        int tick;
+        EventListItem::Kind kind;
+        int id;
+
+        auto operator<=>(const Key&) const = default;
+    };
+
+    // One shown track; runs are kept in track order, which is also the tie-break between tracks.
+    struct Run
+    {
+        int trackIndex;
+        std::vector<Key> keys;
+    };
+
+    Run* findRun(int trackIndex);
+    const Run* findRun(int trackIndex) const;
+    void readTrack(const MidiSequence& seq, Run& run);
+    // Called after any run changes; recounts the rows and drops the tick index.
+    void runsChanged();
+    void ensureTickRows() const;
+    // A distinct tick in any run, with the number of rows on earlier ticks.
+    struct TickRows
+    {
+        int tick;
+        int rowsBefore;
+    };
+    void countTickRows(int firstTick, int lastTick, int rowsBefore, std::vector<TickRows>& out) const;
+    void patchTickRows(int startTick, int endTick, int rowDelta);
+
+    // Index into each run of the next key at or after row, in a buffer shared by every lookup.
+    std::vector<std::size_t>& positionsAt(int row) const;
+    // The run holding the smallest key at positions.
+    std::size_t nextRun(const std::vector<std::size_t>& positions) const;
+    static EventListItem makeItem(const MidiSequence& seq, int trackIndex, const Key& key);
+
+    std::vector<Run> runs;
+    int numRows = 0;
+    mutable std::vector<TickRows> tickRows;
+    mutable bool tickRowsValid = false;
+
+    // Scratch reused across calls so patches and lookups don't allocate.
+    std::vector<Key> patchedKeys;
+    std::vector<NoteId> patchedNoteIds;
+    std::vector<TickRows> patchedTickRows;
+    mutable std::vector<std::size_t> mergePositions;
+    mutable std::vector<std::size_t> rowPositions;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 struct MidiNote
 {
     int noteNumber = 60;
@@ -8,4 +10,11 @@ struct MidiNote
     int duration = 480;
 
     int endTick() const { return startTick + duration; }
+
+    // Tracks store pitch and velocity as 7-bit values. Edits clamp through this before recording a
+    // note for undo, so the recorded note is the one that ends up stored.
+    MidiNote clamped() const
+    {
+        return {std::clamp(noteNumber, 0, 127), std::clamp(velocity, 0, 127), startTick, duration};
+    }
 };
@@ -1,6 +1,7 @@
 #include "MidiSequence.h"
 #include <algorithm>
 #include <cctype>
+#include <limits>
 #include <ranges>
 
 namespace
@@ -14,6 +15,7 @@ MidiSequence::MidiSequence()
 {
     tempoChanges.push_back({0, 120.0});
     timeSignatureChanges.push_back({0, 4, 4});
+    rebuildTempoMap();
 }
 
 void MidiSequence::clear()
@@ -26,6 +28,8 @@ void MidiSequence::clear()
     keySignatureChanges.clear();
     chordChanges.clear();
     ticksPerQuarterNote = defaultTicksPerQuarterNote;
+    rebuildTempoMap();
+    barIndexValid = false;
 }
 
 MidiTrack& MidiSequence::addTrack()
@@ -64,12 +68,25 @@ bool MidiSequence::isAnySolo() const
     return std::ranges::any_of(tracks, [](const MidiTrack& track) { return track.isSolo(); });
 }
 
+int MidiSequence::getEndTick() const
+{
+    int endTick = 0;
+    for (const auto& track : tracks)
+    {
+        endTick = std::max(endTick, track.getLastEndTick());
+        for (const auto& event : track.getEvents())
+            endTick = std::max(endTick, event.tick + 1);
+    }
+    return endTick;
+}
+
 void MidiSequence::setBpm(double newBpm)
 {
     if (!tempoChanges.empty() && tempoChanges[0].tick == 0)
         tempoChanges[0].bpm = newBpm;
     else
         tempoChanges.insert(tempoChanges.begin(), {0, newBpm});
+    rebuildTempoMap();
 }
 
 double MidiSequence::getBpm() const
@@ -87,27 +104,24 @@ int MidiSequence::getTicksPerQuarterNote() const
 void MidiSequence::setTicksPerQuarterNote(int ppq)
 {
     ticksPerQuarterNote = ppq;
+    rebuildTempoMap();
+    barIndexValid = false;
 }
 
 double MidiSequence::getTempoAt(int tick) const
 {
-    auto reversed = std::views::reverse(tempoChanges);
-    auto it = std::ranges::find_if(reversed, [tick](const TempoChange& tc) { return tc.tick <= tick; });
-    return it != reversed.end() ? it->bpm : 120.0;
+    return tempoMap->getTempoAt(tick);
 }
 
 TempoChange MidiSequence::getTempoChangeAt(int tick) const
 {
-    auto reversed = std::views::reverse(tempoChanges);
-    auto it = std::ranges::find_if(reversed, [tick](const TempoChange& tc) { return tc.tick <= tick; });
-    return it != reversed.end() ? *it : TempoChange{0, 120.0};
+    return tempoMap->getTempoChangeAt(tick);
 }
 
 TimeSignatureChange MidiSequence::getTimeSignatureAt(int tick) const
 {
-    auto reversed = std::views::reverse(timeSignatureChanges);
-    auto it = std::ranges::find_if(reversed, [tick](const TimeSignatureChange& ts) { return ts.tick <= tick; });
-    return it != reversed.end() ? *it : TimeSignatureChange{0, 4, 4};
+    auto it = std::ranges::upper_bound(timeSignatureChanges, tick, {}, &TimeSignatureChange::tick);
+    return it != timeSignatureChanges.begin() ? *(it - 1) : TimeSignatureChange{0, 4, 4};
 }
 
 const std::vector<TempoChange>& MidiSequence::getTempoChanges() const
@@ -115,6 +129,16 @@ const std::vector<TempoChange>& MidiSequence::getTempoChanges() const
     return tempoChanges;
 }
 
+const std::shared_ptr<const TempoMap>& MidiSequence::getTempoMap() const
+{
+    return tempoMap;
+}
+
+void MidiSequence::rebuildTempoMap()
+{
+    tempoMap = std::make_shared<const TempoMap>(tempoChanges, ticksPerQuarterNote);
+}
+
 const std::vector<TimeSignatureChange>& MidiSequence::getTimeSignatureChanges() const
 {
     return timeSignatureChanges;
@@ -127,11 +151,13 @@ void MidiSequence::addTempoChange(int tick, double bpm)
         if (tc.tick == tick)
         {
             tc.bpm = bpm;
+            rebuildTempoMap();
             return;
         }
     }
     tempoChanges.push_back({tick, bpm});
     std::ranges::sort(tempoChanges, {}, &TempoChange::tick);
+    rebuildTempoMap();
 }
 
 void MidiSequence::addTimeSignatureChange(int tick, int num, int den)
@@ -172,6 +198,7 @@ void MidiSequence::addTimeSignatureChange(int tick, int num, int den)
         int barsFromPrev = bars[i] - bars[i - 1];
         timeSignatureChanges[i].tick = timeSignatureChanges[i - 1].tick + barsFromPrev * ticksPerBar;
     }
+    barIndexValid = false;
 }
 
 KeySignatureChange MidiSequence::getKeySignatureAt(int tick) const
@@ -220,11 +247,13 @@ void MidiSequence::addKeySignatureChange(int tick, int sharpsOrFlats, bool isMin
 void MidiSequence::setTempoChanges(std::vector<TempoChange> changes)
 {
     tempoChanges = std::move(changes);
+    rebuildTempoMap();
 }
 
 void MidiSequence::setTimeSignatureChanges(std::vector<TimeSignatureChange> changes)
 {
     timeSignatureChanges = std::move(changes);
+    barIndexValid = false;
 }
 
 void MidiSequence::setKeySignatureChanges(std::vector<KeySignatureChange> changes)
@@ -232,6 +261,11 @@ void MidiSequence::setKeySignatureChanges(std::vector<KeySignatureChange> change
     keySignatureChanges = std::move(changes);
 }
 
+void MidiSequence::setChordChanges(std::vector<ChordChange> changes)
+{
+    chordChanges = std::move(changes);
+}
+
 void MidiSequence::addChordChange(int tick, int chordRoot, int chordType, int bassRoot, int bassType)
 {
     for (auto& cc : chordChanges)
@@ -355,124 +389,63 @@ bool MidiSequence::keySignatureFromString(const std::string& text, int& sharpsOr
 
 double MidiSequence::ticksToSeconds(int ticks) const
 {
-    double seconds = 0.0;
-    int prevTick = 0;
-    double currentBpm = 120.0;
-
-    for (const auto& tc : tempoChanges)
-    {
-        if (tc.tick >= ticks)
-            break;
-
-        if (tc.tick > prevTick)
-        {
-            double ticksPerSecond = (currentBpm / 60.0) * ticksPerQuarterNote;
-            seconds += (tc.tick - prevTick) / ticksPerSecond;
-            prevTick = tc.tick;
-        }
-
-        currentBpm = tc.bpm;
-    }
-
-    double ticksPerSecond = (currentBpm / 60.0) * ticksPerQuarterNote;
-    seconds += (ticks - prevTick) / ticksPerSecond;
-
-    return seconds;
+    return tempoMap->ticksToSeconds(ticks);
 }
 
 int MidiSequence::secondsToTicks(double seconds) const
 {
-    double accSeconds = 0.0;
-    int prevTick = 0;
-    double currentBpm = 120.0;
+    return static_cast<int>(tempoMap->secondsToTicks(seconds));
+}
+
+const std::vector<MidiSequence::BarSection>& MidiSequence::getBarIndex() const
+{
+    if (barIndexValid)
+        return barIndex;
 
-    for (const auto& tc : tempoChanges)
+    // The first section always starts at tick 0; a change that falls mid-bar drops the partial bar.
+    barIndex.clear();
+    barIndex.reserve(timeSignatureChanges.size());
+    for (const auto& ts : timeSignatureChanges)
     {
-        double ticksPerSecond = (currentBpm / 60.0) * ticksPerQuarterNote;
-        double segmentSeconds = (tc.tick - prevTick) / ticksPerSecond;
-
-        if (accSeconds + segmentSeconds >= seconds)
+        const int ticksPerBeat = ticksPerQuarterNote * 4 / ts.denominator;
+        BarSection section{0, 1, ticksPerBeat * ts.numerator, ticksPerBeat};
+        if (!barIndex.empty())
         {
-            double remainingSeconds = seconds - accSeconds;
-            return prevTick + static_cast<int>(remainingSeconds * ticksPerSecond);
+            const auto& prev = barIndex.back();
+            section.startTick = ts.tick;
+            section.startBar = prev.startBar + (ts.tick - prev.startTick) / prev.ticksPerBar;
         }
-
-        accSeconds += segmentSeconds;
-        prevTick = tc.tick;
-        currentBpm = tc.bpm;
+        barIndex.push_back(section);
     }
-
-    double ticksPerSecond = (currentBpm / 60.0) * ticksPerQuarterNote;
-    double remainingSeconds = seconds - accSeconds;
-    return prevTick + static_cast<int>(remainingSeconds * ticksPerSecond);
+    barIndexValid = true;
+    return barIndex;
 }
 
 BarBeatTick MidiSequence::tickToBarBeatTick(int tick) const
 {
-    int bar = 1;
-    int pos = 0;
+    const auto& sections = getBarIndex();
+    if (sections.empty())
+        return {1, 1, 0};
 
-    for (size_t i = 0; i < timeSignatureChanges.size(); ++i)
-    {
-        const auto& ts = timeSignatureChanges[i];
-        int ticksPerBeat = ticksPerQuarterNote * 4 / ts.denominator;
-        int ticksPerBar = ticksPerBeat * ts.numerator;
-
-        int nextChangeTick = (i + 1 < timeSignatureChanges.size()) ? timeSignatureChanges[i + 1].tick : tick + 1;
-
-        if (tick < nextChangeTick)
-        {
-            int ticksInThisSection = tick - pos;
-            int barsInSection = ticksInThisSection / ticksPerBar;
-            int remainder = ticksInThisSection % ticksPerBar;
-            bar += barsInSection;
-            int beat = remainder / ticksPerBeat + 1;
-            int tickInBeat = remainder % ticksPerBeat;
-            return {bar, beat, tickInBeat};
-        }
-
-        int sectionTicks = nextChangeTick - pos;
-        int barsInSection = sectionTicks / ticksPerBar;
-        bar += barsInSection;
-        pos = nextChangeTick;
-    }
+    auto it = std::ranges::upper_bound(sections.begin() + 1, sections.end(), tick, {}, &BarSection::startTick);
+    const auto& section = *(it - 1);
 
-    return {bar, 1, 0};
+    const int ticksInSection = tick - section.startTick;
+    const int remainder = ticksInSection % section.ticksPerBar;
+    return {section.startBar + ticksInSection / section.ticksPerBar, remainder / section.ticksPerBeat + 1,
+            remainder % section.ticksPerBeat};
 }
 
 int MidiSequence::barStartToTick(int targetBar) const
 {
-    if (targetBar <= 1)
+    const auto& sections = getBarIndex();
+    if (targetBar <= 1 || sections.empty())
         return 0;
 
-    int bar = 1;
-    int pos = 0;
-
-    for (size_t i = 0; i < timeSignatureChanges.size(); ++i)
-    {
-        const auto& ts = timeSignatureChanges[i];
-        int ticksPerBeat = ticksPerQuarterNote * 4 / ts.denominator;
-        int ticksPerBar = ticksPerBeat * ts.numerator;
-
-        if (i + 1 < timeSignatureChanges.size())
-        {
-            int nextChangeTick = timeSignatureChanges[i + 1].tick;
-            int sectionTicks = nextChangeTick - pos;
-            int barsInSection = sectionTicks / ticksPerBar;
-
-            if (bar + barsInSection >= targetBar)
-                return pos + (targetBar - bar) * ticksPerBar;
-
-            bar += barsInSection;
-            pos = nextChangeTick;
-        }
-        else
-        {
-            return pos + (targetBar - bar) * ticksPerBar;
-        }
-    }
-
-    return 0;
+    // The section that ends at or after targetBar, counting from its own start.
+    auto it = std::ranges::lower_bound(sections.begin() + 1, sections.end(), targetBar, {}, &BarSection::startBar);
+    const auto& section = *(it - 1);
+    return section.startTick + (targetBar - section.startBar) * section.ticksPerBar;
 }
 
 int MidiSequence::barBeatTickToTick(int bar, int beat, int tickInBeat) const
@@ -498,8 +471,115 @@ void MidiSequence::removeListener(Listener* listener)
     listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
 }
 
+void MidiSequence::Listener::notesEdited(const std::vector<DirtyTickRange>& ranges)
+{
+    notesChanged(ranges.size() == 1 ? ranges.front().trackIndex : -1);
+}
+
+MidiSequence::Transaction::Transaction(MidiSequence& seq) : sequence(seq)
+{
+    ++sequence.transactionDepth;
+}
+
+MidiSequence::Transaction::~Transaction()
+{
+    commit();
+}
+
+NoteId MidiSequence::Transaction::addNote(int trackIndex, const MidiNote& note)
+{
+    sequence.markDirty(trackIndex, note);
+    return sequence.getTrack(trackIndex).addNote(note);
+}
+
+void MidiSequence::Transaction::restoreNote(int trackIndex, NoteId id, const MidiNote& note)
+{
+    sequence.markDirty(trackIndex, note);
+    sequence.getTrack(trackIndex).restoreNote(id, note);
+}
+
+void MidiSequence::Transaction::removeNote(int trackIndex, NoteId id)
+{
+    auto& track = sequence.getTrack(trackIndex);
+    if (!track.hasNote(id))
+        return;
+    sequence.markDirty(trackIndex, track.getNote(id));
+    track.removeNote(id);
+}
+
+void MidiSequence::Transaction::setNote(int trackIndex, NoteId id, const MidiNote& note)
+{
+    auto& track = sequence.getTrack(trackIndex);
+    if (!track.hasNote(id))
+        return;
+    sequence.markDirty(trackIndex, track.getNote(id));
+    sequence.markDirty(trackIndex, note);
+    track.setNote(id, note);
+}
+
+void MidiSequence::Transaction::setNoteVelocity(int trackIndex, NoteId id, int velocity)
+{
+    auto& track = sequence.getTrack(trackIndex);
+    if (!track.hasNote(id))
+        return;
+    sequence.markDirty(trackIndex, track.getNote(id));
+    track.setNoteVelocity(id, velocity);
+}
+
+void MidiSequence::Transaction::commit()
+{
+    if (committed)
+        return;
+    committed = true;
+
+    if (--sequence.transactionDepth > 0 || sequence.pendingRanges.empty())
+        return;
+
+    auto ranges = std::move(sequence.pendingRanges);
+    sequence.pendingRanges.clear();
+    std::ranges::sort(ranges, {}, &DirtyTickRange::trackIndex);
+
+    const auto snapshot = sequence.listeners;
+    for (auto* l : snapshot)
+        l->notesEdited(ranges);
+}
+
+void MidiSequence::markDirty(int trackIndex, int startTick, int endTick)
+{
+    for (auto& range : pendingRanges)
+    {
+        if (range.trackIndex == trackIndex)
+        {
+            range.startTick = std::min(range.startTick, startTick);
+            range.endTick = std::max(range.endTick, endTick);
+            return;
+        }
+    }
+    pendingRanges.push_back({trackIndex, startTick, endTick});
+}
+
+void MidiSequence::markDirty(int trackIndex, const MidiNote& note)
+{
+    markDirty(trackIndex, note.startTick, note.startTick + std::max(note.duration, 1));
+}
+
 void MidiSequence::notifyNotesChanged(int trackIndex)
 {
+    if (transactionDepth > 0)
+    {
+        constexpr int maxTick = std::numeric_limits<int>::max();
+        if (trackIndex >= 0)
+        {
+            markDirty(trackIndex, 0, maxTick);
+        }
+        else
+        {
+            for (int i = 0; i < getNumTracks(); ++i)
+                markDirty(i, 0, maxTick);
+        }
+        return;
+    }
+
     const auto snapshot = listeners;
     for (auto* l : snapshot)
         l->notesChanged(trackIndex);
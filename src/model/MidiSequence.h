@@ -1,15 +1,11 @@
 #pragma once
 
 #include "MidiTrack.h"
+#include "TempoMap.h"
+#include <memory>
 #include <string>
 #include <vector>
 
-struct TempoChange
-{
-    int tick;
-    double bpm;
-};
-
 struct TimeSignatureChange
 {
     int tick;
@@ -33,6 +29,14 @@ struct ChordChange
     int bassType;  // same as chordType, 0x7F=none
 };
 
+// Part of a track touched by an edit transaction, as a half-open tick range.
+struct DirtyTickRange
+{
+    int trackIndex;
+    int startTick;
+    int endTick;
+};
+
 struct BarBeatTick
 {
     int bar;  // 1-based
@@ -47,12 +51,39 @@ public:
     {
         virtual ~Listener() = default;
         virtual void notesChanged([[maybe_unused]] int trackIndex) {}
+        // Sent once when the outermost Transaction commits, with one range per touched track.
+        // Defaults to notesChanged for that track, or -1 when several tracks changed.
+        virtual void notesEdited(const std::vector<DirtyTickRange>& ranges);
         virtual void tracksChanged() {}
         virtual void tempoChanged() {}
         virtual void timelineMetadataChanged() {}
         virtual void sequenceReset() {}
     };
 
+    // Groups note edits so listeners hear about them once, on commit (or destruction). Nested
+    // transactions, and notifyNotesChanged calls made while one is open, fold into the outermost.
+    class Transaction
+    {
+    public:
+        explicit Transaction(MidiSequence& seq);
+        ~Transaction();
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        NoteId addNote(int trackIndex, const MidiNote& note);
+        void restoreNote(int trackIndex, NoteId id, const MidiNote& note);
+        void removeNote(int trackIndex, NoteId id);
+        void setNote(int trackIndex, NoteId id, const MidiNote& note);
+        void setNoteVelocity(int trackIndex, NoteId id, int velocity);
+
+        void commit();
+
+    private:
+        MidiSequence& sequence;
+        bool committed = false;
+    };
+
     MidiSequence(const MidiSequence&) = delete;
     MidiSequence& operator=(const MidiSequence&) = delete;
     MidiSequence(MidiSequence&&) = delete;
@@ -83,6 +114,8 @@ public:
     const MidiTrack& getTrack(int index) const;
     int getNumTracks() const;
     bool isAnySolo() const;
+    // One past the last tick any note or event occupies.
+    int getEndTick() const;
 
     void setBpm(double newBpm);
     double getBpm() const;
@@ -96,6 +129,8 @@ public:
     KeySignatureChange getKeySignatureAt(int tick) const;
 
     const std::vector<TempoChange>& getTempoChanges() const;
+    // Shared so playback snapshots can hold on to it without copying; replaced on every tempo edit.
+    const std::shared_ptr<const TempoMap>& getTempoMap() const;
     const std::vector<TimeSignatureChange>& getTimeSignatureChanges() const;
     const std::vector<KeySignatureChange>& getKeySignatureChanges() const;
     const std::vector<ChordChange>& getChordChanges() const;
@@ -108,6 +143,7 @@ public:
     void setTempoChanges(std::vector<TempoChange> changes);
     void setTimeSignatureChanges(std::vector<TimeSignatureChange> changes);
     void setKeySignatureChanges(std::vector<KeySignatureChange> changes);
+    void setChordChanges(std::vector<ChordChange> changes);
 
     static int normalizeSharpsOrFlats(int sharpsOrFlats);
     static std::string keySignatureToString(int sharpsOrFlats, bool isMinor);
@@ -128,5 +164,25 @@ private:
     std::vector<KeySignatureChange> keySignatureChanges;
     std::vector<ChordChange> chordChanges;
     int ticksPerQuarterNote = defaultTicksPerQuarterNote;
+    std::shared_ptr<const TempoMap> tempoMap;
     std::vector<Listener*> listeners;
+
+    // One entry per time signature section; rebuilt lazily after time signature or PPQ edits.
+    struct BarSection
+    {
+        int startTick;
+        int startBar;
+        int ticksPerBar;
+        int ticksPerBeat;
+    };
+    mutable std::vector<BarSection> barIndex;
+    mutable bool barIndexValid = false;
+
+    const std::vector<BarSection>& getBarIndex() const;
+    void rebuildTempoMap();
+    void markDirty(int trackIndex, int startTick, int endTick);
+    void markDirty(int trackIndex, const MidiNote& note);
+
+    int transactionDepth = 0;
+    std::vector<DirtyTickRange> pendingRanges;
 };
@@ -1,62 +1,371 @@
 #include "MidiTrack.h"
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <limits>
 
-void MidiTrack::addNote(const MidiNote& note)
+namespace
 {
-    notes.push_back(note);
+std::uint8_t toMidiByte(int value)
+{
+    return static_cast<std::uint8_t>(std::clamp(value, 0, 127));
+}
+
+int effectiveEnd(int startTick, int duration)
+{
+    return startTick + std::max(duration, 1);
+}
+} // namespace
+
+std::uint64_t MidiTrack::nextRevision()
+{
+    static std::atomic<std::uint64_t> counter{0};
+    return ++counter;
+}
+
+void MidiTrack::touch()
+{
+    revision = nextRevision();
+}
+
+MidiNote MidiTrack::NoteView::operator[](std::size_t index) const
+{
+    return {track->noteNumbers[index], track->velocities[index], track->startTicks[index], track->durations[index]};
+}
+
+NoteId MidiTrack::addNote(const MidiNote& note)
+{
+    // An id on the free list may have been revived by restoreNote since; those entries are dropped.
+    while (!freeNoteIds.empty() && hasNote(freeNoteIds.back()))
+        freeNoteIds.pop_back();
+
+    NoteId id;
+    if (freeNoteIds.empty())
+    {
+        id = static_cast<NoteId>(noteSlots.size());
+        noteSlots.push_back(-1);
+    }
+    else
+    {
+        id = freeNoteIds.back();
+        freeNoteIds.pop_back();
+    }
+    restoreNote(id, note);
+    return id;
+}
+
+void MidiTrack::restoreNote(NoteId id, const MidiNote& note)
+{
+    // Restoring a live id would leave its old slot orphaned with the same id.
+    if (hasNote(id))
+        return;
+
+    touch();
+    const auto index = static_cast<std::size_t>(id);
+    if (index >= noteSlots.size())
+        noteSlots.resize(index + 1, -1);
+    noteSlots[index] = static_cast<int>(startTicks.size());
+
+    startTicks.push_back(note.startTick);
+    durations.push_back(note.duration);
+    noteNumbers.push_back(toMidiByte(note.noteNumber));
+    velocities.push_back(toMidiByte(note.velocity));
+    noteIds.push_back(id);
+    insertIntoOrder(noteSlots[index]);
 }
 
-void MidiTrack::insertNote(int index, const MidiNote& note)
+// Moves the last note into the freed slot, so removal is O(1) and only that note's slot changes.
+void MidiTrack::removeNoteSlot(int slot)
 {
-    notes.insert(notes.begin() + index, note);
+    const auto s = static_cast<std::size_t>(slot);
+    const auto last = startTicks.size() - 1;
+    const auto freedId = noteIds[s];
+    eraseFromOrder(orderPositionOf(slot));
+    noteSlots[static_cast<std::size_t>(freedId)] = -1;
+    if (s != last)
+    {
+        startOrder[orderPositionOf(static_cast<int>(last))] = slot;
+        startTicks[s] = startTicks[last];
+        durations[s] = durations[last];
+        noteNumbers[s] = noteNumbers[last];
+        velocities[s] = velocities[last];
+        noteIds[s] = noteIds[last];
+        noteSlots[static_cast<std::size_t>(noteIds[s])] = slot;
+    }
+    startTicks.pop_back();
+    durations.pop_back();
+    noteNumbers.pop_back();
+    velocities.pop_back();
+    noteIds.pop_back();
+
+    // Undo can revive a freed id and free it again, leaving duplicates; compacting once the list
+    // outgrows the id table keeps it bounded at amortised O(log n) per removal.
+    freeNoteIds.push_back(freedId);
+    if (freeNoteIds.size() > 2 * noteSlots.size())
+    {
+        std::erase_if(freeNoteIds, [this](NoteId id) { return hasNote(id); });
+        std::sort(freeNoteIds.begin(), freeNoteIds.end());
+        freeNoteIds.erase(std::unique(freeNoteIds.begin(), freeNoteIds.end()), freeNoteIds.end());
+    }
 }
 
-void MidiTrack::removeNote(int index)
+void MidiTrack::removeNote(NoteId id)
 {
-    notes.erase(notes.begin() + index);
+    const int slot = slotOf(id);
+    if (slot < 0)
+        return;
+    touch();
+    removeNoteSlot(slot);
 }
 
 void MidiTrack::clear()
 {
-    notes.clear();
+    touch();
+    startTicks.clear();
+    durations.clear();
+    noteNumbers.clear();
+    velocities.clear();
+    noteIds.clear();
+    noteSlots.clear();
+    freeNoteIds.clear();
+    startOrder.clear();
+    maxEndTree.clear();
+    treeLeaves = 0;
     events.clear();
+    eventIds.clear();
+    std::fill(eventSlots.begin(), eventSlots.end(), -1);
+}
+
+MidiTrack::NoteView MidiTrack::getNotes() const
+{
+    return NoteView(*this);
 }
 
-void MidiTrack::sortByStartTime()
+NoteId MidiTrack::getNoteId(int slot) const
 {
-    std::sort(notes.begin(), notes.end(),
-              [](const MidiNote& a, const MidiNote& b) { return a.startTick < b.startTick; });
-    std::sort(events.begin(), events.end(), [](const MidiEvent& a, const MidiEvent& b) { return a.tick < b.tick; });
+    return noteIds[static_cast<std::size_t>(slot)];
 }
 
-const std::vector<MidiNote>& MidiTrack::getNotes() const
+int MidiTrack::getNumNotes() const
 {
-    return notes;
+    return static_cast<int>(startTicks.size());
 }
 
-MidiNote& MidiTrack::getNote(int index)
+int MidiTrack::slotOf(NoteId id) const
 {
-    return notes[index];
+    const auto index = static_cast<std::size_t>(id);
+    return (id != NoteId::invalid && index < noteSlots.size()) ? noteSlots[index] : -1;
 }
 
-const MidiNote& MidiTrack::getNote(int index) const
+bool MidiTrack::hasNote(NoteId id) const
 {
-    return notes[index];
+    return slotOf(id) >= 0;
 }
 
-int MidiTrack::getNumNotes() const
+MidiNote MidiTrack::getNote(NoteId id) const
+{
+    const int slot = slotOf(id);
+    assert(slot >= 0);
+    if (slot < 0)
+        return {};
+    return getNotes()[static_cast<std::size_t>(slot)];
+}
+
+void MidiTrack::setNote(NoteId id, const MidiNote& note)
+{
+    const int slot = slotOf(id);
+    assert(slot >= 0);
+    if (slot < 0)
+        return;
+    touch();
+    const auto s = static_cast<std::size_t>(slot);
+    const auto position = orderPositionOf(slot);
+    const bool moved = startTicks[s] != note.startTick;
+    startTicks[s] = note.startTick;
+    durations[s] = note.duration;
+    noteNumbers[s] = toMidiByte(note.noteNumber);
+    velocities[s] = toMidiByte(note.velocity);
+    if (moved)
+        moveInOrder(position);
+    else
+        refreshEndTree(position, position + 1);
+}
+
+void MidiTrack::setNoteVelocity(NoteId id, int velocity)
+{
+    const int slot = slotOf(id);
+    assert(slot >= 0);
+    if (slot < 0)
+        return;
+    touch();
+    velocities[static_cast<std::size_t>(slot)] = toMidiByte(velocity);
+}
+
+std::size_t MidiTrack::firstStartAtOrAfter(int tick) const
+{
+    const auto it = std::lower_bound(startOrder.begin(), startOrder.end(), tick,
+                                     [this](int slot, int t) { return startTicks[slot] < t; });
+    return static_cast<std::size_t>(it - startOrder.begin());
+}
+
+// Same-tick notes are few, so the slot is found by walking its tick's group.
+std::size_t MidiTrack::orderPositionOf(int slot) const
+{
+    auto position = firstStartAtOrAfter(startTicks[static_cast<std::size_t>(slot)]);
+    while (startOrder[position] != slot)
+        ++position;
+    return position;
+}
+
+void MidiTrack::insertIntoOrder(int slot)
+{
+    const int tick = startTicks[static_cast<std::size_t>(slot)];
+    const auto it = std::upper_bound(startOrder.begin(), startOrder.end(), tick,
+                                     [this](int t, int other) { return t < startTicks[other]; });
+    const auto position = static_cast<std::size_t>(it - startOrder.begin());
+    startOrder.insert(it, slot);
+    refreshEndTree(position, startOrder.size());
+}
+
+void MidiTrack::eraseFromOrder(std::size_t position)
+{
+    startOrder.erase(startOrder.begin() + static_cast<std::ptrdiff_t>(position));
+    refreshEndTree(position, startOrder.size() + 1);
+}
+
+// Moves the entry at position to where its new start tick belongs, behind any notes already there,
+// shifting only the entries in between.
+void MidiTrack::moveInOrder(std::size_t position)
+{
+    const auto begin = startOrder.begin();
+    const auto at = begin + static_cast<std::ptrdiff_t>(position);
+    const int tick = startTicks[static_cast<std::size_t>(*at)];
+    auto startsAfter = [this](int t, int other) { return t < startTicks[other]; };
+
+    if (at != begin && tick < startTicks[static_cast<std::size_t>(*(at - 1))])
+    {
+        const auto target = std::upper_bound(begin, at, tick, startsAfter);
+        std::rotate(target, at, at + 1);
+        refreshEndTree(static_cast<std::size_t>(target - begin), position + 1);
+    }
+    else
+    {
+        const auto target = std::upper_bound(at + 1, startOrder.end(), tick, startsAfter);
+        std::rotate(at, at + 1, target);
+        refreshEndTree(position, static_cast<std::size_t>(target - begin));
+    }
+}
+
+// Recomputes the leaves for order positions [first, last) and their ancestors. The tree doubles when
+// it runs out of leaves, so full rebuilds stay amortised O(1) per insert.
+void MidiTrack::refreshEndTree(std::size_t first, std::size_t last)
+{
+    const std::size_t n = startOrder.size();
+    if (n > treeLeaves)
+    {
+        treeLeaves = std::bit_ceil(n);
+        maxEndTree.assign(treeLeaves * 2, std::numeric_limits<int>::min());
+        first = 0;
+        last = n;
+    }
+    last = std::min(last, treeLeaves);
+    if (first >= last)
+        return;
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const auto slot = i < n ? static_cast<std::size_t>(startOrder[i]) : 0;
+        maxEndTree[treeLeaves + i] =
+            i < n ? effectiveEnd(startTicks[slot], durations[slot]) : std::numeric_limits<int>::min();
+    }
+    for (std::size_t lo = (treeLeaves + first) / 2, hi = (treeLeaves + last - 1) / 2; lo > 0; lo /= 2, hi /= 2)
+        for (std::size_t node = lo; node <= hi; ++node)
+            maxEndTree[node] = std::max(maxEndTree[node * 2], maxEndTree[node * 2 + 1]);
+}
+
+void MidiTrack::collectSounding(std::size_t node, std::size_t lo, std::size_t hi, std::size_t limit, int tick,
+                                int lowNote, int highNote, std::vector<NoteId>& result) const
 {
-    return static_cast<int>(notes.size());
+    if (lo >= limit || maxEndTree[node] <= tick)
+        return;
+    if (hi - lo == 1)
+    {
+        const auto slot = static_cast<std::size_t>(startOrder[lo]);
+        if (noteNumbers[slot] >= lowNote && noteNumbers[slot] <= highNote)
+            result.push_back(noteIds[slot]);
+        return;
+    }
+    const std::size_t mid = (lo + hi) / 2;
+    collectSounding(node * 2, lo, mid, limit, tick, lowNote, highNote, result);
+    collectSounding(node * 2 + 1, mid, hi, limit, tick, lowNote, highNote, result);
 }
 
-void MidiTrack::addEvent(const MidiEvent& event)
+void MidiTrack::findNotesInRange(int startTick, int endTick, std::vector<NoteId>& result, int lowNote,
+                                 int highNote) const
 {
+    result.clear();
+    if (startOrder.empty() || endTick <= startTick || highNote < lowNote)
+        return;
+
+    // Notes starting before the window only overlap it while still sounding at startTick, which the
+    // tree finds; every note starting inside it overlaps.
+    const auto first = firstStartAtOrAfter(startTick);
+    collectSounding(1, 0, treeLeaves, first, startTick, lowNote, highNote, result);
+    for (auto position = first; position < startOrder.size(); ++position)
+    {
+        const auto slot = static_cast<std::size_t>(startOrder[position]);
+        if (startTicks[slot] >= endTick)
+            break;
+        if (noteNumbers[slot] >= lowNote && noteNumbers[slot] <= highNote)
+            result.push_back(noteIds[slot]);
+    }
+}
+
+void MidiTrack::findNotesStartingIn(int startTick, int endTick, std::vector<NoteId>& result) const
+{
+    result.clear();
+    for (auto position = firstStartAtOrAfter(startTick); position < startOrder.size(); ++position)
+    {
+        const auto slot = static_cast<std::size_t>(startOrder[position]);
+        if (startTicks[slot] >= endTick)
+            break;
+        result.push_back(noteIds[slot]);
+    }
+}
+
+int MidiTrack::getLastEndTick() const
+{
+    int lastTick = 0;
+    for (std::size_t i = 0; i < startTicks.size(); ++i)
+        lastTick = std::max(lastTick, startTicks[i] + durations[i]);
+    return lastTick;
+}
+
+EventId MidiTrack::addEvent(const MidiEvent& event)
+{
+    touch();
+    const auto id = static_cast<EventId>(eventSlots.size());
+    eventSlots.push_back(static_cast<int>(events.size()));
     events.push_back(event);
+    eventIds.push_back(id);
+    return id;
 }
 
-void MidiTrack::removeEvent(int index)
+void MidiTrack::removeEvent(EventId id)
 {
-    events.erase(events.begin() + index);
+    const int slot = findEventSlot(id);
+    if (slot < 0)
+        return;
+    touch();
+    // Events are kept in the order they were added, which is the order same-tick events are saved in,
+    // so the later ones shift down rather than the last one filling the gap.
+    const auto s = static_cast<std::ptrdiff_t>(slot);
+    eventSlots[static_cast<std::size_t>(id)] = -1;
+    events.erase(events.begin() + s);
+    eventIds.erase(eventIds.begin() + s);
+    for (auto i = static_cast<std::size_t>(slot); i < eventIds.size(); ++i)
+        eventSlots[static_cast<std::size_t>(eventIds[i])] = static_cast<int>(i);
 }
 
 const std::vector<MidiEvent>& MidiTrack::getEvents() const
@@ -64,9 +373,20 @@ const std::vector<MidiEvent>& MidiTrack::getEvents() const
     return events;
 }
 
-const MidiEvent& MidiTrack::getEvent(int index) const
+const MidiEvent& MidiTrack::getEvent(int slot) const
 {
-    return events[index];
+    return events[static_cast<std::size_t>(slot)];
+}
+
+EventId MidiTrack::getEventId(int slot) const
+{
+    return eventIds[static_cast<std::size_t>(slot)];
+}
+
+int MidiTrack::findEventSlot(EventId id) const
+{
+    const auto index = static_cast<std::size_t>(id);
+    return (id != EventId::invalid && index < eventSlots.size()) ? eventSlots[index] : -1;
 }
 
 int MidiTrack::getNumEvents() const
@@ -74,6 +394,11 @@ int MidiTrack::getNumEvents() const
     return static_cast<int>(events.size());
 }
 
+std::uint64_t MidiTrack::getRevision() const
+{
+    return revision;
+}
+
 bool MidiTrack::isMuted() const
 {
     return muted;
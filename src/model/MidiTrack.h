@@ -2,12 +2,81 @@
 
 #include "MidiEvent.h"
 #include "MidiNote.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
 #include <string>
 #include <vector>
 
+// Stable handles to a note or event within its track. They survive edits to other notes and are kept
+// by copies of the track. A removed note's id may be handed to a later note; event ids are never reused.
+enum class NoteId : int
+{
+    invalid = -1
+};
+
+enum class EventId : int
+{
+    invalid = -1
+};
+
 class MidiTrack
 {
 public:
+    // Read-only view over the note columns. Elements are assembled into MidiNote values on access;
+    // range scans should use the column spans directly.
+    class NoteView
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = MidiNote;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = MidiNote;
+
+            Iterator() = default;
+            Iterator(const NoteView* v, std::size_t i) : view(v), index(i) {}
+
+            MidiNote operator*() const { return (*view)[index]; }
+            Iterator& operator++()
+            {
+                ++index;
+                return *this;
+            }
+            Iterator operator++(int)
+            {
+                auto old = *this;
+                ++index;
+                return old;
+            }
+            bool operator==(const Iterator& other) const { return index == other.index; }
+
+        private:
+            const NoteView* view = nullptr;
+            std::size_t index = 0;
+        };
+
+        explicit NoteView(const MidiTrack& t) : track(&t) {}
+
+        std::size_t size() const { return track->startTicks.size(); }
+        bool empty() const { return track->startTicks.empty(); }
+        MidiNote operator[](std::size_t index) const;
+        Iterator begin() const { return {this, 0}; }
+        Iterator end() const { return {this, size()}; }
+
+        std::span<const int> startTicks() const { return track->startTicks; }
+        std::span<const int> durations() const { return track->durations; }
+        std::span<const std::uint8_t> noteNumbers() const { return track->noteNumbers; }
+        std::span<const std::uint8_t> velocities() const { return track->velocities; }
+
+    private:
+        const MidiTrack* track;
+    };
+
     enum class OutputDestination
     {
         MidiDevice,
@@ -15,23 +84,46 @@ public:
         None
     };
 
-    void addNote(const MidiNote& note);
-    void insertNote(int index, const MidiNote& note);
-    void removeNote(int index);
+    NoteId addNote(const MidiNote& note);
+    // Re-adds a removed note under its original id, e.g. when undoing a delete. Does nothing if the
+    // id is still live.
+    void restoreNote(NoteId id, const MidiNote& note);
+    void removeNote(NoteId id);
     void clear();
-    void sortByStartTime();
 
-    const std::vector<MidiNote>& getNotes() const;
-    MidiNote& getNote(int index);
-    const MidiNote& getNote(int index) const;
+    // Slot order is arbitrary and changes on removal; use ids to refer to notes across edits.
+    NoteView getNotes() const;
+    // Every slot, ordered by start tick; notes on the same tick keep the order they got it in.
+    std::span<const int> getStartOrder() const { return startOrder; }
+    NoteId getNoteId(int slot) const;
     int getNumNotes() const;
+    int getLastEndTick() const;
+
+    bool hasNote(NoteId id) const;
+    MidiNote getNote(NoteId id) const;
+    void setNote(NoteId id, const MidiNote& note);
+    void setNoteVelocity(NoteId id, int velocity);
 
-    void addEvent(const MidiEvent& event);
-    void removeEvent(int index);
+    // Replaces result with the notes overlapping [startTick, endTick) with pitches in [lowNote,
+    // highNote], in start order. Zero-length notes count as one tick long. O(log n + k + j log n) for
+    // k notes starting in the window and j notes still sounding from before it.
+    void findNotesInRange(int startTick, int endTick, std::vector<NoteId>& result, int lowNote = 0,
+                          int highNote = 127) const;
+    // Replaces result with the notes starting in [startTick, endTick), in start order. O(log n + k).
+    void findNotesStartingIn(int startTick, int endTick, std::vector<NoteId>& result) const;
+
+    EventId addEvent(const MidiEvent& event);
+    void removeEvent(EventId id);
     const std::vector<MidiEvent>& getEvents() const;
-    const MidiEvent& getEvent(int index) const;
+    const MidiEvent& getEvent(int slot) const;
+    EventId getEventId(int slot) const;
+    int findEventSlot(EventId id) const;
     int getNumEvents() const;
 
+    // Bumped whenever notes or events change. Values are unique across tracks, so an equal revision
+    // implies equal contents (copies share it).
+    std::uint64_t getRevision() const;
+
     bool isMuted() const;
     void setMuted(bool muted);
 
@@ -51,12 +143,49 @@ public:
     void setRouteTargetTrackIndex(int index);
 
 private:
-    std::vector<MidiNote> notes;
+    static std::uint64_t nextRevision();
+    void touch();
+    int slotOf(NoteId id) const;
+    void removeNoteSlot(int slot);
+
+    std::size_t firstStartAtOrAfter(int tick) const;
+    std::size_t orderPositionOf(int slot) const;
+    void insertIntoOrder(int slot);
+    void eraseFromOrder(std::size_t position);
+    void moveInOrder(std::size_t position);
+    void refreshEndTree(std::size_t first, std::size_t last);
+    void collectSounding(std::size_t node, std::size_t lo, std::size_t hi, std::size_t limit, int tick, int lowNote,
+                         int highNote, std::vector<NoteId>& result) const;
+
+    // Notes are stored column-wise; pitch and velocity are 7-bit MIDI values.
+    std::vector<int> startTicks;
+    std::vector<int> durations;
+    std::vector<std::uint8_t> noteNumbers;
+    std::vector<std::uint8_t> velocities;
+    std::vector<NoteId> noteIds;
+    // id -> slot, -1 while free. Freed ids are handed out again, so the table only grows to the most
+    // notes the track has held at once. Undo only restores ids freed after the last add, so restoreNote
+    // always finds its id free.
+    //
+    // Per note this is 10 bytes of columns, plus 4 each for noteIds, noteSlots and startOrder and 8-16
+    // for maxEndTree: 30-38 bytes, against 16 for the note struct alone before the columns.
+    std::vector<int> noteSlots;
+    std::vector<NoteId> freeNoteIds;
+
+    // Slots in start order, and a max-end segment tree over that order so range queries can skip
+    // notes that ended before the window. Every edit updates both in place: a binary search finds the
+    // position, and only the tree leaves from there to where the order shifts are refreshed.
+    std::vector<int> startOrder;
+    std::vector<int> maxEndTree;
+    std::size_t treeLeaves = 0;
     std::vector<MidiEvent> events;
+    std::vector<EventId> eventIds;
+    std::vector<int> eventSlots;
     std::string name;
     bool muted = false;
     bool solo = false;
     int channel = 1;
     OutputDestination outputDestination = OutputDestination::MidiDevice;
     int routeTargetTrackIndex = -1;
+    std::uint64_t revision = nextRevision();
 };
@@ -0,0 +1,70 @@
+#include "TempoMap.h"
+#include "MidiSequence.h"
+#include <algorithm>
+
+namespace
+{
+double secondsPerTickAt(double bpm, int ticksPerQuarterNote)
+{
+    return 60.0 / (bpm * ticksPerQuarterNote);
+}
+} // namespace
+
+TempoMap::TempoMap() : TempoMap({}, MidiSequence::defaultTicksPerQuarterNote) {}
+
+TempoMap::TempoMap(std::vector<TempoChange> changes, int ppq) : ticksPerQuarterNote(ppq)
+{
+    std::ranges::stable_sort(changes, {}, &TempoChange::tick);
+
+    // Several changes on one tick collapse to the last, matching the order they are applied in.
+    segments.reserve(changes.size() + 1);
+    segments.push_back({0, defaultBpm, 0.0, secondsPerTickAt(defaultBpm, ppq)});
+    for (const auto& tc : changes)
+    {
+        auto& last = segments.back();
+        const int tick = std::max(tc.tick, 0);
+        if (tick == last.tick)
+        {
+            last.bpm = tc.bpm;
+            last.secondsPerTick = secondsPerTickAt(tc.bpm, ppq);
+            continue;
+        }
+        const double start = last.startSeconds + (tick - last.tick) * last.secondsPerTick;
+        segments.push_back({tick, tc.bpm, start, secondsPerTickAt(tc.bpm, ppq)});
+    }
+}
+
+const TempoMap::Segment& TempoMap::segmentAtTick(double tick) const
+{
+    auto it = std::ranges::upper_bound(segments, tick, {}, [](const Segment& s) { return static_cast<double>(s.tick); });
+    return it == segments.begin() ? segments.front() : *(it - 1);
+}
+
+const TempoMap::Segment& TempoMap::segmentAtSeconds(double seconds) const
+{
+    auto it = std::ranges::upper_bound(segments, seconds, {}, &Segment::startSeconds);
+    return it == segments.begin() ? segments.front() : *(it - 1);
+}
+
+double TempoMap::getTempoAt(int tick) const
+{
+    return segmentAtTick(tick).bpm;
+}
+
+TempoChange TempoMap::getTempoChangeAt(int tick) const
+{
+    const auto& segment = segmentAtTick(tick);
+    return {segment.tick, segment.bpm};
+}
+
+double TempoMap::ticksToSeconds(double tick) const
+{
+    const auto& segment = segmentAtTick(tick);
+    return segment.startSeconds + (tick - segment.tick) * segment.secondsPerTick;
+}
+
+double TempoMap::secondsToTicks(double seconds) const
+{
+    const auto& segment = segmentAtSeconds(seconds);
+    return segment.tick + (seconds - segment.startSeconds) / segment.secondsPerTick;
+}
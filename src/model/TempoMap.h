@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+struct TempoChange
+{
+    int tick;
+    double bpm;
+};
+
+// Tempo changes flattened into constant-tempo segments with the elapsed seconds at each segment start,
+// so tick/seconds conversions and tempo lookups are a binary search. Immutable once built; rebuilt on
+// every tempo edit. Before the first change the tempo is 120 bpm, and changes at or before tick 0
+// apply from tick 0.
+class TempoMap
+{
+public:
+    static constexpr double defaultBpm = 120.0;
+
+    TempoMap();
+    TempoMap(std::vector<TempoChange> changes, int ticksPerQuarterNote);
+
+    int getTicksPerQuarterNote() const { return ticksPerQuarterNote; }
+    int getNumSegments() const { return static_cast<int>(segments.size()); }
+
+    double getTempoAt(int tick) const;
+    // The change in effect at tick, or {0, bpm} for the implicit starting tempo.
+    TempoChange getTempoChangeAt(int tick) const;
+
+    double ticksToSeconds(double tick) const;
+    double secondsToTicks(double seconds) const;
+
+private:
+    struct Segment
+    {
+        int tick;
+        double bpm;
+        double startSeconds;
+        double secondsPerTick;
+    };
+
+    const Segment& segmentAtTick(double tick) const;
+    const Segment& segmentAtSeconds(double seconds) const;
+
+    std::vector<Segment> segments;
+    int ticksPerQuarterNote;
+};
@@ -4,63 +4,62 @@
 #include <juce_data_structures/juce_data_structures.h>
 #include <algorithm>
 #include <functional>
-#include <map>
 #include <vector>
 
 class NoteAddAction : public juce::UndoableAction
 {
 public:
     NoteAddAction(MidiSequence* seq, int trackIndex, const MidiNote& note)
-        : sequence(seq), trackIdx(trackIndex), note(note)
+        : sequence(seq), trackIdx(trackIndex), note(note.clamped())
     {
     }
 
     bool perform() override
     {
-        sequence->getTrack(trackIdx).addNote(note);
-        addedIndex = sequence->getTrack(trackIdx).getNumNotes() - 1;
-        sequence->notifyNotesChanged(trackIdx);
+        // Redo restores the original id so later actions that refer to it stay valid.
+        MidiSequence::Transaction edit(*sequence);
+        if (addedId == NoteId::invalid)
+            addedId = edit.addNote(trackIdx, note);
+        else
+            edit.restoreNote(trackIdx, addedId, note);
         return true;
     }
 
     bool undo() override
     {
-        sequence->getTrack(trackIdx).removeNote(addedIndex);
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction(*sequence).removeNote(trackIdx, addedId);
         return true;
     }
 
     int getSizeInUnits() override { return 1; }
 
-    int getAddedIndex() const { return addedIndex; }
+    NoteId getAddedId() const { return addedId; }
 
 private:
     MidiSequence* sequence;
     int trackIdx;
     MidiNote note;
-    int addedIndex = -1;
+    NoteId addedId = NoteId::invalid;
 };
 
 class NoteDeleteAction : public juce::UndoableAction
 {
 public:
-    NoteDeleteAction(MidiSequence* seq, int trackIndex, int noteIndex)
-        : sequence(seq), trackIdx(trackIndex), noteIdx(noteIndex)
+    NoteDeleteAction(MidiSequence* seq, int trackIndex, NoteId noteId)
+        : sequence(seq), trackIdx(trackIndex), noteId(noteId)
     {
     }
 
     bool perform() override
     {
-        deletedNote = sequence->getTrack(trackIdx).getNote(noteIdx);
-        sequence->getTrack(trackIdx).removeNote(noteIdx);
-        sequence->notifyNotesChanged(trackIdx);
+        deletedNote = sequence->getTrack(trackIdx).getNote(noteId);
+        MidiSequence::Transaction(*sequence).removeNote(trackIdx, noteId);
         return true;
     }
 
     bool undo() override
     {
-        sequence->getTrack(trackIdx).insertNote(noteIdx, deletedNote);
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction(*sequence).restoreNote(trackIdx, noteId, deletedNote);
         return true;
     }
 
@@ -69,31 +68,27 @@ public:
 private:
     MidiSequence* sequence;
     int trackIdx;
-    int noteIdx;
+    NoteId noteId;
     MidiNote deletedNote;
 };
 
 class NoteModifyAction : public juce::UndoableAction
 {
 public:
-    NoteModifyAction(MidiSequence* seq, int trackIndex, int noteIndex, const MidiNote& before, const MidiNote& after)
-        : sequence(seq), trackIdx(trackIndex), noteIdx(noteIndex), beforeNote(before), afterNote(after)
+    NoteModifyAction(MidiSequence* seq, int trackIndex, NoteId noteId, const MidiNote& before, const MidiNote& after)
+        : sequence(seq), trackIdx(trackIndex), noteId(noteId), beforeNote(before.clamped()), afterNote(after.clamped())
     {
     }
 
     bool perform() override
     {
-        auto& note = sequence->getTrack(trackIdx).getNote(noteIdx);
-        note = afterNote;
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction(*sequence).setNote(trackIdx, noteId, afterNote);
         return true;
     }
 
     bool undo() override
     {
-        auto& note = sequence->getTrack(trackIdx).getNote(noteIdx);
-        note = beforeNote;
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction(*sequence).setNote(trackIdx, noteId, beforeNote);
         return true;
     }
 
@@ -102,7 +97,7 @@ public:
 private:
     MidiSequence* sequence;
     int trackIdx;
-    int noteIdx;
+    NoteId noteId;
     MidiNote beforeNote;
     MidiNote afterNote;
 };
@@ -110,7 +105,7 @@ private:
 struct NoteModification
 {
     int trackIndex;
-    int noteIndex;
+    NoteId noteId;
     MidiNote before;
     MidiNote after;
 };
@@ -120,21 +115,26 @@ class MultiNoteModifyAction : public juce::UndoableAction
 public:
     MultiNoteModifyAction(MidiSequence* seq, std::vector<NoteModification> mods) : sequence(seq), mods(std::move(mods))
     {
+        for (auto& m : this->mods)
+        {
+            m.before = m.before.clamped();
+            m.after = m.after.clamped();
+        }
     }
 
     bool perform() override
     {
+        MidiSequence::Transaction edit(*sequence);
         for (const auto& m : mods)
-            sequence->getTrack(m.trackIndex).getNote(m.noteIndex) = m.after;
-        sequence->notifyNotesChanged(-1);
+            edit.setNote(m.trackIndex, m.noteId, m.after);
         return true;
     }
 
     bool undo() override
     {
+        MidiSequence::Transaction edit(*sequence);
         for (const auto& m : mods)
-            sequence->getTrack(m.trackIndex).getNote(m.noteIndex) = m.before;
-        sequence->notifyNotesChanged(-1);
+            edit.setNote(m.trackIndex, m.noteId, m.before);
         return true;
     }
 
@@ -148,7 +148,7 @@ private:
 struct DeletedNoteInfo
 {
     int trackIndex;
-    int noteIndex;
+    NoteId noteId;
     MidiNote note;
 };
 
@@ -158,33 +158,23 @@ public:
     template <typename NoteRefSet>
     MultiNoteDeleteAction(MidiSequence* seq, const NoteRefSet& selectedNotes) : sequence(seq)
     {
-        std::map<int, std::vector<int>> byTrack;
         for (const auto& ref : selectedNotes)
-            byTrack[ref.trackIndex].push_back(ref.noteIndex);
-
-        for (auto& [trackIdx, indices] : byTrack)
-            std::sort(indices.begin(), indices.end(), std::greater<int>());
-
-        for (const auto& [trackIdx, indices] : byTrack)
-        {
-            for (int idx : indices)
-                deletedNotes.push_back({trackIdx, idx, seq->getTrack(trackIdx).getNote(idx)});
-        }
+            deletedNotes.push_back({ref.trackIndex, ref.noteId, seq->getTrack(ref.trackIndex).getNote(ref.noteId)});
     }
 
     bool perform() override
     {
+        MidiSequence::Transaction edit(*sequence);
         for (const auto& info : deletedNotes)
-            sequence->getTrack(info.trackIndex).removeNote(info.noteIndex);
-        sequence->notifyNotesChanged(-1);
+            edit.removeNote(info.trackIndex, info.noteId);
         return true;
     }
 
     bool undo() override
     {
-        for (auto it = deletedNotes.rbegin(); it != deletedNotes.rend(); ++it)
-            sequence->getTrack(it->trackIndex).insertNote(it->noteIndex, it->note);
-        sequence->notifyNotesChanged(-1);
+        MidiSequence::Transaction edit(*sequence);
+        for (const auto& info : deletedNotes)
+            edit.restoreNote(info.trackIndex, info.noteId, info.note);
         return true;
     }
 
@@ -201,42 +191,48 @@ public:
     MultiNoteAddAction(MidiSequence* seq, int trackIndex, const std::vector<MidiNote>& notesToAdd)
         : sequence(seq), trackIdx(trackIndex), notes(notesToAdd)
     {
+        for (auto& note : notes)
+            note = note.clamped();
     }
 
     bool perform() override
     {
-        auto& track = sequence->getTrack(trackIdx);
-        addedStartIndex = track.getNumNotes();
-        for (const auto& note : notes)
-            track.addNote(note);
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction edit(*sequence);
+        if (addedIds.empty())
+        {
+            for (const auto& note : notes)
+                addedIds.push_back(edit.addNote(trackIdx, note));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < notes.size(); ++i)
+                edit.restoreNote(trackIdx, addedIds[i], notes[i]);
+        }
         return true;
     }
 
     bool undo() override
     {
-        auto& track = sequence->getTrack(trackIdx);
-        for (int i = static_cast<int>(notes.size()) - 1; i >= 0; --i)
-            track.removeNote(addedStartIndex + i);
-        sequence->notifyNotesChanged(trackIdx);
+        MidiSequence::Transaction edit(*sequence);
+        for (NoteId id : addedIds)
+            edit.removeNote(trackIdx, id);
         return true;
     }
 
     int getSizeInUnits() override { return static_cast<int>(notes.size()); }
 
-    int getAddedStartIndex() const { return addedStartIndex; }
-    int getAddedCount() const { return static_cast<int>(notes.size()); }
+    const std::vector<NoteId>& getAddedIds() const { return addedIds; }
 
 private:
     MidiSequence* sequence;
     int trackIdx;
     std::vector<MidiNote> notes;
-    int addedStartIndex = 0;
+    std::vector<NoteId> addedIds;
 };
 
 struct VelocityChange
 {
-    int noteIndex;
+    NoteId noteId;
     int oldVelocity;
     int newVelocity;
 };
@@ -535,23 +531,23 @@ public:
     VelocityEditAction(MidiSequence* seq, int trackIndex, std::vector<VelocityChange> changes)
         : sequence(seq), trackIdx(trackIndex), changes(std::move(changes))
     {
+        for (auto& c : this->changes)
+            c.newVelocity = std::clamp(c.newVelocity, 0, 127);
     }
 
     bool perform() override
     {
-        auto& track = sequence->getTrack(trackIdx);
+        MidiSequence::Transaction edit(*sequence);
         for (const auto& c : changes)
-            track.getNote(c.noteIndex).velocity = c.newVelocity;
-        sequence->notifyNotesChanged(trackIdx);
+            edit.setNoteVelocity(trackIdx, c.noteId, c.newVelocity);
         return true;
     }
 
     bool undo() override
     {
-        auto& track = sequence->getTrack(trackIdx);
+        MidiSequence::Transaction edit(*sequence);
         for (const auto& c : changes)
-            track.getNote(c.noteIndex).velocity = c.oldVelocity;
-        sequence->notifyNotesChanged(trackIdx);
+            edit.setNoteVelocity(trackIdx, c.noteId, c.oldVelocity);
         return true;
     }
 
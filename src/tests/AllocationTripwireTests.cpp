@@ -0,0 +1,69 @@
+#include "../engine/AllocationTripwire.h"
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <new>
+
+#if JUCE_DEBUG
+
+// Each armed heap operation also raises a debug assertion; these tests only check that it was caught.
+class AllocationTripwireTests : public juce::UnitTest
+{
+public:
+    AllocationTripwireTests() : juce::UnitTest("Allocation tripwire", "Engine") {}
+
+    void runTest() override
+    {
+        // The operators are called directly: unlike new-expressions, those calls cannot be elided.
+        beginTest("the heap is free to use while the tripwire is not armed");
+        {
+            const int before = ScopedAllocationTripwire::getNumTrips();
+            ::operator delete(::operator new(8));
+            expectEquals(ScopedAllocationTripwire::getNumTrips(), before);
+        }
+
+        beginTest("plain and array forms trip");
+        expectTrips(2, [] { ::operator delete(::operator new(8)); });
+        expectTrips(2, [] { ::operator delete[](::operator new[](8)); });
+        expectTrips(2, [] { ::operator delete(::operator new(8), 8); });
+
+        beginTest("nothrow forms trip");
+        expectTrips(2, [] { ::operator delete(::operator new(8, std::nothrow), std::nothrow); });
+        expectTrips(2, [] { ::operator delete[](::operator new[](8, std::nothrow), std::nothrow); });
+
+        beginTest("over-aligned forms trip and honour the alignment");
+        {
+            constexpr std::align_val_t alignment{128};
+            void* p = nullptr;
+            expectTrips(1, [&] { p = ::operator new(8, alignment); });
+            expect(reinterpret_cast<std::uintptr_t>(p) % 128 == 0);
+            expectTrips(1, [&] { ::operator delete(p, alignment); });
+
+            expectTrips(2, [] { ::operator delete[](::operator new[](8, alignment), alignment); });
+            expectTrips(2, [] { ::operator delete(::operator new(8, alignment), 8, alignment); });
+            expectTrips(2,
+                        [] { ::operator delete(::operator new(8, alignment, std::nothrow), alignment, std::nothrow); });
+            expectTrips(2,
+                        []
+                        {
+                            ::operator delete[](::operator new[](8, alignment, std::nothrow), alignment,
+                                                std::nothrow);
+                        });
+        }
+    }
+
+private:
+    template <typename Fn>
+    void expectTrips(int expected, Fn&& fn)
+    {
+        const int before = ScopedAllocationTripwire::getNumTrips();
+        {
+            [[maybe_unused]] ScopedAllocationTripwire tripwire;
+            fn();
+        }
+        expectEquals(ScopedAllocationTripwire::getNumTrips() - before, expected);
+    }
+};
+
+static AllocationTripwireTests allocationTripwireTests;
+
+#endif
@@ -0,0 +1,167 @@
+#include "../model/EventListView.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+struct Row
+{
+    int tick;
+    int trackIndex;
+    int kind;
+    int id;
+
+    auto operator<=>(const Row&) const = default;
+};
+
+// The rows of the shown tracks sorted from scratch, the order the view keeps by merging.
+std::vector<Row> sortedRows(const MidiSequence& seq, const std::set<int>& shown)
+{
+    std::vector<Row> rows;
+    for (int t : shown)
+    {
+        const auto& track = seq.getTrack(t);
+        const auto starts = track.getNotes().startTicks();
+        for (std::size_t slot = 0; slot < starts.size(); ++slot)
+        {
+            const auto id = track.getNoteId(static_cast<int>(slot));
+            rows.push_back({starts[slot], t, EventListItem::Note, static_cast<int>(id)});
+        }
+        for (int i = 0; i < track.getNumEvents(); ++i)
+            rows.push_back({track.getEvent(i).tick, t, EventListItem::ControlChange,
+                            static_cast<int>(track.getEventId(i))});
+    }
+    std::ranges::sort(rows);
+    return rows;
+}
+
+Row rowOf(const EventListItem& item)
+{
+    const int id = item.kind == EventListItem::Note ? static_cast<int>(item.noteId) : static_cast<int>(item.eventId);
+    return {item.tick, item.trackIndex, item.kind, id};
+}
+
+void fillTracks(MidiSequence& seq, int numTracks, int notesPerTrack, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    for (int t = 0; t < numTracks; ++t)
+    {
+        auto& track = seq.addTrack();
+        for (int i = 0; i < notesPerTrack; ++i)
+            track.addNote({static_cast<int>(36 + rng() % 48), 100, static_cast<int>(rng() % 2000), 60});
+        for (int i = 0; i < notesPerTrack / 4; ++i)
+            track.addEvent({MidiEvent::Type::ControlChange, static_cast<int>(rng() % 2000), 7, 64});
+    }
+}
+} // namespace
+
+class EventListViewTests : public juce::UnitTest
+{
+public:
+    EventListViewTests() : juce::UnitTest("EventListView rows", "Model") {}
+
+    void runTest() override
+    {
+        beginTest("rows and row counts match a full sort");
+        {
+            MidiSequence seq;
+            fillTracks(seq, 4, 500, 3);
+            const std::set<int> shown{0, 2, 3};
+            EventListView view;
+            view.rebuild(seq, shown);
+            expectRowsMatch(seq, view, shown);
+        }
+
+        beginTest("patching a tick range matches a full rebuild");
+        {
+            MidiSequence seq;
+            fillTracks(seq, 3, 400, 4);
+            const std::set<int> shown{0, 1, 2};
+            EventListView view;
+            view.rebuild(seq, shown);
+
+            std::mt19937 rng(5);
+            auto& track = seq.getTrack(1);
+            for (int edit = 0; edit < 50; ++edit)
+            {
+                const auto slot = static_cast<int>(rng() % static_cast<unsigned int>(track.getNumNotes()));
+                const auto id = track.getNoteId(slot);
+                auto note = track.getNote(id);
+                const int from = note.startTick;
+                note.startTick = static_cast<int>(rng() % 2000);
+                track.setNote(id, note);
+                view.patchNotes(seq, 1, std::min(from, note.startTick), std::max(from, note.startTick) + 1);
+            }
+            const int added = static_cast<int>(track.addNote({60, 100, 1000, 10}));
+            view.patchNotes(seq, 1, 1000, 1001);
+            expectRowsMatch(seq, view, shown);
+            expect(view.getItem(seq, view.findNoteRow(seq, 1, static_cast<NoteId>(added))).noteId
+                   == static_cast<NoteId>(added));
+        }
+
+        beginTest("patches keep the row counts of a queried view in step");
+        {
+            MidiSequence seq;
+            fillTracks(seq, 3, 300, 6);
+            const std::set<int> shown{0, 1, 2};
+            EventListView view;
+            view.rebuild(seq, shown);
+
+            // Querying after every patch keeps the tick index live, so each patch updates it in place;
+            // adds and removes make ticks appear and disappear.
+            std::mt19937 rng(7);
+            auto& track = seq.getTrack(2);
+            bool allMatched = true;
+            for (int edit = 0; edit < 300 && allMatched; ++edit)
+            {
+                const int tick = static_cast<int>(rng() % 2000);
+                std::vector<NoteId> ids;
+                track.findNotesStartingIn(tick, tick + 50, ids);
+                if (rng() % 2 == 0 || ids.empty())
+                    track.addNote({60, 100, tick + static_cast<int>(rng() % 50), 10});
+                else
+                    track.removeNote(ids[rng() % ids.size()]);
+                view.patchNotes(seq, 2, tick, tick + 50);
+
+                const auto expected = sortedRows(seq, shown);
+                const int row = static_cast<int>(rng() % expected.size());
+                const int probe = static_cast<int>(rng() % 2002) - 1;
+                const auto before = std::ranges::lower_bound(expected, probe, {}, &Row::tick) - expected.begin();
+                allMatched = view.getNumRows() == static_cast<int>(expected.size())
+                             && rowOf(view.getItem(seq, row)) == expected[static_cast<std::size_t>(row)]
+                             && view.countRowsBefore(probe) == static_cast<int>(before);
+            }
+            expect(allMatched, "a patched view differs from a full sort");
+            expectRowsMatch(seq, view, shown);
+        }
+    }
+
+private:
+    void expectRowsMatch(const MidiSequence& seq, const EventListView& view, const std::set<int>& shown)
+    {
+        const auto expected = sortedRows(seq, shown);
+        expectEquals(view.getNumRows(), static_cast<int>(expected.size()));
+
+        std::vector<Row> merged;
+        view.forEachItem(seq, 0, view.getNumRows(), [&](const EventListItem& item) { merged.push_back(rowOf(item)); });
+        expect(merged == expected, "merged rows differ from a full sort");
+
+        bool itemsMatch = true;
+        for (std::size_t row = 0; row < expected.size(); row += 7)
+            itemsMatch = itemsMatch && rowOf(view.getItem(seq, static_cast<int>(row))) == expected[row];
+        expect(itemsMatch, "getItem differs from a full sort");
+
+        bool countsMatch = true;
+        for (int tick = -1; tick <= 2001; ++tick)
+        {
+            const auto before = std::ranges::lower_bound(expected, tick, {}, &Row::tick) - expected.begin();
+            countsMatch = countsMatch && view.countRowsBefore(tick) == static_cast<int>(before);
+        }
+        expect(countsMatch, "countRowsBefore differs from a full sort");
+    }
+};
+
+static EventListViewTests eventListViewTests;
@@ -0,0 +1,320 @@
+#include "../io/MidiFileIO.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+std::vector<std::tuple<int, int, int, int>> sortedNotes(const MidiTrack& track)
+{
+    std::vector<std::tuple<int, int, int, int>> notes;
+    for (const auto note : track.getNotes())
+        notes.emplace_back(note.startTick, note.noteNumber, note.duration, note.velocity);
+    std::ranges::sort(notes);
+    return notes;
+}
+
+std::vector<std::tuple<int, int, int, int>> sortedEvents(const MidiTrack& track)
+{
+    std::vector<std::tuple<int, int, int, int>> events;
+    for (const auto& event : track.getEvents())
+        events.emplace_back(event.tick, static_cast<int>(event.type), event.data1, event.data2);
+    std::ranges::sort(events);
+    return events;
+}
+
+// Two tracks on different channels with every kind of data the loader understands.
+void buildTestSequence(MidiSequence& seq)
+{
+    seq.setTicksPerQuarterNote(960);
+    seq.setBpm(100.0);
+    seq.addTempoChange(3840, 150.0);
+    seq.addTempoChange(7680, 96.0);
+    seq.addTimeSignatureChange(3840, 3, 4);
+    seq.addKeySignatureChange(0, -3, true);
+    seq.addKeySignatureChange(3840, 2, false);
+    seq.addChordChange(0, 0x31, 0, 0x7F, 0x7F);
+    seq.addChordChange(1920, 0x35, 12, 0x31, 0);
+
+    auto& piano = seq.addTrack();
+    piano.setName("ピアノ");
+    piano.setChannel(1);
+    piano.addNote({60, 100, 0, 480});
+    piano.addNote({64, 90, 0, 480});
+    piano.addNote({67, 80, 0, 960});
+    piano.addNote({60, 70, 480, 480}); // starts where the first note of the same pitch ends
+    piano.addNote({72, 127, 5000, 1});
+    piano.addEvent({MidiEvent::Type::ProgramChange, 0, 5, 0});
+    piano.addEvent({MidiEvent::Type::ControlChange, 0, 7, 100});
+    piano.addEvent({MidiEvent::Type::ControlChange, 240, 64, 127});
+    piano.addEvent({MidiEvent::Type::PitchBend, 480, 8192 + 1000, 0});
+    piano.addEvent({MidiEvent::Type::ChannelPressure, 720, 33, 0});
+    piano.addEvent({MidiEvent::Type::KeyPressure, 720, 64, 20});
+
+    auto& drums = seq.addTrack();
+    drums.setName("Drums");
+    drums.setChannel(10);
+    for (int i = 0; i < 64; ++i)
+        drums.addNote({36 + (i % 3) * 2, 100 - i, i * 240, 120});
+}
+
+// Enough tracks and notes that the track chunks exceed the loader's per-thread minimum several times over.
+void buildRandomSequence(MidiSequence& seq, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    seq.setTicksPerQuarterNote(480);
+    for (int i = 1; i <= 50; ++i)
+        seq.addTempoChange(static_cast<int>(rng() % 200000), 40.0 + rng() % 200);
+    for (int t = 0; t < 16; ++t)
+    {
+        auto& track = seq.addTrack();
+        track.setName("Track " + std::to_string(t + 1));
+        track.setChannel(t + 1);
+        for (int i = 0; i < 8000; ++i)
+            track.addNote({static_cast<int>(rng() % 128), static_cast<int>(1 + rng() % 127),
+                           static_cast<int>(rng() % 200000), static_cast<int>(rng() % 2000)});
+        for (int i = 0; i < 2000; ++i)
+            track.addEvent({MidiEvent::Type::ControlChange, static_cast<int>(rng() % 200000),
+                            static_cast<int>(rng() % 120), static_cast<int>(rng() % 128)});
+    }
+}
+
+// A format 1 file with one MTrk chunk holding trackBody as is; the chunk length comes from declaredLength
+// when given, so a file can claim more bytes than it has.
+juce::MemoryBlock smfWithTrack(std::initializer_list<juce::uint8> trackBody, int declaredLength = -1)
+{
+    const auto length = static_cast<juce::uint32>(declaredLength >= 0 ? declaredLength
+                                                                        : static_cast<int>(trackBody.size()));
+    juce::MemoryOutputStream out;
+    out.write("MThd", 4);
+    out.writeIntBigEndian(6);
+    out.writeShortBigEndian(1);
+    out.writeShortBigEndian(1);
+    out.writeShortBigEndian(480);
+    out.write("MTrk", 4);
+    out.writeIntBigEndian(static_cast<int>(length));
+    for (auto byte : trackBody)
+        out.writeByte(static_cast<char>(byte));
+    return out.getMemoryBlock();
+}
+} // namespace
+
+class MidiFileIOTests : public juce::UnitTest
+{
+public:
+    MidiFileIOTests() : juce::UnitTest("MidiFileIO", "IO") {}
+
+    void runTest() override
+    {
+        beginTest("save and load round-trip a format 1 file");
+        {
+            MidiSequence original;
+            buildTestSequence(original);
+            juce::TemporaryFile file(".mid");
+            expect(MidiFileIO::save(original, file.getFile()));
+
+            MidiSequence loaded;
+            expect(MidiFileIO::load(loaded, file.getFile()));
+            expectSameSequence(loaded, original);
+        }
+
+        beginTest("loading replaces the previous contents");
+        {
+            MidiSequence original;
+            buildTestSequence(original);
+            juce::TemporaryFile file(".mid");
+            expect(MidiFileIO::save(original, file.getFile()));
+
+            MidiSequence loaded;
+            expect(MidiFileIO::load(loaded, file.getFile()));
+            expect(MidiFileIO::load(loaded, file.getFile()));
+            expectSameSequence(loaded, original);
+        }
+
+        beginTest("format 0 files are split into one track per channel");
+        {
+            juce::MidiMessageSequence messages;
+            for (int channel : {2, 1})
+            {
+                auto on = juce::MidiMessage::noteOn(channel, 60 + channel, static_cast<juce::uint8>(100));
+                on.setTimeStamp(channel * 100);
+                messages.addEvent(on);
+                auto off = juce::MidiMessage::noteOff(channel, 60 + channel);
+                off.setTimeStamp(channel * 100 + 50);
+                messages.addEvent(off);
+            }
+            messages.sort();
+
+            juce::MidiFile midiFile;
+            midiFile.setTicksPerQuarterNote(480);
+            midiFile.addTrack(messages);
+            juce::TemporaryFile file(".mid");
+            {
+                juce::FileOutputStream stream(file.getFile());
+                expect(midiFile.writeTo(stream, 0));
+            }
+
+            MidiSequence loaded;
+            expect(MidiFileIO::load(loaded, file.getFile()));
+            expectEquals(loaded.getNumTracks(), 2);
+            expectEquals(loaded.getTrack(0).getChannel(), 1);
+            expectEquals(juce::String(loaded.getTrack(0).getName()), juce::String("Ch.1"));
+            expectEquals(loaded.getTrack(1).getChannel(), 2);
+            expect(sortedNotes(loaded.getTrack(1)) == std::vector<std::tuple<int, int, int, int>>{{200, 62, 50, 100}});
+        }
+
+        beginTest("parallel decoding matches sequential decoding");
+        for (unsigned int seed : {1u, 2u, 3u})
+        {
+            MidiSequence original;
+            buildRandomSequence(original, seed);
+            juce::TemporaryFile file(".mid");
+            expect(MidiFileIO::save(original, file.getFile()));
+            // The loader gives each thread at least 256 KB of track data.
+            expectGreaterThan(file.getFile().getSize(), static_cast<juce::int64>(512 * 1024));
+
+            MidiSequence sequential;
+            expect(MidiFileIO::load(sequential, file.getFile(), 1));
+            MidiSequence parallel;
+            expect(MidiFileIO::load(parallel, file.getFile(), 8));
+            expectSameSequence(parallel, sequential);
+        }
+
+        beginTest("truncated or corrupt track chunks fail without touching the sequence");
+        {
+            MidiSequence original;
+            buildTestSequence(original);
+            juce::TemporaryFile good(".mid");
+            expect(MidiFileIO::save(original, good.getFile()));
+
+            const std::pair<const char*, juce::MemoryBlock> broken[] = {
+                {"chunk longer than the file", smfWithTrack({0x00, 0x90, 0x3C, 0x64, 0x60, 0x80, 0x3C, 0x00}, 64)},
+                {"event cut off inside the chunk", smfWithTrack({0x00, 0x90, 0x3C, 0x64, 0x60, 0x80, 0x3C})},
+                {"data byte with no running status", smfWithTrack({0x00, 0x3C, 0x64, 0x00, 0xFF, 0x2F, 0x00})},
+                {"meta event longer than the chunk", smfWithTrack({0x00, 0xFF, 0x03, 0x10, 0x41, 0x42})},
+            };
+            for (const auto& [what, bytes] : broken)
+            {
+                MidiSequence loaded;
+                expect(MidiFileIO::load(loaded, good.getFile()));
+
+                juce::TemporaryFile file(".mid");
+                expect(file.getFile().replaceWithData(bytes.getData(), bytes.getSize()));
+                expect(!MidiFileIO::load(loaded, file.getFile()), what);
+                expectSameSequence(loaded, original);
+            }
+
+            // A chunk that ends cleanly between events loads even without an End of Track.
+            juce::TemporaryFile file(".mid");
+            const auto bytes = smfWithTrack({0x00, 0x90, 0x3C, 0x64, 0x60, 0x80, 0x3C, 0x00});
+            expect(file.getFile().replaceWithData(bytes.getData(), bytes.getSize()));
+            MidiSequence loaded;
+            expect(MidiFileIO::load(loaded, file.getFile()));
+            expect(sortedNotes(loaded.getTrack(0)) == std::vector<std::tuple<int, int, int, int>>{{0, 60, 96, 100}});
+        }
+
+        beginTest("removing from a same-tick group keeps the saved order of the rest");
+        {
+            MidiSequence original;
+            original.setTicksPerQuarterNote(480);
+            auto& track = original.addTrack();
+            track.setChannel(1);
+            std::vector<NoteId> notes;
+            for (int pitch : {60, 64, 67, 72, 76})
+                notes.push_back(track.addNote({pitch, 100, 0, 480}));
+            // Bank select, volume and an RPN: the receiver depends on the order within the tick.
+            std::vector<EventId> events;
+            for (int controller : {0, 32, 7, 101, 100, 6})
+                events.push_back(track.addEvent({MidiEvent::Type::ControlChange, 0, controller, 1}));
+            track.removeNote(notes[1]);
+            track.removeEvent(events[2]);
+
+            juce::TemporaryFile file(".mid");
+            expect(MidiFileIO::save(original, file.getFile()));
+            MidiSequence loaded;
+            expect(MidiFileIO::load(loaded, file.getFile()));
+
+            const auto& loadedTrack = loaded.getTrack(0);
+            std::vector<int> pitches;
+            for (const int slot : loadedTrack.getStartOrder())
+                pitches.push_back(loadedTrack.getNotes()[static_cast<std::size_t>(slot)].noteNumber);
+            expect(pitches == std::vector<int>{60, 67, 72, 76});
+            std::vector<int> controllers;
+            for (const auto& event : loadedTrack.getEvents())
+                controllers.push_back(event.data1);
+            expect(controllers == std::vector<int>{0, 32, 101, 100, 6});
+        }
+
+        beginTest("files without a header are rejected");
+        {
+            juce::TemporaryFile file(".mid");
+            expect(file.getFile().replaceWithText("MTrk but not a MIDI file"));
+            MidiSequence loaded;
+            expect(!MidiFileIO::load(loaded, file.getFile()));
+        }
+    }
+
+private:
+    void expectSameSequence(const MidiSequence& loaded, const MidiSequence& original)
+    {
+        expectEquals(loaded.getTicksPerQuarterNote(), original.getTicksPerQuarterNote());
+
+        const auto& tempos = loaded.getTempoChanges();
+        expectEquals(static_cast<int>(tempos.size()), static_cast<int>(original.getTempoChanges().size()));
+        for (std::size_t i = 0; i < std::min(tempos.size(), original.getTempoChanges().size()); ++i)
+        {
+            expectEquals(tempos[i].tick, original.getTempoChanges()[i].tick);
+            expectWithinAbsoluteError(tempos[i].bpm, original.getTempoChanges()[i].bpm, 1e-6);
+        }
+
+        const auto& signatures = loaded.getTimeSignatureChanges();
+        expectEquals(static_cast<int>(signatures.size()), static_cast<int>(original.getTimeSignatureChanges().size()));
+        for (std::size_t i = 0; i < std::min(signatures.size(), original.getTimeSignatureChanges().size()); ++i)
+        {
+            const auto& expected = original.getTimeSignatureChanges()[i];
+            expectEquals(signatures[i].tick, expected.tick);
+            expectEquals(signatures[i].numerator, expected.numerator);
+            expectEquals(signatures[i].denominator, expected.denominator);
+        }
+
+        const auto& keys = loaded.getKeySignatureChanges();
+        expectEquals(static_cast<int>(keys.size()), static_cast<int>(original.getKeySignatureChanges().size()));
+        for (std::size_t i = 0; i < std::min(keys.size(), original.getKeySignatureChanges().size()); ++i)
+        {
+            const auto& expected = original.getKeySignatureChanges()[i];
+            expectEquals(keys[i].tick, expected.tick);
+            expectEquals(keys[i].sharpsOrFlats, expected.sharpsOrFlats);
+            expect(keys[i].isMinor == expected.isMinor);
+        }
+
+        const auto& chords = loaded.getChordChanges();
+        expectEquals(static_cast<int>(chords.size()), static_cast<int>(original.getChordChanges().size()));
+        for (std::size_t i = 0; i < std::min(chords.size(), original.getChordChanges().size()); ++i)
+        {
+            const auto& expected = original.getChordChanges()[i];
+            expect(chords[i].tick == expected.tick && chords[i].chordRoot == expected.chordRoot &&
+                       chords[i].chordType == expected.chordType && chords[i].bassRoot == expected.bassRoot &&
+                       chords[i].bassType == expected.bassType,
+                   "chord " + juce::String(static_cast<int>(i)) + " differs");
+        }
+
+        expectEquals(loaded.getNumTracks(), original.getNumTracks());
+        for (int t = 0; t < std::min(loaded.getNumTracks(), original.getNumTracks()); ++t)
+        {
+            const auto& track = loaded.getTrack(t);
+            const auto& expected = original.getTrack(t);
+            expectEquals(juce::String::fromUTF8(track.getName().c_str()),
+                         juce::String::fromUTF8(expected.getName().c_str()));
+            expectEquals(track.getChannel(), expected.getChannel());
+            expect(sortedNotes(track) == sortedNotes(expected), "notes of track " + juce::String(t) + " differ");
+            expect(sortedEvents(track) == sortedEvents(expected), "events of track " + juce::String(t) + " differ");
+        }
+    }
+};
+
+static MidiFileIOTests midiFileIOTests;
@@ -0,0 +1,272 @@
+#include "../model/MidiSequence.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+// At 480 ppq: 120 bpm is 1/960 s per tick, 60 bpm 1/480 s and 240 bpm 1/1920 s.
+void addTestTempoMap(MidiSequence& seq)
+{
+    seq.addTempoChange(1920, 60.0);
+    seq.addTempoChange(3840, 240.0);
+}
+} // namespace
+
+class MidiSequenceTimingTests : public juce::UnitTest
+{
+public:
+    MidiSequenceTimingTests() : juce::UnitTest("MidiSequence timing", "Model") {}
+
+    void runTest() override
+    {
+        beginTest("ticks and seconds at the default tempo");
+        {
+            MidiSequence seq;
+            expectWithinAbsoluteError(seq.ticksToSeconds(0), 0.0, 1e-12);
+            expectWithinAbsoluteError(seq.ticksToSeconds(960), 1.0, 1e-12);
+            expectEquals(seq.secondsToTicks(2.0005), 1920);
+            expectEquals(seq.getTempoAt(100000), 120.0);
+        }
+
+        beginTest("ticks and seconds across tempo changes");
+        {
+            MidiSequence seq;
+            addTestTempoMap(seq);
+            expectWithinAbsoluteError(seq.ticksToSeconds(1920), 2.0, 1e-9);
+            expectWithinAbsoluteError(seq.ticksToSeconds(2400), 3.0, 1e-9);
+            expectWithinAbsoluteError(seq.ticksToSeconds(3840), 6.0, 1e-9);
+            expectWithinAbsoluteError(seq.ticksToSeconds(5760), 7.0, 1e-9);
+
+            // Half a tick past each target, so truncation lands on it.
+            expectEquals(seq.secondsToTicks(1.0 + 0.5 / 960.0), 960);
+            expectEquals(seq.secondsToTicks(3.0 + 0.5 / 480.0), 2400);
+            expectEquals(seq.secondsToTicks(7.0 + 0.5 / 1920.0), 5760);
+
+            expectEquals(seq.getTempoAt(1919), 120.0);
+            expectEquals(seq.getTempoAt(1920), 60.0);
+            expectEquals(seq.getTempoAt(1000000), 240.0);
+            expectEquals(seq.getTempoChangeAt(3000).tick, 1920);
+        }
+
+        beginTest("a tempo change at an existing tick replaces it");
+        {
+            MidiSequence seq;
+            addTestTempoMap(seq);
+            seq.addTempoChange(1920, 30.0);
+            expectEquals(static_cast<int>(seq.getTempoChanges().size()), 3);
+            expectWithinAbsoluteError(seq.ticksToSeconds(2400), 2.0 + 480.0 / 240.0, 1e-9);
+
+            seq.setBpm(60.0);
+            expectWithinAbsoluteError(seq.ticksToSeconds(1920), 4.0, 1e-9);
+        }
+
+        beginTest("seconds to ticks inverts ticks to seconds over a dense tempo map");
+        {
+            MidiSequence seq;
+            std::mt19937 rng(17);
+            std::uniform_real_distribution<double> bpm(MidiSequence::minBpm, MidiSequence::maxBpm);
+            for (int i = 1; i <= 1000; ++i)
+                seq.addTempoChange(i * 97, bpm(rng));
+
+            const auto& map = *seq.getTempoMap();
+            double previous = -1.0;
+            for (int tick = 0; tick < 1001 * 97; tick += 13)
+            {
+                const double seconds = map.ticksToSeconds(tick);
+                expect(seconds > previous, "seconds must increase with ticks");
+                expectWithinAbsoluteError(map.secondsToTicks(seconds), static_cast<double>(tick), 1e-6);
+                previous = seconds;
+            }
+        }
+
+        beginTest("PPQ changes rescale the tempo map");
+        {
+            MidiSequence seq;
+            seq.setTicksPerQuarterNote(96);
+            expectWithinAbsoluteError(seq.ticksToSeconds(96), 0.5, 1e-12);
+            expectEquals(seq.barStartToTick(2), 384);
+        }
+    }
+};
+
+static MidiSequenceTimingTests midiSequenceTimingTests;
+
+class MidiSequenceBarTests : public juce::UnitTest
+{
+public:
+    MidiSequenceBarTests() : juce::UnitTest("MidiSequence bars and beats", "Model") {}
+
+    void runTest() override
+    {
+        beginTest("bars in 4/4");
+        {
+            MidiSequence seq;
+            expectBarBeatTick(seq.tickToBarBeatTick(0), 1, 1, 0);
+            expectBarBeatTick(seq.tickToBarBeatTick(1919), 1, 4, 479);
+            expectBarBeatTick(seq.tickToBarBeatTick(2000), 2, 1, 80);
+            expectEquals(seq.barStartToTick(3), 3840);
+            expectEquals(seq.barBeatTickToTick(2, 3, 5), 1920 + 960 + 5);
+        }
+
+        beginTest("bars across time signature changes");
+        {
+            MidiSequence seq;
+            seq.addTimeSignatureChange(3840, 3, 4); // bar 3
+            seq.addTimeSignatureChange(6720, 6, 8); // bar 5
+
+            expectEquals(seq.getTimeSignatureAt(5000).numerator, 3);
+            expectEquals(seq.barStartToTick(4), 5280);
+            expectEquals(seq.barStartToTick(5), 6720);
+            expectEquals(seq.barStartToTick(7), 6720 + 2 * 1440);
+            expectBarBeatTick(seq.tickToBarBeatTick(5280 + 480 + 5), 4, 2, 5);
+            expectBarBeatTick(seq.tickToBarBeatTick(7210), 5, 3, 10);
+            expectEquals(seq.barBeatTickToTick(5, 3, 10), 7210);
+        }
+
+        beginTest("a time signature change off a bar line snaps to the bar it falls in");
+        {
+            MidiSequence seq;
+            seq.addTimeSignatureChange(4000, 3, 4);
+            expectEquals(seq.getTimeSignatureChanges().back().tick, 3840);
+        }
+
+        beginTest("bar/beat/tick round-trips through every tick");
+        {
+            MidiSequence seq;
+            seq.addTimeSignatureChange(1920, 7, 8);
+            seq.addTimeSignatureChange(1920 + 3 * 1680, 5, 4);
+            seq.addTimeSignatureChange(1920 + 3 * 1680 + 2 * 2400, 2, 2);
+
+            bool allMatched = true;
+            for (int tick = 0; tick < 20000 && allMatched; ++tick)
+            {
+                const auto bbt = seq.tickToBarBeatTick(tick);
+                allMatched = seq.barBeatTickToTick(bbt.bar, bbt.beat, bbt.tick) == tick;
+            }
+            expect(allMatched, "tickToBarBeatTick and barBeatTickToTick disagree");
+        }
+    }
+
+private:
+    void expectBarBeatTick(const BarBeatTick& actual, int bar, int beat, int tick)
+    {
+        expectEquals(actual.bar, bar);
+        expectEquals(actual.beat, beat);
+        expectEquals(actual.tick, tick);
+    }
+};
+
+static MidiSequenceBarTests midiSequenceBarTests;
+
+class MidiTrackIndexTests : public juce::UnitTest
+{
+public:
+    MidiTrackIndexTests() : juce::UnitTest("MidiTrack range queries", "Model") {}
+
+    void runTest() override
+    {
+        beginTest("range queries match a full scan through adds, moves and removes");
+        {
+            MidiTrack track;
+            std::mt19937 rng(21);
+            std::vector<NoteId> live;
+            std::vector<NoteId> found;
+            bool allMatched = true;
+            for (int step = 0; step < 4000 && allMatched; ++step)
+            {
+                const int action = static_cast<int>(rng() % 4);
+                if (action < 2 || live.empty())
+                {
+                    live.push_back(track.addNote({static_cast<int>(rng() % 128), 100, static_cast<int>(rng() % 5000),
+                                                  static_cast<int>(rng() % 3 == 0 ? rng() % 2000 : rng() % 60)}));
+                }
+                else
+                {
+                    const auto index = rng() % live.size();
+                    if (action == 2)
+                    {
+                        auto note = track.getNote(live[index]);
+                        note.startTick = static_cast<int>(rng() % 5000);
+                        note.duration = static_cast<int>(rng() % 200);
+                        track.setNote(live[index], note);
+                    }
+                    else
+                    {
+                        track.removeNote(live[index]);
+                        live.erase(live.begin() + static_cast<std::ptrdiff_t>(index));
+                    }
+                }
+
+                const int from = static_cast<int>(rng() % 5000);
+                const int to = from + 1 + static_cast<int>(rng() % 400);
+                track.findNotesInRange(from, to, found, 40, 90);
+                allMatched = found == scan(track, from, to, 40, 90) && isInStartOrder(track);
+            }
+            expect(allMatched, "the index disagrees with a full scan");
+        }
+
+        beginTest("same-tick notes keep the order they got their tick in");
+        {
+            MidiTrack track;
+            const auto a = track.addNote({60, 100, 100, 10});
+            const auto b = track.addNote({62, 100, 200, 10});
+            const auto c = track.addNote({64, 100, 100, 10});
+            track.setNote(b, {62, 100, 100, 10});
+            std::vector<NoteId> found;
+            track.findNotesStartingIn(0, 1000, found);
+            expect(found == std::vector<NoteId>{a, c, b});
+
+            track.removeNote(a);
+            track.findNotesStartingIn(0, 1000, found);
+            expect(found == std::vector<NoteId>{c, b});
+        }
+
+        beginTest("freed note ids are reused unless undo restored them");
+        {
+            MidiTrack track;
+            const auto a = track.addNote({60, 100, 0, 10});
+            const auto b = track.addNote({62, 100, 0, 10});
+            for (int i = 0; i < 100; ++i)
+            {
+                track.removeNote(b);
+                track.restoreNote(b, {62, 100, 0, 10});
+            }
+            track.removeNote(b);
+            expect(track.addNote({64, 100, 0, 10}) == b);
+
+            track.removeNote(a);
+            track.restoreNote(a, {60, 100, 0, 10});
+            const auto fresh = track.addNote({65, 100, 0, 10});
+            expect(fresh != a && fresh != b);
+            expectEquals(track.getNote(a).noteNumber, 60);
+            expectEquals(track.getNote(b).noteNumber, 64);
+        }
+    }
+
+private:
+    static std::vector<NoteId> scan(const MidiTrack& track, int from, int to, int lowNote, int highNote)
+    {
+        std::vector<NoteId> result;
+        for (int slot : track.getStartOrder())
+        {
+            const auto note = track.getNotes()[static_cast<std::size_t>(slot)];
+            if (note.startTick < to && note.startTick + std::max(note.duration, 1) > from &&
+                note.noteNumber >= lowNote && note.noteNumber <= highNote)
+                result.push_back(track.getNoteId(slot));
+        }
+        return result;
+    }
+
+    static bool isInStartOrder(const MidiTrack& track)
+    {
+        const auto order = track.getStartOrder();
+        const auto starts = track.getNotes().startTicks();
+        if (order.size() != starts.size())
+            return false;
+        return std::ranges::is_sorted(order, {}, [&](int slot) { return starts[static_cast<std::size_t>(slot)]; });
+    }
+};
+
+static MidiTrackIndexTests midiTrackIndexTests;
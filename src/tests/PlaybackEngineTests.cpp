@@ -0,0 +1,140 @@
+#include "../engine/PlaybackEngine.h"
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Note-ons with the absolute sample they were scheduled at.
+class SampleRecorder : public PlaybackListener
+{
+public:
+    explicit SampleRecorder(const std::int64_t& blockStart) : blockStartSample(blockStart) {}
+
+    void onNoteOn(const PlaybackTrackContext&, const MidiNote&) override { ++untimedNoteOns; }
+    void onNoteOff(const PlaybackTrackContext&, const MidiNote&) override { ++noteOffs; }
+    void onMidiEvent(const PlaybackTrackContext&, const MidiEvent&) override {}
+
+    void onNoteOnAt(const PlaybackTrackContext&, const MidiNote& note, int sampleOffset) override
+    {
+        noteOns.push_back({note.startTick, blockStartSample + sampleOffset});
+    }
+
+    struct NoteOn
+    {
+        int tick;
+        std::int64_t sample;
+    };
+
+    std::vector<NoteOn> noteOns;
+    int untimedNoteOns = 0;
+    int noteOffs = 0;
+
+private:
+    const std::int64_t& blockStartSample;
+};
+} // namespace
+
+class PlaybackEngineClockTests : public juce::UnitTest
+{
+public:
+    PlaybackEngineClockTests() : juce::UnitTest("PlaybackEngine clock", "Engine") {}
+
+    void runTest() override
+    {
+        beginTest("a 1000 tempo change file plays without drift against a virtual clock");
+        {
+            constexpr double sampleRate = 48000.0;
+            constexpr int spacing = 240;
+
+            MidiSequence seq;
+            std::mt19937 rng(12);
+            std::uniform_real_distribution<double> bpm(40.0, 300.0);
+            auto& track = seq.addTrack();
+            for (int i = 1; i <= 1000; ++i)
+            {
+                // One note on each change and one between changes, where the previous tempo still holds.
+                seq.addTempoChange(i * spacing, bpm(rng));
+                track.addNote({60, 100, i * spacing, 60});
+                track.addNote({64, 100, i * spacing + spacing / 2, 60});
+            }
+            const auto& tempoMap = *seq.getTempoMap();
+            const int endTick = 1001 * spacing;
+
+            std::int64_t blockStart = 0;
+            SampleRecorder recorder(blockStart);
+            PlaybackEngine engine;
+            engine.addListener(&recorder);
+            engine.setClockSource(PlaybackEngine::ClockSource::AudioDevice);
+            engine.setSequence(&seq);
+            engine.play();
+
+            // Mostly ordinary block sizes, with an occasional 50 ms stall delivered as one long block.
+            std::uniform_int_distribution<int> blockSize(32, 1024);
+            std::uniform_int_distribution<int> stall(0, 499);
+            double worstDrift = 0.0;
+            while (engine.getCurrentTick() < endTick)
+            {
+                const int numSamples = stall(rng) == 0 ? 2400 : blockSize(rng);
+                {
+                    const PlaybackEngine::ScopedAudioBlock block(engine);
+                    engine.processAudioBlock(numSamples, sampleRate);
+                }
+                blockStart += numSamples;
+
+                const double expected = tempoMap.secondsToTicks(static_cast<double>(blockStart) / sampleRate);
+                worstDrift = std::max(worstDrift, std::abs(engine.getCurrentTick() - expected));
+            }
+            engine.stop();
+            engine.removeListener(&recorder);
+
+            expectLessThan(worstDrift, 1e-6);
+            expectEquals(recorder.untimedNoteOns, 0);
+            expectEquals(static_cast<int>(recorder.noteOns.size()), 2000);
+
+            double worstOffset = 0.0;
+            for (const auto& on : recorder.noteOns)
+            {
+                const double exact = tempoMap.ticksToSeconds(on.tick) * sampleRate;
+                worstOffset = std::max(worstOffset, std::abs(static_cast<double>(on.sample) - exact));
+            }
+            expectLessOrEqual(worstOffset, 1.0);
+        }
+
+        beginTest("track releases requested while playing are all applied on the next block");
+        {
+            constexpr int numTracks = 300;
+            MidiSequence seq;
+            for (int t = 0; t < numTracks; ++t)
+                seq.addTrack().addNote({60, 100, 0, 100000});
+
+            std::int64_t blockStart = 0;
+            SampleRecorder recorder(blockStart);
+            PlaybackEngine engine;
+            engine.addListener(&recorder);
+            engine.setClockSource(PlaybackEngine::ClockSource::AudioDevice);
+            engine.setSequence(&seq);
+            engine.play();
+            auto renderBlock = [&engine]
+            {
+                const PlaybackEngine::ScopedAudioBlock block(engine);
+                engine.processAudioBlock(256, 48000.0);
+            };
+            renderBlock();
+            expectEquals(static_cast<int>(recorder.noteOns.size()), numTracks);
+
+            // More requests than a callback could ever queue, with every track asked twice.
+            for (int round = 0; round < 2; ++round)
+                for (int t = 0; t < numTracks; ++t)
+                    engine.releaseActiveNotesForTrack(t);
+            renderBlock();
+            expectEquals(recorder.noteOffs, numTracks);
+
+            engine.stop();
+            engine.removeListener(&recorder);
+        }
+    }
+};
+
+static PlaybackEngineClockTests playbackEngineClockTests;
@@ -0,0 +1,272 @@
+#include "../engine/PlaybackProcessor.h"
+#include "../engine/PlaybackSnapshot.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Everything the processor sent, with the window it was sent in.
+class RecordingSink : public PlaybackListener
+{
+public:
+    enum class Kind
+    {
+        NoteOn,
+        NoteOff,
+        Event
+    };
+
+    struct Entry
+    {
+        Kind kind;
+        int trackIndex;
+        int tick; // start tick for note-ons, end tick for note-offs
+        int data; // note number, or controller number for events
+        int windowStart;
+        int windowEnd;
+
+        auto operator<=>(const Entry&) const = default;
+    };
+
+    void onNoteOn(const PlaybackTrackContext& ctx, const MidiNote& note) override
+    {
+        entries.push_back({Kind::NoteOn, ctx.trackIndex, note.startTick, note.noteNumber, windowStart, windowEnd});
+    }
+    void onNoteOff(const PlaybackTrackContext& ctx, const MidiNote& note) override
+    {
+        entries.push_back({Kind::NoteOff, ctx.trackIndex, note.endTick(), note.noteNumber, windowStart, windowEnd});
+    }
+    void onMidiEvent(const PlaybackTrackContext& ctx, const MidiEvent& event) override
+    {
+        entries.push_back({Kind::Event, ctx.trackIndex, event.tick, event.data1, windowStart, windowEnd});
+    }
+
+    int count(Kind kind) const
+    {
+        return static_cast<int>(std::ranges::count(entries, kind, &Entry::kind));
+    }
+
+    std::vector<Entry> entries;
+    int windowStart = 0;
+    int windowEnd = 0;
+};
+
+// Plays [0, endTick) in windows of stepTicks, then stops.
+void play(const PlaybackSnapshot& snapshot, int endTick, int stepTicks, RecordingSink& sink)
+{
+    PlaybackProcessor processor;
+    processor.reserveScratchFor(snapshot);
+    processor.resetCursors(snapshot, 0);
+    for (int tick = 0; tick < endTick; tick += stepTicks)
+    {
+        sink.windowStart = tick;
+        sink.windowEnd = tick + stepTicks;
+        processor.process(snapshot, tick, tick + stepTicks, sink);
+    }
+    sink.windowStart = sink.windowEnd = endTick;
+    processor.sendAllNoteOffs(sink);
+}
+
+void fillRandomTracks(MidiSequence& seq, int numTracks, int notesPerTrack, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    for (int t = 0; t < numTracks; ++t)
+    {
+        auto& track = seq.addTrack();
+        track.setChannel(t + 1);
+        for (int i = 0; i < notesPerTrack; ++i)
+            track.addNote({static_cast<int>(36 + rng() % 48), 100, static_cast<int>(rng() % 20000),
+                           static_cast<int>(rng() % 2000)});
+        for (int i = 0; i < notesPerTrack / 4; ++i)
+            track.addEvent({MidiEvent::Type::ControlChange, static_cast<int>(rng() % 20000),
+                            static_cast<int>(rng() % 120), 64});
+    }
+}
+} // namespace
+
+class PlaybackProcessorTests : public juce::UnitTest
+{
+public:
+    PlaybackProcessorTests() : juce::UnitTest("PlaybackProcessor scheduling", "Engine") {}
+
+    void runTest() override
+    {
+        using Kind = RecordingSink::Kind;
+
+        beginTest("notes start and end in the window that contains their ticks");
+        {
+            MidiSequence seq;
+            fillRandomTracks(seq, 4, 500, 1);
+            const auto snapshot = PlaybackSnapshot::build(seq);
+
+            RecordingSink sink;
+            play(snapshot, seq.getEndTick() + 1, 7, sink);
+            expectEquals(sink.count(Kind::NoteOn), 2000);
+            expectEquals(sink.count(Kind::NoteOff), 2000);
+            expectEquals(sink.count(Kind::Event), 500);
+
+            bool allInWindow = true;
+            for (const auto& e : sink.entries)
+            {
+                if (e.kind == Kind::NoteOff)
+                    allInWindow = allInWindow && e.tick >= e.windowStart && e.tick <= e.windowEnd;
+                else
+                    allInWindow = allInWindow && e.tick >= e.windowStart && e.tick < e.windowEnd;
+            }
+            expect(allInWindow, "an event was sent outside its window");
+        }
+
+        beginTest("window size does not change what is played");
+        {
+            MidiSequence seq;
+            fillRandomTracks(seq, 3, 300, 2);
+            const auto snapshot = PlaybackSnapshot::build(seq);
+            const int endTick = seq.getEndTick() + 1;
+
+            auto played = [&](int stepTicks)
+            {
+                RecordingSink sink;
+                play(snapshot, endTick, stepTicks, sink);
+                for (auto& e : sink.entries)
+                    e.windowStart = e.windowEnd = 0;
+                std::ranges::sort(sink.entries);
+                return sink.entries;
+            };
+            const auto reference = played(endTick);
+            for (int step : {1, 11, 480})
+                expect(played(step) == reference, "stepping by " + juce::String(step) + " ticks differs");
+        }
+
+        beginTest("simultaneous starts go out in track order");
+        {
+            MidiSequence seq;
+            for (int t = 0; t < 3; ++t)
+            {
+                auto& track = seq.addTrack();
+                track.addNote({60 + t, 100, 100, 10});
+                track.addEvent({MidiEvent::Type::ControlChange, 100, t, 0});
+            }
+            seq.getTrack(0).addNote({50, 100, 90, 30});
+            const auto snapshot = PlaybackSnapshot::build(seq);
+
+            RecordingSink sink;
+            play(snapshot, 200, 200, sink);
+            std::vector<int> noteOnOrder;
+            std::vector<int> eventOrder;
+            for (const auto& e : sink.entries)
+            {
+                if (e.kind == Kind::NoteOn)
+                    noteOnOrder.push_back(e.data);
+                else if (e.kind == Kind::Event)
+                    eventOrder.push_back(e.trackIndex);
+            }
+            expect(noteOnOrder == std::vector<int>{50, 60, 61, 62});
+            expect(eventOrder == std::vector<int>{0, 1, 2});
+        }
+
+        beginTest("notes still sounding at a window end stay active until their end");
+        {
+            MidiSequence seq;
+            seq.addTrack().addNote({60, 100, 10, 100});
+            const auto snapshot = PlaybackSnapshot::build(seq);
+
+            PlaybackProcessor processor;
+            processor.reserveScratchFor(snapshot);
+            processor.resetCursors(snapshot, 0);
+            RecordingSink sink;
+            processor.process(snapshot, 0, 50, sink);
+            expectEquals(sink.count(Kind::NoteOn), 1);
+            expectEquals(sink.count(Kind::NoteOff), 0);
+            processor.process(snapshot, 50, 109, sink);
+            expectEquals(sink.count(Kind::NoteOff), 0);
+            processor.process(snapshot, 109, 110, sink);
+            expectEquals(sink.count(Kind::NoteOff), 1);
+            processor.sendAllNoteOffs(sink);
+            expectEquals(sink.count(Kind::NoteOff), 1);
+        }
+
+        beginTest("stopping releases every active note once");
+        {
+            MidiSequence seq;
+            for (int t = 0; t < 2; ++t)
+                for (int i = 0; i < 4; ++i)
+                    seq.addTrack().addNote({60 + i, 100, i, 1000});
+            const auto snapshot = PlaybackSnapshot::build(seq);
+
+            PlaybackProcessor processor;
+            processor.reserveScratchFor(snapshot);
+            processor.resetCursors(snapshot, 0);
+            RecordingSink sink;
+            processor.process(snapshot, 0, 100, sink);
+            processor.sendAllNoteOffs(sink);
+            processor.sendAllNoteOffs(sink);
+            expectEquals(sink.count(Kind::NoteOn), 8);
+            expectEquals(sink.count(Kind::NoteOff), 8);
+        }
+
+        beginTest("seeking skips notes that start before the new position");
+        {
+            MidiSequence seq;
+            auto& track = seq.addTrack();
+            for (int i = 0; i < 10; ++i)
+                track.addNote({60, 100, i * 100, 50});
+            track.addEvent({MidiEvent::Type::ControlChange, 250, 1, 0});
+            track.addEvent({MidiEvent::Type::ControlChange, 750, 2, 0});
+            const auto snapshot = PlaybackSnapshot::build(seq);
+
+            PlaybackProcessor processor;
+            processor.reserveScratchFor(snapshot);
+            processor.resetCursors(snapshot, 520);
+            RecordingSink sink;
+            processor.process(snapshot, 520, 1000, sink);
+            expectEquals(sink.count(Kind::NoteOn), 4);
+            expectEquals(sink.count(Kind::Event), 1);
+            const auto firstOn = std::ranges::find(sink.entries, Kind::NoteOn, &RecordingSink::Entry::kind);
+            expect(firstOn != sink.entries.end() && firstOn->tick == 600);
+        }
+
+        beginTest("muting a track releases its notes and unmuting resumes without replaying");
+        {
+            MidiSequence seq;
+            seq.addTrack();
+            seq.addTrack();
+            for (int i = 0; i < 10; ++i)
+            {
+                seq.getTrack(0).addNote({60, 100, i * 100, 150});
+                seq.getTrack(1).addNote({70, 100, i * 100, 50});
+            }
+            auto snapshot = PlaybackSnapshot::build(seq);
+
+            PlaybackProcessor processor;
+            processor.reserveScratchFor(snapshot);
+            processor.resetCursors(snapshot, 0);
+            RecordingSink sink;
+            processor.process(snapshot, 0, 320, sink);
+            expectEquals(sink.count(Kind::NoteOn), 8);
+
+            seq.getTrack(0).setMuted(true);
+            snapshot.refreshAudibility(seq);
+            sink.entries.clear();
+            processor.process(snapshot, 320, 520, sink);
+            // Track 0's notes from 200 and 300 are cut off; track 1 ends its notes from 300 and 400.
+            expectEquals(sink.count(Kind::NoteOff), 4);
+            for (const auto& e : sink.entries)
+                if (e.kind == Kind::NoteOn)
+                    expectEquals(e.trackIndex, 1);
+
+            seq.getTrack(0).setMuted(false);
+            snapshot.refreshAudibility(seq);
+            sink.entries.clear();
+            processor.process(snapshot, 520, 620, sink);
+            std::vector<int> restarted;
+            for (const auto& e : sink.entries)
+                if (e.kind == Kind::NoteOn && e.trackIndex == 0)
+                    restarted.push_back(e.tick);
+            expect(restarted == std::vector<int>{600});
+        }
+    }
+};
+
+static PlaybackProcessorTests playbackProcessorTests;
@@ -0,0 +1,34 @@
+#include <juce_core/juce_core.h>
+#include <iostream>
+
+namespace
+{
+constexpr const char* usage = "Usage: calliope-tests [--category name] [--seed N]\n"
+                              "  Runs every registered juce::UnitTest, or only those in one category, and exits\n"
+                              "  non-zero if any expectation failed.\n";
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    // Tests draw their data from fixed seeds of their own; this one only feeds UnitTest::getRandom().
+    const juce::int64 seed = args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 1;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    if (args.containsOption("--category"))
+        runner.runTestsInCategory(args.getValueForOption("--category"), seed);
+    else
+        runner.runAllTests(seed);
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+    return failures == 0 ? 0 : 1;
+}
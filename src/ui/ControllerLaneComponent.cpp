@@ -79,15 +79,7 @@ void ControllerLaneComponent::setSequence(MidiSequence* seq)
     {
         int lastTick = 0;
         for (int t = 0; t < sequence->getNumTracks(); ++t)
-        {
-            const auto& track = sequence->getTrack(t);
-            for (int i = 0; i < track.getNumNotes(); ++i)
-            {
-                int end = track.getNote(i).endTick();
-                if (end > lastTick)
-                    lastTick = end;
-            }
-        }
+            lastTick = std::max(lastTick, sequence->getTrack(t).getLastEndTick());
         contentBeats = std::max(contentBeats, lastTick / sequence->getTicksPerQuarterNote() + 4);
     }
 
@@ -124,10 +116,11 @@ void ControllerLaneComponent::setPlayheadTick(double tick)
     int oldX = tickToX(static_cast<int>(playheadTick));
     playheadTick = tick;
     int newX = tickToX(static_cast<int>(playheadTick));
+    if (newX == oldX)
+        return;
 
-    int margin = 2;
-    repaint(oldX - margin, 0, margin * 2 + 2, getHeight());
-    repaint(newX - margin, 0, margin * 2 + 2, getHeight());
+    repaint(oldX, 0, 1, getHeight());
+    repaint(newX, 0, 1, getHeight());
 }
 
 void ControllerLaneComponent::setLoopRegion(bool enabled, int startTick, int endTick)
@@ -382,9 +375,10 @@ void ControllerLaneComponent::drawVelocity(juce::Graphics& g)
         bool isActive = (trackIdx == activeTrackIndex);
         float alpha = isActive ? 0.85f : 0.3f;
 
-        for (int i = 0; i < track.getNumNotes(); ++i)
+        track.findNotesInRange(xToTick(visibleLeft - velocityBarWidth) - 1, xToTick(visibleRight) + 1, visibleNoteIds);
+        for (NoteId id : visibleNoteIds)
         {
-            const auto& note = track.getNote(i);
+            const auto note = track.getNote(id);
             int x = tickToX(note.startTick);
 
             if (x + velocityBarWidth < visibleLeft || x > visibleRight)
@@ -664,9 +658,10 @@ void ControllerLaneComponent::mouseDown(const juce::MouseEvent& e)
 
     int bestIdx = -1;
     int bestDist = INT_MAX;
+    const auto startTicks = track.getNotes().startTicks();
     for (int i = 0; i < track.getNumNotes(); ++i)
     {
-        int nx = tickToX(track.getNote(i).startTick);
+        int nx = tickToX(startTicks[static_cast<std::size_t>(i)]);
         if (e.x >= nx && e.x < nx + velocityBarWidth)
         {
             int dist = std::abs(nx - e.x);
@@ -680,11 +675,10 @@ void ControllerLaneComponent::mouseDown(const juce::MouseEvent& e)
 
     if (bestIdx >= 0)
     {
-        velocitySnapshot.clear();
-        for (int i = 0; i < track.getNumNotes(); ++i)
-            velocitySnapshot.push_back(track.getNote(i).velocity);
+        const auto velocities = track.getNotes().velocities();
+        velocitySnapshot.assign(velocities.begin(), velocities.end());
 
-        track.getNote(bestIdx).velocity = newVelocity;
+        track.setNoteVelocity(track.getNoteId(bestIdx), newVelocity);
         isDragging = true;
         lastDragX = e.x;
         repaint();
@@ -710,12 +704,13 @@ void ControllerLaneComponent::mouseDrag(const juce::MouseEvent& e)
     int endX = std::max(lastDragX, e.x);
 
     bool changed = false;
+    const auto startTicks = track.getNotes().startTicks();
     for (int i = 0; i < track.getNumNotes(); ++i)
     {
-        int nx = tickToX(track.getNote(i).startTick);
+        int nx = tickToX(startTicks[static_cast<std::size_t>(i)]);
         if (nx + velocityBarWidth >= startX && nx <= endX)
         {
-            track.getNote(i).velocity = newVelocity;
+            track.setNoteVelocity(track.getNoteId(i), newVelocity);
             changed = true;
         }
     }
@@ -736,10 +731,12 @@ void ControllerLaneComponent::mouseUp(const juce::MouseEvent&)
     {
         auto& track = sequence->getTrack(activeTrackIndex);
         std::vector<VelocityChange> changes;
+        const auto velocities = track.getNotes().velocities();
         for (int i = 0; i < track.getNumNotes() && i < static_cast<int>(velocitySnapshot.size()); ++i)
         {
-            if (track.getNote(i).velocity != velocitySnapshot[i])
-                changes.push_back({i, velocitySnapshot[i], track.getNote(i).velocity});
+            const int velocity = velocities[static_cast<std::size_t>(i)];
+            if (velocity != velocitySnapshot[i])
+                changes.push_back({track.getNoteId(i), velocitySnapshot[i], velocity});
         }
         if (!changes.empty())
         {
@@ -95,6 +95,7 @@ private:
     bool isDragging = false;
     int lastDragX = -1;
     std::vector<int> velocitySnapshot;
+    std::vector<NoteId> visibleNoteIds;
 
     static constexpr int topPadding = 6;
     static constexpr int bottomPadding = 6;
@@ -1,6 +1,8 @@
 #include "EventListComponent.h"
 #include "TrackColours.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace
 {
@@ -28,21 +30,40 @@ EventListComponent::~EventListComponent()
         sequence->removeListener(this);
 }
 
-void EventListComponent::notesChanged(int)
+void EventListComponent::notesChanged(int trackIndex)
 {
-    refresh();
+    if (sequence == nullptr)
+        return;
+    if (trackIndex < 0)
+        view.rebuild(*sequence, selectedTracks);
+    else
+        view.rebuildTrack(*sequence, trackIndex);
+    contentChanged();
+}
+
+void EventListComponent::notesEdited(const std::vector<DirtyTickRange>& ranges)
+{
+    if (sequence == nullptr)
+        return;
+    for (const auto& range : ranges)
+        view.patchNotes(*sequence, range.trackIndex, range.startTick, range.endTick);
+    contentChanged();
 }
+
 void EventListComponent::tracksChanged()
 {
     refresh();
 }
+
+// Rows show bar/beat positions, which only need repainting when the timeline changes.
 void EventListComponent::tempoChanged()
 {
-    refresh();
+    listBox.repaint();
 }
+
 void EventListComponent::timelineMetadataChanged()
 {
-    refresh();
+    listBox.repaint();
 }
 
 void EventListComponent::setSequence(MidiSequence* seq)
@@ -68,80 +89,16 @@ void EventListComponent::refresh()
 
 void EventListComponent::rebuildList()
 {
-    items.clear();
-
-    if (!sequence)
-    {
-        listBox.updateContent();
-        listBox.repaint();
-        repaint();
-        return;
-    }
-
-    for (int trackIdx : selectedTracks)
-    {
-        if (trackIdx < 0 || trackIdx >= sequence->getNumTracks())
-            continue;
-
-        const auto& track = sequence->getTrack(trackIdx);
-
-        for (int i = 0; i < track.getNumNotes(); ++i)
-        {
-            const auto& note = track.getNote(i);
-            EventListItem item;
-            item.kind = EventListItem::Note;
-            item.tick = note.startTick;
-            item.trackIndex = trackIdx;
-            item.sourceIndex = i;
-            item.noteNumber = note.noteNumber;
-            item.duration = note.duration;
-            item.velocity = note.velocity;
-            items.push_back(item);
-        }
-
-        for (int i = 0; i < track.getNumEvents(); ++i)
-        {
-            const auto& ev = track.getEvent(i);
-            EventListItem item;
-            item.tick = ev.tick;
-            item.trackIndex = trackIdx;
-            item.sourceIndex = i;
-            item.data1 = ev.data1;
-            item.data2 = ev.data2;
-
-            switch (ev.type)
-            {
-            case MidiEvent::Type::ControlChange:
-                item.kind = EventListItem::ControlChange;
-                break;
-            case MidiEvent::Type::ProgramChange:
-                item.kind = EventListItem::ProgramChange;
-                break;
-            case MidiEvent::Type::PitchBend:
-                item.kind = EventListItem::PitchBend;
-                break;
-            case MidiEvent::Type::ChannelPressure:
-                item.kind = EventListItem::ChannelPressure;
-                break;
-            case MidiEvent::Type::KeyPressure:
-                item.kind = EventListItem::KeyPressure;
-                break;
-            }
-
-            items.push_back(item);
-        }
-    }
-
-    std::sort(items.begin(), items.end(),
-              [](const EventListItem& a, const EventListItem& b)
-              {
-                  if (a.tick != b.tick)
-                      return a.tick < b.tick;
-                  if (a.trackIndex != b.trackIndex)
-                      return a.trackIndex < b.trackIndex;
-                  return a.kind < b.kind;
-              });
+    if (sequence != nullptr)
+        view.rebuild(*sequence, selectedTracks);
+    else
+        view = {};
+    contentChanged();
+}
 
+void EventListComponent::contentChanged()
+{
+    lastPlayheadTick = -1;
     listBox.updateContent();
     listBox.repaint();
     repaint();
@@ -149,30 +106,27 @@ void EventListComponent::rebuildList()
 
 void EventListComponent::setPlayheadTick(double tick)
 {
-    if (items.empty())
+    if (view.getNumRows() == 0)
         return;
 
-    auto it = std::upper_bound(items.begin(), items.end(), static_cast<int>(tick),
-                               [](int t, const EventListItem& item) { return t < item.tick; });
+    // The row only moves when the playhead reaches another whole tick or lands exactly on one.
+    const bool onWholeTick = tick == std::floor(tick);
+    if (static_cast<int>(tick) == lastPlayheadTick && onWholeTick == lastPlayheadOnWholeTick)
+        return;
+    lastPlayheadTick = static_cast<int>(tick);
+    lastPlayheadOnWholeTick = onWholeTick;
 
-    int row;
-    if (it == items.begin())
-    {
-        row = 0;
-    }
-    else
+    // The last row at or before the playhead, or the first of its tick when the playhead sits on one.
+    const int playheadTick = static_cast<int>(tick);
+    const int rowsUpToTick = playheadTick == std::numeric_limits<int>::max()
+                                 ? view.getNumRows()
+                                 : view.countRowsBefore(playheadTick + 1);
+
+    int row = 0;
+    if (rowsUpToTick > 0)
     {
-        --it;
-        if (tick == static_cast<double>(it->tick))
-        {
-            auto first = std::lower_bound(items.begin(), it, it->tick,
-                                          [](const EventListItem& item, int t) { return item.tick < t; });
-            row = static_cast<int>(std::distance(items.begin(), first));
-        }
-        else
-        {
-            row = static_cast<int>(std::distance(items.begin(), it));
-        }
+        const int lastTick = view.getItem(*sequence, rowsUpToTick - 1).tick;
+        row = tick == static_cast<double>(lastTick) ? view.countRowsBefore(lastTick) : rowsUpToTick - 1;
     }
 
     if (row != lastPlayheadRow)
@@ -191,25 +145,34 @@ void EventListComponent::setPlayheadTick(double tick)
     }
 }
 
-void EventListComponent::setSelectedNotes(const std::set<std::pair<int, int>>& selected)
+void EventListComponent::setSelectedNotes(const std::set<std::pair<int, NoteId>>& selected)
 {
     updatingFromNoteSelection = true;
-    listBox.deselectAllRows();
 
-    int firstRow = -1;
-    for (int i = 0; i < static_cast<int>(items.size()); ++i)
+    std::vector<int> rows;
+    if (sequence != nullptr)
     {
-        const auto& item = items[static_cast<size_t>(i)];
-        if (item.kind == EventListItem::Note && selected.contains({item.trackIndex, item.sourceIndex}))
-        {
-            listBox.selectRow(i, true, false);
-            if (firstRow < 0)
-                firstRow = i;
-        }
+        rows.reserve(selected.size());
+        for (const auto& [trackIndex, noteId] : selected)
+            if (const int row = view.findNoteRow(*sequence, trackIndex, noteId); row >= 0)
+                rows.push_back(row);
+    }
+    std::ranges::sort(rows);
+
+    juce::SparseSet<int> selectedRows;
+    for (std::size_t i = 0; i < rows.size();)
+    {
+        std::size_t end = i + 1;
+        while (end < rows.size() && rows[end] == rows[end - 1] + 1)
+            ++end;
+        selectedRows.addRange({rows[i], rows[end - 1] + 1});
+        i = end;
     }
+    listBox.setSelectedRows(selectedRows, juce::dontSendNotification);
 
-    if (firstRow >= 0)
+    if (!rows.empty())
     {
+        const int firstRow = rows.front();
         auto* vp = listBox.getViewport();
         int rowTop = firstRow * rowHeight;
         int viewTop = vp->getViewPositionY();
@@ -224,29 +187,30 @@ void EventListComponent::setSelectedNotes(const std::set<std::pair<int, int>>& s
 
 void EventListComponent::selectedRowsChanged(int lastRowSelected)
 {
-    if (updatingFromPlayhead || updatingFromNoteSelection)
+    if (updatingFromPlayhead || updatingFromNoteSelection || sequence == nullptr)
         return;
 
-    if (lastRowSelected >= 0 && lastRowSelected < static_cast<int>(items.size()))
+    if (lastRowSelected >= 0 && lastRowSelected < view.getNumRows())
     {
         lastPlayheadRow = lastRowSelected;
         if (onEventSelected)
-            onEventSelected(items[static_cast<size_t>(lastRowSelected)].tick);
+            onEventSelected(view.getItem(*sequence, lastRowSelected).tick);
     }
 
     if (onNoteSelectionFromList)
     {
-        std::set<std::pair<int, int>> noteRefs;
-        auto selectedRows = listBox.getSelectedRows();
-        for (int i = 0; i < selectedRows.size(); ++i)
+        // Walk each selected range with one merge cursor rather than resolving rows one by one.
+        std::set<std::pair<int, NoteId>> noteRefs;
+        const auto selectedRows = listBox.getSelectedRows();
+        for (int i = 0; i < selectedRows.getNumRanges(); ++i)
         {
-            int row = selectedRows[i];
-            if (row >= 0 && row < static_cast<int>(items.size()))
-            {
-                const auto& item = items[static_cast<size_t>(row)];
-                if (item.kind == EventListItem::Note)
-                    noteRefs.insert({item.trackIndex, item.sourceIndex});
-            }
+            const auto range = selectedRows.getRange(i);
+            view.forEachItem(*sequence, range.getStart(), range.getEnd(),
+                             [&](const EventListItem& item)
+                             {
+                                 if (item.kind == EventListItem::Note)
+                                     noteRefs.insert({item.trackIndex, item.noteId});
+                             });
         }
         onNoteSelectionFromList(noteRefs);
     }
@@ -293,16 +257,16 @@ void EventListComponent::resized()
 
 int EventListComponent::getNumRows()
 {
-    return static_cast<int>(items.size());
+    return view.getNumRows();
 }
 
 void EventListComponent::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
 {
     using namespace calliope::theme;
-    if (rowNumber < 0 || rowNumber >= static_cast<int>(items.size()))
+    if (sequence == nullptr || rowNumber < 0 || rowNumber >= view.getNumRows())
         return;
 
-    const auto& item = items[static_cast<size_t>(rowNumber)];
+    const auto item = view.getItem(*sequence, rowNumber);
 
     g.setColour(rowNumber % 2 == 0 ? surface::surface : surface::surface2);
     g.fillRect(0, 0, width, height);
@@ -1,33 +1,11 @@
 #pragma once
 
+#include "../model/EventListView.h"
 #include "../model/MidiSequence.h"
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <set>
 #include <vector>
 
-struct EventListItem
-{
-    enum Kind
-    {
-        Note,
-        ControlChange,
-        ProgramChange,
-        PitchBend,
-        ChannelPressure,
-        KeyPressure
-    };
-
-    Kind kind = Note;
-    int tick = 0;
-    int trackIndex = 0;
-    int sourceIndex = 0;
-    int noteNumber = 0;
-    int duration = 0;
-    int velocity = 0;
-    int data1 = 0;
-    int data2 = 0;
-};
-
 class EventListComponent : public juce::Component, public MidiSequence::Listener, private juce::ListBoxModel
 {
 public:
@@ -38,10 +16,10 @@ public:
     void setSelectedTracks(const std::set<int>& selected);
     void refresh();
     void setPlayheadTick(double tick);
-    void setSelectedNotes(const std::set<std::pair<int, int>>& selected);
+    void setSelectedNotes(const std::set<std::pair<int, NoteId>>& selected);
 
     std::function<void(int tick)> onEventSelected;
-    std::function<void(const std::set<std::pair<int, int>>& noteRefs)> onNoteSelectionFromList;
+    std::function<void(const std::set<std::pair<int, NoteId>>& noteRefs)> onNoteSelectionFromList;
 
     void paint(juce::Graphics& g) override;
     void resized() override;
@@ -52,6 +30,7 @@ public:
 
 private:
     void notesChanged(int trackIndex) override;
+    void notesEdited(const std::vector<DirtyTickRange>& ranges) override;
     void tracksChanged() override;
     void tempoChanged() override;
     void timelineMetadataChanged() override;
@@ -61,6 +40,7 @@ private:
     void selectedRowsChanged(int lastRowSelected) override;
 
     void rebuildList();
+    void contentChanged();
 
     static juce::String formatPosition(const BarBeatTick& bbt);
     static juce::String formatEvent(const EventListItem& item);
@@ -70,10 +50,12 @@ private:
 
     MidiSequence* sequence = nullptr;
     std::set<int> selectedTracks;
-    std::vector<EventListItem> items;
+    EventListView view;
 
     juce::ListBox listBox;
     int lastPlayheadRow = -1;
+    int lastPlayheadTick = -1;
+    bool lastPlayheadOnWholeTick = false;
     bool updatingFromPlayhead = false;
     bool updatingFromNoteSelection = false;
 };
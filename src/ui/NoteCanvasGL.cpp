@@ -0,0 +1,339 @@
+#include "NoteCanvasGL.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+static_assert(sizeof(NoteCanvasGL::Instance) == 24, "instances are compared and uploaded as raw bytes");
+
+namespace
+{
+// Mirrors the software path: notes whose body is under 4 px either way are plain rectangles, larger
+// ones get a 1 px outline, and drum hits are circles centred on their start.
+const char* const vertexShader = R"(
+in vec2 corner;
+in vec4 note;
+in vec4 fillColour;
+in vec4 outlineColour;
+uniform vec2 origin;
+uniform vec2 baseTick;
+uniform vec2 targetSize;
+uniform float pixelsPerTick;
+uniform float noteHeight;
+uniform float isDrum;
+out vec4 fill;
+out vec4 outline;
+out vec2 local;
+out vec2 size;
+
+void main()
+{
+    float h = noteHeight - 2.0;
+    float ticks = (note.x - baseTick.x) * 65536.0 + (note.y - baseTick.y);
+    float x = floor(ticks * pixelsPerTick);
+    float w = max(floor(note.z * pixelsPerTick), 1.0);
+    if (isDrum > 0.5)
+    {
+        x -= h * 0.5;
+        w = h;
+    }
+    size = vec2(w, h);
+    local = corner * size;
+    vec2 pos = origin + vec2(x, (127.0 - note.w) * noteHeight + 1.0) + local;
+    gl_Position = vec4(pos.x / targetSize.x * 2.0 - 1.0, 1.0 - pos.y / targetSize.y * 2.0, 0.0, 1.0);
+    fill = fillColour;
+    outline = outlineColour;
+}
+)";
+
+const char* const fragmentShader = R"(
+in vec4 fill;
+in vec4 outline;
+in vec2 local;
+in vec2 size;
+uniform float isDrum;
+out vec4 fragColour;
+
+void main()
+{
+    vec4 colour = fill;
+    if (min(size.x, size.y) >= 4.0)
+    {
+        if (isDrum > 0.5)
+        {
+            float radius = size.x * 0.5;
+            float distance = length(local - vec2(radius));
+            if (distance > radius)
+                discard;
+            if (distance > radius - 1.0)
+                colour = outline;
+        }
+        else if (min(min(local.x, size.x - local.x), min(local.y, size.y - local.y)) < 1.0)
+        {
+            colour = outline;
+        }
+    }
+    fragColour = vec4(colour.rgb * colour.a, colour.a);
+}
+)";
+
+juce::String withVersion(const char* body)
+{
+    return juce::OpenGLHelpers::getGLSLVersionString() + "\n#ifdef GL_ES\nprecision mediump float;\n#endif\n" + body;
+}
+} // namespace
+
+NoteCanvasGL::NoteCanvasGL(Source& s) : source(s)
+{
+    context.setRenderer(this);
+    context.setComponentPaintingEnabled(true);
+    context.setContinuousRepainting(false);
+    context.setOpenGLVersionRequired(juce::OpenGLContext::openGL3_2);
+}
+
+NoteCanvasGL::~NoteCanvasGL()
+{
+    detach();
+}
+
+void NoteCanvasGL::attachTo(juce::Component& target)
+{
+    context.attachTo(target);
+}
+
+void NoteCanvasGL::detach()
+{
+    context.detach();
+    active = false;
+}
+
+void NoteCanvasGL::newOpenGLContextCreated()
+{
+    using namespace juce::gl;
+    if (glDrawArraysInstanced == nullptr || glVertexAttribDivisor == nullptr || !createShaders())
+    {
+        fail();
+        return;
+    }
+
+    const GLfloat corners[] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    active = true;
+    if (onActivated)
+        juce::MessageManager::callAsync(onActivated);
+}
+
+bool NoteCanvasGL::createShaders()
+{
+    using namespace juce::gl;
+    auto shader = std::make_unique<juce::OpenGLShaderProgram>(context);
+    if (!shader->addVertexShader(withVersion(vertexShader))
+        || !shader->addFragmentShader(withVersion(fragmentShader)) || !shader->link())
+        return false;
+
+    const auto id = shader->getProgramID();
+    cornerAttribute = glGetAttribLocation(id, "corner");
+    noteAttribute = glGetAttribLocation(id, "note");
+    fillAttribute = glGetAttribLocation(id, "fillColour");
+    outlineAttribute = glGetAttribLocation(id, "outlineColour");
+    if (cornerAttribute < 0 || noteAttribute < 0 || fillAttribute < 0 || outlineAttribute < 0)
+        return false;
+
+    program = std::move(shader);
+    return true;
+}
+
+void NoteCanvasGL::fail()
+{
+    active = false;
+    if (onUnavailable)
+        juce::MessageManager::callAsync(onUnavailable);
+}
+
+void NoteCanvasGL::renderOpenGL()
+{
+    if (!active)
+        return;
+
+    // Frames caused by a component repaint run under the message manager lock, so that is when the
+    // scene is refreshed; any other frame redraws what the buffers already hold.
+    if (juce::MessageManager::existsAndIsLockedByCurrentThread())
+        syncFrame();
+
+    juce::OpenGLHelpers::clear(juce::Colours::black);
+    if (targetWidth <= 0.0f || targetHeight <= 0.0f)
+        return;
+
+    if (frame.background.isValid())
+    {
+        const auto scale = static_cast<float>(context.getRenderingScale());
+        std::unique_ptr<juce::LowLevelGraphicsContext> glRenderer(
+            juce::createOpenGLGraphicsContext(context, juce::roundToInt(targetWidth * scale),
+                                              juce::roundToInt(targetHeight * scale)));
+        juce::Graphics g(*glRenderer);
+        g.addTransform(juce::AffineTransform::scale(scale));
+        g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+        g.drawImage(frame.background, frame.backgroundArea);
+    }
+
+    drawTracks();
+}
+
+void NoteCanvasGL::syncFrame()
+{
+    using namespace juce::gl;
+    if (auto* target = context.getTargetComponent())
+    {
+        targetWidth = static_cast<float>(target->getWidth());
+        targetHeight = static_cast<float>(target->getHeight());
+    }
+
+    Frame next;
+    if (source.getNoteCanvasFrame(next, static_cast<float>(context.getRenderingScale())))
+        frame = std::move(next);
+    else
+        frame = {};
+
+    std::map<int, GpuTrack> kept;
+    for (const auto& layer : frame.layers)
+    {
+        auto node = tracks.extract(layer.trackIndex);
+        const bool isNew = node.empty();
+        GpuTrack track = isNew ? GpuTrack{} : std::move(node.mapped());
+        if (isNew)
+            glGenBuffers(1, &track.buffer);
+
+        if (isNew || track.signature != layer.signature)
+        {
+            scratch.clear();
+            source.getNoteInstances(layer.trackIndex, scratch);
+            uploadTrack(track, scratch);
+            track.signature = layer.signature;
+        }
+        track.isDrum = layer.isDrum;
+        kept.emplace(layer.trackIndex, std::move(track));
+    }
+
+    for (auto& [trackIndex, track] : tracks)
+        glDeleteBuffers(1, &track.buffer);
+    tracks = std::move(kept);
+}
+
+void NoteCanvasGL::uploadTrack(GpuTrack& track, std::vector<Instance>& fresh)
+{
+    using namespace juce::gl;
+    constexpr auto stride = sizeof(Instance);
+    const auto count = static_cast<int>(fresh.size());
+    glBindBuffer(GL_ARRAY_BUFFER, track.buffer);
+
+    if (count > track.capacity)
+    {
+        track.capacity = std::max(count, track.capacity + track.capacity / 2);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(static_cast<std::size_t>(track.capacity) * stride),
+                     nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(fresh.size() * stride), fresh.data());
+    }
+    else
+    {
+        // Edits and selection changes touch few slots, so only the span between the first and last
+        // differing instance is sent. Instances past the new end are simply no longer drawn.
+        const auto& old = track.instances;
+        const int common = std::min(count, static_cast<int>(old.size()));
+        int first = 0;
+        while (first < common && std::memcmp(&fresh[static_cast<std::size_t>(first)],
+                                             &old[static_cast<std::size_t>(first)], stride) == 0)
+            ++first;
+        int last = count;
+        if (count == static_cast<int>(old.size()))
+            while (last > first && std::memcmp(&fresh[static_cast<std::size_t>(last - 1)],
+                                               &old[static_cast<std::size_t>(last - 1)], stride) == 0)
+                --last;
+
+        if (last > first)
+            glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(static_cast<std::size_t>(first) * stride),
+                            static_cast<GLsizeiptr>(static_cast<std::size_t>(last - first) * stride),
+                            fresh.data() + first);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    track.instances.swap(fresh);
+}
+
+void NoteCanvasGL::drawTracks()
+{
+    using namespace juce::gl;
+    constexpr auto stride = static_cast<GLsizei>(sizeof(Instance));
+    const auto corner = static_cast<GLuint>(cornerAttribute);
+    const auto note = static_cast<GLuint>(noteAttribute);
+    const auto fill = static_cast<GLuint>(fillAttribute);
+    const auto outline = static_cast<GLuint>(outlineAttribute);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    program->use();
+    program->setUniform("origin", frame.origin.x, frame.origin.y);
+    program->setUniform("baseTick", static_cast<float>(frame.baseTick >> 16),
+                        static_cast<float>(frame.baseTick & 0xffff));
+    program->setUniform("targetSize", targetWidth, targetHeight);
+    program->setUniform("pixelsPerTick", frame.pixelsPerTick);
+    program->setUniform("noteHeight", frame.noteHeight);
+
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glEnableVertexAttribArray(corner);
+    glVertexAttribPointer(corner, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glVertexAttribDivisor(corner, 0);
+
+    glEnableVertexAttribArray(note);
+    glEnableVertexAttribArray(fill);
+    glEnableVertexAttribArray(outline);
+    for (const auto& layer : frame.layers)
+    {
+        const auto it = tracks.find(layer.trackIndex);
+        if (it == tracks.end() || it->second.instances.empty())
+            continue;
+
+        const auto& track = it->second;
+        glBindBuffer(GL_ARRAY_BUFFER, track.buffer);
+        glVertexAttribPointer(note, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const void*>(offsetof(Instance, startHigh)));
+        glVertexAttribPointer(fill, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              reinterpret_cast<const void*>(offsetof(Instance, fill)));
+        glVertexAttribPointer(outline, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                              reinterpret_cast<const void*>(offsetof(Instance, outline)));
+        glVertexAttribDivisor(note, 1);
+        glVertexAttribDivisor(fill, 1);
+        glVertexAttribDivisor(outline, 1);
+
+        program->setUniform("isDrum", track.isDrum ? 1.0f : 0.0f);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(track.instances.size()));
+    }
+
+    glDisableVertexAttribArray(outline);
+    glDisableVertexAttribArray(fill);
+    glDisableVertexAttribArray(note);
+    glDisableVertexAttribArray(corner);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void NoteCanvasGL::openGLContextClosing()
+{
+    using namespace juce::gl;
+    for (auto& [trackIndex, track] : tracks)
+        glDeleteBuffers(1, &track.buffer);
+    tracks.clear();
+    if (quadBuffer != 0)
+        glDeleteBuffers(1, &quadBuffer);
+    if (vertexArray != 0)
+        glDeleteVertexArrays(1, &vertexArray);
+    quadBuffer = 0;
+    vertexArray = 0;
+    program.reset();
+    frame = {};
+    active = false;
+}
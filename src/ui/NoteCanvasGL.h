@@ -0,0 +1,119 @@
+#pragma once
+
+#include <juce_opengl/juce_opengl.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Draws the piano roll grid image and its notes with OpenGL, underneath the component painting of
+// the component the context is attached to. Notes are kept in one instance buffer per track and
+// drawn as instanced quads; a track's buffer is only re-uploaded where its instances changed.
+class NoteCanvasGL : private juce::OpenGLRenderer
+{
+public:
+    // One note as uploaded to the GPU. Positions stay in ticks and pitches so zooming and scrolling
+    // never touch the buffers. A float only holds ticks exactly up to 2^24, so the start is split into
+    // startHigh * 65536 + startLow and the shader takes the frame's base tick off each half before
+    // combining them. Colours are straight RGBA.
+    struct Instance
+    {
+        float startHigh;
+        float startLow;
+        float duration;
+        float noteNumber;
+        std::uint8_t fill[4];
+        std::uint8_t outline[4];
+
+        // Colours are left for the caller to fill in.
+        static Instance make(int startTick, int duration, int noteNumber)
+        {
+            return {static_cast<float>(startTick >> 16), static_cast<float>(startTick & 0xffff),
+                    static_cast<float>(duration), static_cast<float>(noteNumber), {}, {}};
+        }
+    };
+
+    struct TrackLayer
+    {
+        int trackIndex = 0;
+        // Changes whenever the track's instances would (notes, colour, selection).
+        std::uint64_t signature = 0;
+        bool isDrum = false;
+    };
+
+    // Everything a frame needs, in the coordinates of the component the context is attached to.
+    // origin is where baseTick of pitch 127 starts; baseTick should be near the visible area. The
+    // background must not be drawn into once handed over, since frames may still use it off the lock.
+    struct Frame
+    {
+        juce::Point<float> origin;
+        int baseTick = 0;
+        float pixelsPerTick = 0.0f;
+        float noteHeight = 0.0f;
+        juce::Image background;
+        juce::Rectangle<float> backgroundArea;
+        std::vector<TrackLayer> layers;
+    };
+
+    // Queried on the OpenGL thread, but only while it holds the message manager lock.
+    class Source
+    {
+    public:
+        virtual ~Source() = default;
+        virtual bool getNoteCanvasFrame(Frame& frame, float renderingScale) = 0;
+        virtual void getNoteInstances(int trackIndex, std::vector<Instance>& instances) = 0;
+    };
+
+    explicit NoteCanvasGL(Source& source);
+    ~NoteCanvasGL() override;
+
+    void attachTo(juce::Component& target);
+    void detach();
+    // True once the context is up and the shaders compiled; until then the caller paints notes itself.
+    bool isActive() const { return active.load(); }
+
+    // Called on the message thread if the context cannot draw instanced notes.
+    std::function<void()> onUnavailable;
+    // Called on the message thread once the canvas has taken over note drawing.
+    std::function<void()> onActivated;
+
+private:
+    struct GpuTrack
+    {
+        juce::gl::GLuint buffer = 0;
+        int capacity = 0;
+        std::uint64_t signature = 0;
+        bool isDrum = false;
+        std::vector<Instance> instances;
+    };
+
+    void newOpenGLContextCreated() override;
+    void renderOpenGL() override;
+    void openGLContextClosing() override;
+
+    bool createShaders();
+    void syncFrame();
+    void uploadTrack(GpuTrack& track, std::vector<Instance>& fresh);
+    void drawTracks();
+    void fail();
+
+    Source& source;
+    juce::OpenGLContext context;
+    std::atomic<bool> active{false};
+
+    // Only touched on the OpenGL thread.
+    std::unique_ptr<juce::OpenGLShaderProgram> program;
+    juce::gl::GLuint vertexArray = 0;
+    juce::gl::GLuint quadBuffer = 0;
+    juce::gl::GLint cornerAttribute = -1;
+    juce::gl::GLint noteAttribute = -1;
+    juce::gl::GLint fillAttribute = -1;
+    juce::gl::GLint outlineAttribute = -1;
+    Frame frame;
+    float targetWidth = 0.0f;
+    float targetHeight = 0.0f;
+    std::map<int, GpuTrack> tracks;
+    std::vector<Instance> scratch;
+};
@@ -2,15 +2,64 @@
 #include "../model/UndoActions.h"
 #include "TrackColours.h"
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
+namespace
+{
+// Below this many pixels wide or tall, notes are drawn as plain rectangles.
+constexpr float kPlainNotePixels = 4.0f;
+
+// FNV-1a over the values a cached OpenGL note layer is drawn from.
+struct LayerHash
+{
+    std::uint64_t value = 14695981039346656037ull;
+
+    template <typename T>
+    void add(T v)
+    {
+        std::uint64_t bits = 0;
+        if constexpr (std::is_floating_point_v<T>)
+            bits = std::bit_cast<std::uint64_t>(static_cast<double>(v));
+        else
+            bits = static_cast<std::uint64_t>(v);
+        for (int i = 0; i < 8; ++i)
+            value = (value ^ ((bits >> (i * 8)) & 0xff)) * 1099511628211ull;
+    }
+};
+
+// Keyboard navigation order: by start tick, then pitch.
+std::vector<NoteId> notesInPlayOrder(const MidiTrack& track)
+{
+    std::vector<NoteId> order;
+    order.reserve(static_cast<std::size_t>(track.getNumNotes()));
+    for (int slot = 0; slot < track.getNumNotes(); ++slot)
+        order.push_back(track.getNoteId(slot));
+
+    std::sort(order.begin(), order.end(),
+              [&track](NoteId a, NoteId b)
+              {
+                  const auto na = track.getNote(a);
+                  const auto nb = track.getNote(b);
+                  if (na.startTick != nb.startTick)
+                      return na.startTick < nb.startTick;
+                  if (na.noteNumber != nb.noteNumber)
+                      return na.noteNumber < nb.noteNumber;
+                  return a < b;
+              });
+    return order;
+}
+} // namespace
+
 void PianoRollComponent::startNotePreview(const MidiNote& note)
 {
     stopNotePreview();
     previewNote = note;
     isPreviewing = true;
+    invalidateStaticLayers();
     if (onNotePreview)
         onNotePreview(previewNote);
     repaint();
@@ -23,6 +72,7 @@ void PianoRollComponent::stopNotePreview()
     if (onNotePreviewEnd)
         onNotePreviewEnd(previewNote);
     isPreviewing = false;
+    invalidateStaticLayers();
     repaint();
 }
 
@@ -153,33 +203,20 @@ void PianoRollComponent::moveSelectionToAdjacentNote(int direction)
     if (n == 0)
         return;
 
-    std::vector<int> order(n);
-    for (int i = 0; i < n; ++i)
-        order[i] = i;
-    std::sort(order.begin(), order.end(),
-              [&track](int a, int b)
-              {
-                  const auto& na = track.getNote(a);
-                  const auto& nb = track.getNote(b);
-                  if (na.startTick != nb.startTick)
-                      return na.startTick < nb.startTick;
-                  if (na.noteNumber != nb.noteNumber)
-                      return na.noteNumber < nb.noteNumber;
-                  return a < b;
-              });
+    const auto order = notesInPlayOrder(track);
 
-    auto posOf = [&order](int noteIndex)
+    auto posOf = [&order](NoteId id)
     {
         for (int p = 0; p < static_cast<int>(order.size()); ++p)
-            if (order[p] == noteIndex)
+            if (order[p] == id)
                 return p;
         return -1;
     };
 
-    int refIndex = -1;
+    NoteId refId = NoteId::invalid;
     if (selectedNote.isValid() && selectedNote.trackIndex == activeTrackIndex && selectedNotes.contains(selectedNote))
     {
-        refIndex = selectedNote.noteIndex;
+        refId = selectedNote.noteId;
     }
     else
     {
@@ -189,7 +226,7 @@ void PianoRollComponent::moveSelectionToAdjacentNote(int direction)
         {
             if (ref.trackIndex != activeTrackIndex)
                 continue;
-            int p = posOf(ref.noteIndex);
+            int p = posOf(ref.noteId);
             if (p < 0)
                 continue;
             if (minPos < 0 || p < minPos)
@@ -198,13 +235,13 @@ void PianoRollComponent::moveSelectionToAdjacentNote(int direction)
                 maxPos = p;
         }
         if (maxPos >= 0)
-            refIndex = order[direction > 0 ? maxPos : minPos];
+            refId = order[direction > 0 ? maxPos : minPos];
     }
 
     int targetPos;
-    if (refIndex >= 0)
+    if (refId != NoteId::invalid)
     {
-        int np = posOf(refIndex) + (direction > 0 ? 1 : -1);
+        int np = posOf(refId) + (direction > 0 ? 1 : -1);
         if (np < 0 || np >= n)
             return;
         targetPos = np;
@@ -219,7 +256,7 @@ void PianoRollComponent::moveSelectionToAdjacentNote(int direction)
     selectedNotes.insert(target);
     selectedNote = target;
 
-    const auto& note = track.getNote(target.noteIndex);
+    const auto& note = track.getNote(target.noteId);
     startNotePreview(note);
     startTimer(previewHoldMs);
 
@@ -240,7 +277,7 @@ void PianoRollComponent::nudgeSelectedNotesPitch(int deltaNote)
     int maxNote = 0;
     for (const auto& ref : selectedNotes)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         minNote = std::min(minNote, note.noteNumber);
         maxNote = std::max(maxNote, note.noteNumber);
     }
@@ -256,11 +293,11 @@ void PianoRollComponent::nudgeSelectedNotesPitch(int deltaNote)
         std::vector<NoteModification> mods;
         for (const auto& ref : selectedNotes)
         {
-            auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+            const auto note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
             MidiNote beforeNote = note;
             MidiNote afterNote = note;
             afterNote.noteNumber = note.noteNumber + deltaNote;
-            mods.push_back({ref.trackIndex, ref.noteIndex, beforeNote, afterNote});
+            mods.push_back({ref.trackIndex, ref.noteId, beforeNote, afterNote});
         }
         if (!mods.empty())
             undoManager->perform(new MultiNoteModifyAction(sequence, std::move(mods)));
@@ -269,14 +306,16 @@ void PianoRollComponent::nudgeSelectedNotesPitch(int deltaNote)
     {
         for (const auto& ref : selectedNotes)
         {
-            auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+            auto& track = sequence->getTrack(ref.trackIndex);
+            auto note = track.getNote(ref.noteId);
             note.noteNumber = note.noteNumber + deltaNote;
+            track.setNote(ref.noteId, note);
         }
     }
 
     NoteRef previewRef =
         (selectedNote.isValid() && selectedNotes.contains(selectedNote)) ? selectedNote : *selectedNotes.begin();
-    const auto& previewNoteRef = sequence->getTrack(previewRef.trackIndex).getNote(previewRef.noteIndex);
+    const auto& previewNoteRef = sequence->getTrack(previewRef.trackIndex).getNote(previewRef.noteId);
     startNotePreview(previewNoteRef);
     startTimer(previewHoldMs);
 
@@ -297,7 +336,7 @@ void PianoRollComponent::nudgeSelectedNotesTime(int deltaTick)
     int minStart = std::numeric_limits<int>::max();
     for (const auto& ref : selectedNotes)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         minStart = std::min(minStart, note.startTick);
     }
 
@@ -310,11 +349,11 @@ void PianoRollComponent::nudgeSelectedNotesTime(int deltaTick)
         std::vector<NoteModification> mods;
         for (const auto& ref : selectedNotes)
         {
-            auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+            const auto note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
             MidiNote beforeNote = note;
             MidiNote afterNote = note;
             afterNote.startTick = note.startTick + deltaTick;
-            mods.push_back({ref.trackIndex, ref.noteIndex, beforeNote, afterNote});
+            mods.push_back({ref.trackIndex, ref.noteId, beforeNote, afterNote});
         }
         if (!mods.empty())
             undoManager->perform(new MultiNoteModifyAction(sequence, std::move(mods)));
@@ -323,14 +362,16 @@ void PianoRollComponent::nudgeSelectedNotesTime(int deltaTick)
     {
         for (const auto& ref : selectedNotes)
         {
-            auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+            auto& track = sequence->getTrack(ref.trackIndex);
+            auto note = track.getNote(ref.noteId);
             note.startTick = note.startTick + deltaTick;
+            track.setNote(ref.noteId, note);
         }
     }
 
     NoteRef anchorRef =
         (selectedNote.isValid() && selectedNotes.contains(selectedNote)) ? selectedNote : *selectedNotes.begin();
-    const auto& anchorNote = sequence->getTrack(anchorRef.trackIndex).getNote(anchorRef.noteIndex);
+    const auto& anchorNote = sequence->getTrack(anchorRef.trackIndex).getNote(anchorRef.noteId);
 
     if (onScrollToNote)
         onScrollToNote(anchorNote.startTick, anchorNote.noteNumber);
@@ -350,7 +391,7 @@ bool PianoRollComponent::duplicateSelectedNotesWithPitchOffset(int deltaNote)
     int maxNote = 0;
     for (const auto& ref : selectedNotes)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         minNote = std::min(minNote, note.noteNumber);
         maxNote = std::max(maxNote, note.noteNumber);
     }
@@ -364,7 +405,7 @@ bool PianoRollComponent::duplicateSelectedNotesWithPitchOffset(int deltaNote)
     notesToAdd.reserve(selectedNotes.size());
     for (const auto& ref : selectedNotes)
     {
-        MidiNote note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        MidiNote note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         note.noteNumber += deltaNote;
         notesToAdd.push_back(note);
     }
@@ -376,25 +417,21 @@ bool PianoRollComponent::duplicateSelectedNotesWithPitchOffset(int deltaNote)
         undoManager->beginNewTransaction(notesToAdd.size() > 1 ? "Duplicate Notes" : "Duplicate Note");
         auto* action = new MultiNoteAddAction(sequence, activeTrackIndex, notesToAdd);
         undoManager->perform(action);
-        int start = action->getAddedStartIndex();
-        for (int i = 0; i < action->getAddedCount(); ++i)
-            selectedNotes.insert({activeTrackIndex, start + i});
+        for (NoteId id : action->getAddedIds())
+            selectedNotes.insert({activeTrackIndex, id});
     }
     else
     {
         auto& track = sequence->getTrack(activeTrackIndex);
-        int start = track.getNumNotes();
         for (const auto& n : notesToAdd)
-            track.addNote(n);
-        for (int i = 0; i < static_cast<int>(notesToAdd.size()); ++i)
-            selectedNotes.insert({activeTrackIndex, start + i});
+            selectedNotes.insert({activeTrackIndex, track.addNote(n)});
     }
 
     if (selectedNotes.empty())
         return false;
     selectedNote = *selectedNotes.begin();
 
-    const auto& previewNoteRef = sequence->getTrack(selectedNote.trackIndex).getNote(selectedNote.noteIndex);
+    const auto& previewNoteRef = sequence->getTrack(selectedNote.trackIndex).getNote(selectedNote.noteId);
     startNotePreview(previewNoteRef);
     startTimer(previewHoldMs);
 
@@ -413,24 +450,64 @@ bool PianoRollComponent::duplicateSelectedNotesWithPitchOffset(int deltaNote)
 
 PianoRollComponent::~PianoRollComponent()
 {
+    noteCanvas.reset();
     if (sequence != nullptr)
         sequence->removeListener(this);
 }
 
+void PianoRollComponent::pruneVanishedSelection()
+{
+    // Ids stay valid across edits, so only notes that no longer exist (e.g. after an undo) drop out.
+    auto isGone = [this](const NoteRef& ref)
+    {
+        return ref.trackIndex >= sequence->getNumTracks() || !sequence->getTrack(ref.trackIndex).hasNote(ref.noteId);
+    };
+    std::erase_if(selectedNotes, isGone);
+    if (selectedNote.isValid() && isGone(selectedNote))
+        selectedNote = {};
+}
+
 void PianoRollComponent::notesChanged(int)
 {
+    pruneVanishedSelection();
     repaint();
 }
+
+void PianoRollComponent::notesEdited(const std::vector<DirtyTickRange>& ranges)
+{
+    pruneVanishedSelection();
+
+    // Only the columns spanned by the edited notes need redrawing.
+    int startTick = std::numeric_limits<int>::max();
+    int endTick = 0;
+    for (const auto& range : ranges)
+    {
+        startTick = std::min(startTick, range.startTick);
+        endTick = std::max(endTick, range.endTick);
+    }
+    if (endTick <= startTick)
+        return;
+
+    // Clamped in ticks first: open-ended ranges reach INT_MAX, which has no pixel position.
+    const int lastTick = xToTick(getWidth()) + 1;
+    startTick = juce::jlimit(0, lastTick, startTick);
+    endTick = juce::jlimit(0, lastTick, endTick);
+    const int x = juce::jlimit(0, getWidth(), tickToX(startTick) - 2);
+    const int r = juce::jlimit(0, getWidth(), tickToX(endTick) + 3);
+    repaint(x, 0, r - x, getHeight());
+}
 void PianoRollComponent::tracksChanged()
 {
     repaint();
 }
 void PianoRollComponent::tempoChanged()
 {
+    invalidateStaticLayers();
     repaint();
 }
 void PianoRollComponent::timelineMetadataChanged()
 {
+    invalidateStaticLayers();
     repaint();
 }
 
@@ -444,21 +521,14 @@ void PianoRollComponent::setSequence(MidiSequence* seq)
 
     selectedTempoIndices.clear();
     isTempoRangeSelecting = false;
+    invalidateStaticLayers();
 
     contentBeats = 16;
     if (sequence && sequence->getNumTracks() > 0)
     {
         int lastTick = 0;
         for (int t = 0; t < sequence->getNumTracks(); ++t)
-        {
-            const auto& track = sequence->getTrack(t);
-            for (int i = 0; i < track.getNumNotes(); ++i)
-            {
-                int end = track.getNote(i).endTick();
-                if (end > lastTick)
-                    lastTick = end;
-            }
-        }
+            lastTick = std::max(lastTick, sequence->getTrack(t).getLastEndTick());
         contentBeats = std::max(contentBeats, lastTick / sequence->getTicksPerQuarterNote() + 4);
     }
 
@@ -547,15 +617,17 @@ std::vector<PianoRollComponent::NoteRef> PianoRollComponent::findNotesInRect(con
         return result;
 
     const auto& track = sequence->getTrack(activeTrackIndex);
-    for (int i = 0; i < track.getNumNotes(); ++i)
+    const auto [fromTick, toTick] = tickRangeForPixels(rect.getX(), rect.getRight());
+    track.findNotesInRange(fromTick, toTick, visibleNoteIds);
+    for (NoteId id : visibleNoteIds)
     {
-        const auto& note = track.getNote(i);
+        const auto note = track.getNote(id);
         int nx = tickToX(note.startTick);
         int ny = noteToY(note.noteNumber);
         int nw = tickToWidth(note.duration);
         juce::Rectangle<int> noteRect(nx, ny, nw, noteHeight);
         if (rect.intersects(noteRect))
-            result.push_back({activeTrackIndex, i});
+            result.push_back({activeTrackIndex, id});
     }
     return result;
 }
@@ -587,14 +659,14 @@ void PianoRollComponent::copySelectedNotes()
     int minTick = std::numeric_limits<int>::max();
     for (const auto& ref : selectedNotes)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         if (note.startTick < minTick)
             minTick = note.startTick;
     }
 
     for (const auto& ref : selectedNotes)
     {
-        MidiNote note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        MidiNote note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         note.startTick -= minTick;
         clipboard.push_back(note);
     }
@@ -614,16 +686,8 @@ void PianoRollComponent::cutSelectedNotes()
     }
     else
     {
-        std::map<int, std::vector<int>> toRemove;
         for (const auto& ref : selectedNotes)
-            toRemove[ref.trackIndex].push_back(ref.noteIndex);
-
-        for (auto& [trackIdx, indices] : toRemove)
-        {
-            std::sort(indices.begin(), indices.end(), std::greater<int>());
-            for (int idx : indices)
-                sequence->getTrack(trackIdx).removeNote(idx);
-        }
+            sequence->getTrack(ref.trackIndex).removeNote(ref.noteId);
     }
 
     selectedNotes.clear();
@@ -639,56 +703,31 @@ void PianoRollComponent::deleteSelectedNotes()
     if (!sequence || selectedNotes.empty())
         return;
 
-    int survivorOldIndex = -1;
+    NoteId survivorId = NoteId::invalid;
     if (activeTrackIndex >= 0 && activeTrackIndex < sequence->getNumTracks())
     {
-        auto& track = sequence->getTrack(activeTrackIndex);
-        const int n = track.getNumNotes();
-        if (n > 0)
-        {
-            std::vector<int> order(n);
-            for (int i = 0; i < n; ++i)
-                order[i] = i;
-            std::sort(order.begin(), order.end(),
-                      [&track](int a, int b)
-                      {
-                          const auto& na = track.getNote(a);
-                          const auto& nb = track.getNote(b);
-                          if (na.startTick != nb.startTick)
-                              return na.startTick < nb.startTick;
-                          if (na.noteNumber != nb.noteNumber)
-                              return na.noteNumber < nb.noteNumber;
-                          return a < b;
-                      });
-
-            int minPos = -1;
-            int maxPos = -1;
-            for (int p = 0; p < n; ++p)
-            {
-                if (selectedNotes.contains({activeTrackIndex, order[p]}))
-                {
-                    if (minPos < 0)
-                        minPos = p;
-                    maxPos = p;
-                }
-            }
+        const auto order = notesInPlayOrder(sequence->getTrack(activeTrackIndex));
+        const int n = static_cast<int>(order.size());
 
-            if (maxPos >= 0)
+        int minPos = -1;
+        int maxPos = -1;
+        for (int p = 0; p < n; ++p)
+        {
+            if (selectedNotes.contains({activeTrackIndex, order[p]}))
             {
-                if (maxPos + 1 < n)
-                    survivorOldIndex = order[maxPos + 1];
-                else if (minPos - 1 >= 0)
-                    survivorOldIndex = order[minPos - 1];
+                if (minPos < 0)
+                    minPos = p;
+                maxPos = p;
             }
         }
-    }
 
-    int deletedBeforeSurvivor = 0;
-    if (survivorOldIndex >= 0)
-    {
-        for (const auto& ref : selectedNotes)
-            if (ref.trackIndex == activeTrackIndex && ref.noteIndex < survivorOldIndex)
-                ++deletedBeforeSurvivor;
+        if (maxPos >= 0)
+        {
+            if (maxPos + 1 < n)
+                survivorId = order[maxPos + 1];
+            else if (minPos - 1 >= 0)
+                survivorId = order[minPos - 1];
+        }
     }
 
     if (undoManager)
@@ -698,26 +737,18 @@ void PianoRollComponent::deleteSelectedNotes()
     }
     else
     {
-        std::map<int, std::vector<int>> toRemove;
         for (const auto& ref : selectedNotes)
-            toRemove[ref.trackIndex].push_back(ref.noteIndex);
-
-        for (auto& [trackIdx, indices] : toRemove)
-        {
-            std::sort(indices.begin(), indices.end(), std::greater<int>());
-            for (int idx : indices)
-                sequence->getTrack(trackIdx).removeNote(idx);
-        }
+            sequence->getTrack(ref.trackIndex).removeNote(ref.noteId);
     }
 
     selectedNotes.clear();
-    if (survivorOldIndex >= 0)
+    if (survivorId != NoteId::invalid)
     {
-        const NoteRef survivor{activeTrackIndex, survivorOldIndex - deletedBeforeSurvivor};
+        const NoteRef survivor{activeTrackIndex, survivorId};
         selectedNotes.insert(survivor);
         selectedNote = survivor;
 
-        const auto& note = sequence->getTrack(survivor.trackIndex).getNote(survivor.noteIndex);
+        const auto note = sequence->getTrack(survivor.trackIndex).getNote(survivor.noteId);
         if (onScrollToNote)
             onScrollToNote(note.startTick, note.noteNumber);
     }
@@ -740,8 +771,8 @@ void PianoRollComponent::selectAllNotes()
 
     selectedNotes.clear();
     const auto& track = sequence->getTrack(activeTrackIndex);
-    for (int i = 0; i < track.getNumNotes(); ++i)
-        selectedNotes.insert({activeTrackIndex, i});
+    for (int slot = 0; slot < track.getNumNotes(); ++slot)
+        selectedNotes.insert({activeTrackIndex, track.getNoteId(slot)});
 
     repaint();
     if (onNoteSelectionChanged)
@@ -776,18 +807,14 @@ void PianoRollComponent::pasteNotes(int atTick)
         undoManager->beginNewTransaction("Paste Notes");
         auto* action = new MultiNoteAddAction(sequence, activeTrackIndex, notesToAdd);
         undoManager->perform(action);
-        int start = action->getAddedStartIndex();
-        for (int i = 0; i < action->getAddedCount(); ++i)
-            selectedNotes.insert({activeTrackIndex, start + i});
+        for (NoteId id : action->getAddedIds())
+            selectedNotes.insert({activeTrackIndex, id});
     }
     else
     {
         auto& track = sequence->getTrack(activeTrackIndex);
-        int start = track.getNumNotes();
         for (const auto& n : notesToAdd)
-            track.addNote(n);
-        for (int i = 0; i < static_cast<int>(notesToAdd.size()); ++i)
-            selectedNotes.insert({activeTrackIndex, start + i});
+            selectedNotes.insert({activeTrackIndex, track.addNote(n)});
     }
 
     repaint();
@@ -799,34 +826,79 @@ void PianoRollComponent::pasteNotes(int atTick)
 
 void PianoRollComponent::setPlayheadTick(double tick)
 {
-    auto toX = [this](double t) -> int
-    {
-        if (!sequence)
-            return keyboardWidth;
-        return keyboardWidth + static_cast<int>(t / sequence->getTicksPerQuarterNote() * beatWidth);
-    };
-
-    int oldX = toX(playheadTick);
+    const int oldX = getPlayheadX();
     playheadTick = tick;
-    int newX = toX(playheadTick);
+    const int newX = getPlayheadX();
+    if (newX == oldX)
+        return;
 
-    int margin = 2;
-    int h = getHeight();
-    repaint(oldX - margin, 0, margin * 2 + 2, h);
-    repaint(newX - margin, 0, margin * 2 + 2, h);
+    // Only the two pixel columns the line leaves and enters change; everything else is untouched.
+    const auto visible = getVisibleArea();
+    repaint(oldX, visible.getY(), 1, visible.getHeight());
+    repaint(newX, visible.getY(), 1, visible.getHeight());
+    if (showFrameTimes)
+        repaint(getFrameTimesBounds());
+}
+
+int PianoRollComponent::getPlayheadX() const
+{
+    if (!sequence)
+        return keyboardWidth;
+    return keyboardWidth + static_cast<int>(playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
 }
 
 void PianoRollComponent::paint(juce::Graphics& g)
 {
-    using namespace calliope::theme;
-    g.fillAll(surface::surface);
-    drawGrid(g);
+    const auto paintStart = juce::Time::getHighResolutionTicks();
+    // With the OpenGL canvas active, the grid and notes are already drawn underneath this component.
+    const bool notesOnGL = noteCanvas != nullptr && noteCanvas->isActive();
+    const auto visible = getVisibleArea();
+
+    if (!notesOnGL)
+    {
+        if (staticLayerCacheEnabled)
+            drawStaticLayer(g, gridLayer, visible.withTrimmedLeft(keyboardWidth).withTrimmedTop(gridTopOffset),
+                            &PianoRollComponent::drawGridLayer);
+        else
+            drawGridLayer(g);
+    }
     drawLoopRegion(g);
-    drawNotes(g);
+    if (!notesOnGL)
+        drawNotes(g);
     drawMoveGhosts(g);
     drawRubberBand(g);
+    if (staticLayerCacheEnabled)
+    {
+        drawStaticLayer(g, keyboardLayer, visible.withTrimmedTop(gridTopOffset).withWidth(keyboardWidth),
+                        &PianoRollComponent::drawKeyboard);
+        drawStaticLayer(g, headerLayer, visible.withHeight(gridTopOffset), &PianoRollComponent::drawHeaderLayer);
+    }
+    else
+    {
+        drawKeyboard(g);
+        drawHeaderLayer(g);
+    }
     drawPlayhead(g);
-    drawKeyboard(g);
+
+    if (showFrameTimes)
+    {
+        frameTimesMs[static_cast<std::size_t>(nextFrameTime)] =
+            juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - paintStart) * 1000.0;
+        nextFrameTime = (nextFrameTime + 1) % frameTimeHistory;
+        numFrameTimes = std::min(numFrameTimes + 1, frameTimeHistory);
+        lastFrameScale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        drawFrameTimes(g);
+    }
+}
+
+void PianoRollComponent::drawGridLayer(juce::Graphics& g)
+{
+    g.fillAll(calliope::theme::surface::surface);
+    drawGrid(g);
+}
+
+void PianoRollComponent::drawHeaderLayer(juce::Graphics& g)
+{
     drawTempoTrack(g);
     drawTimeSignatureTrack(g);
     drawKeySignatureTrack(g);
@@ -835,6 +907,217 @@ void PianoRollComponent::paint(juce::Graphics& g)
     drawLoopBar(g);
 }
 
+void PianoRollComponent::drawStaticLayer(juce::Graphics& g, StaticLayer& layer, juce::Rectangle<int> area,
+                                         LayerPainter paintLayer)
+{
+    if (area.isEmpty() || !g.clipRegionIntersects(area))
+        return;
+
+    updateStaticLayer(layer, area, g.getInternalContext().getPhysicalPixelScaleFactor(), paintLayer);
+    g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+    g.drawImage(layer.image, area.toFloat());
+}
+
+bool PianoRollComponent::updateStaticLayer(StaticLayer& layer, juce::Rectangle<int> area, float scale,
+                                           LayerPainter paintLayer)
+{
+    if (layer.image.isNull() || layer.area != area || layer.scale != scale || layer.generation != staticLayerGeneration)
+    {
+        const int imageWidth = juce::roundToInt(static_cast<float>(area.getWidth()) * scale);
+        const int imageHeight = juce::roundToInt(static_cast<float>(area.getHeight()) * scale);
+        if (layer.image.getWidth() != imageWidth || layer.image.getHeight() != imageHeight)
+            layer.image = juce::Image(juce::Image::RGB, imageWidth, imageHeight, false);
+
+        // The keyboard and header painters don't cover every pixel, so start from the background.
+        juce::Graphics layerGraphics(layer.image);
+        layerGraphics.fillAll(calliope::theme::surface::surface);
+        layerGraphics.addTransform(
+            juce::AffineTransform::translation(static_cast<float>(-area.getX()), static_cast<float>(-area.getY()))
+                .scaled(scale));
+        (this->*paintLayer)(layerGraphics);
+
+        layer.area = area;
+        layer.scale = scale;
+        layer.generation = staticLayerGeneration;
+        return true;
+    }
+    return false;
+}
+
+void PianoRollComponent::clearStaticLayers()
+{
+    gridLayer = {};
+    glGridImage = {};
+    keyboardLayer = {};
+    headerLayer = {};
+}
+
+juce::Rectangle<int> PianoRollComponent::getVisibleArea() const
+{
+    if (auto* vp = findParentComponentOfClass<juce::Viewport>())
+        return vp->getViewArea().getIntersection(getLocalBounds());
+    return getLocalBounds();
+}
+
+void PianoRollComponent::setStaticLayerCacheEnabled(bool enabled)
+{
+    staticLayerCacheEnabled = enabled;
+    clearStaticLayers();
+    numFrameTimes = 0;
+    nextFrameTime = 0;
+    repaint();
+}
+
+void PianoRollComponent::setShowFrameTimes(bool show)
+{
+    showFrameTimes = show;
+    numFrameTimes = 0;
+    nextFrameTime = 0;
+    repaint();
+}
+
+void PianoRollComponent::setOpenGLRenderingEnabled(bool enabled)
+{
+    if (enabled == (noteCanvas != nullptr))
+        return;
+
+    if (!enabled)
+    {
+        noteCanvas.reset();
+        repaint();
+        return;
+    }
+
+    auto* vp = findParentComponentOfClass<juce::Viewport>();
+    if (vp == nullptr)
+        return;
+
+    // The context goes on the viewport: this component can be far larger than any GL surface.
+    juce::Component::SafePointer<PianoRollComponent> safeThis(this);
+    noteCanvas = std::make_unique<NoteCanvasGL>(*this);
+    noteCanvas->onActivated = [safeThis]()
+    {
+        if (safeThis != nullptr)
+            safeThis->repaint();
+    };
+    noteCanvas->onUnavailable = [safeThis]()
+    {
+        if (safeThis != nullptr)
+            safeThis->setOpenGLRenderingEnabled(false);
+    };
+    noteCanvas->attachTo(*vp);
+}
+
+bool PianoRollComponent::getNoteCanvasFrame(NoteCanvasGL::Frame& frame, float renderingScale)
+{
+    auto* vp = findParentComponentOfClass<juce::Viewport>();
+    if (!sequence || vp == nullptr)
+        return false;
+
+    const auto gridArea = getVisibleArea().withTrimmedLeft(keyboardWidth).withTrimmedTop(gridTopOffset);
+    // The GL thread gets its own copy, taken whenever the layer is redrawn: frames that run off the
+    // message lock keep drawing it while the layer itself is repainted in place.
+    if (updateStaticLayer(gridLayer, gridArea, renderingScale, &PianoRollComponent::drawGridLayer)
+        || glGridImage.isNull())
+        glGridImage = gridLayer.image.createCopy();
+    frame.background = glGridImage;
+    frame.backgroundArea = (gridArea + vp->getLocalPoint(this, juce::Point<int>())).toFloat();
+
+    // Ticks go to the shader relative to a beat at the left edge, which keeps them exact in floats
+    // and lands on the same pixels as tickToX.
+    const int ppq = sequence->getTicksPerQuarterNote();
+    frame.baseTick = std::max(0, xToTick(gridArea.getX())) / ppq * ppq;
+    frame.origin = vp->getLocalPoint(this, juce::Point<int>(tickToX(frame.baseTick), gridTopOffset)).toFloat();
+    frame.pixelsPerTick = static_cast<float>(beatWidth) / static_cast<float>(ppq);
+    frame.noteHeight = static_cast<float>(noteHeight);
+
+    auto addLayer = [&](int trackIdx)
+    {
+        const auto& track = sequence->getTrack(trackIdx);
+        LayerHash signature;
+        signature.add(track.getRevision());
+        signature.add(trackIdx == activeTrackIndex);
+        signature.add(TrackColours::getColour(trackIdx).getARGB());
+        for (NoteId id : selectedNoteIds(trackIdx))
+            signature.add(static_cast<int>(id));
+        frame.layers.push_back({trackIdx, signature.value, track.getChannel() == 10});
+    };
+
+    for (int trackIdx : selectedTrackIndices)
+        if (trackIdx != activeTrackIndex && trackIdx >= 0 && trackIdx < sequence->getNumTracks())
+            addLayer(trackIdx);
+    if (activeTrackIndex >= 0 && activeTrackIndex < sequence->getNumTracks() &&
+        selectedTrackIndices.contains(activeTrackIndex))
+        addLayer(activeTrackIndex);
+    return true;
+}
+
+void PianoRollComponent::getNoteInstances(int trackIndex, std::vector<NoteCanvasGL::Instance>& instances)
+{
+    if (!sequence || trackIndex < 0 || trackIndex >= sequence->getNumTracks())
+        return;
+
+    auto toRGBA = [](juce::Colour c, std::uint8_t (&out)[4])
+    {
+        out[0] = c.getRed();
+        out[1] = c.getGreen();
+        out[2] = c.getBlue();
+        out[3] = c.getAlpha();
+    };
+
+    const auto& track = sequence->getTrack(trackIndex);
+    const float alpha = trackIndex == activeTrackIndex ? 1.0f : 0.4f;
+    const auto baseColour = TrackColours::getColour(trackIndex).withAlpha(alpha);
+    const auto selectedIds = selectedNoteIds(trackIndex);
+    const auto notes = track.getNotes();
+    const auto startTicks = notes.startTicks();
+    const auto durations = notes.durations();
+    const auto noteNumbers = notes.noteNumbers();
+
+    instances.reserve(notes.size());
+    for (std::size_t slot = 0; slot < notes.size(); ++slot)
+    {
+        const bool isSelected = std::ranges::binary_search(selectedIds, track.getNoteId(static_cast<int>(slot)));
+        auto instance = NoteCanvasGL::Instance::make(startTicks[slot], durations[slot], noteNumbers[slot]);
+        toRGBA(isSelected ? baseColour.brighter(0.4f) : baseColour, instance.fill);
+        toRGBA((isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f)).withAlpha(alpha), instance.outline);
+        instances.push_back(instance);
+    }
+}
+
+juce::Rectangle<int> PianoRollComponent::getFrameTimesBounds() const
+{
+    const auto visible = getVisibleArea();
+    return {visible.getRight() - 280, visible.getBottom() - 22, 280, 22};
+}
+
+void PianoRollComponent::drawFrameTimes(juce::Graphics& g)
+{
+    using namespace calliope::theme;
+    double total = 0.0;
+    double worst = 0.0;
+    for (int i = 0; i < numFrameTimes; ++i)
+    {
+        total += frameTimesMs[static_cast<std::size_t>(i)];
+        worst = std::max(worst, frameTimesMs[static_cast<std::size_t>(i)]);
+    }
+
+    const auto visible = getVisibleArea();
+    const auto bounds = getFrameTimesBounds();
+    g.setColour(surface::bg2.withAlpha(0.85f));
+    g.fillRect(bounds);
+    g.setColour(text::t2);
+    g.setFont(font::mono(font::sizeXS));
+    g.drawText(juce::String::formatted("%dx%d %s  avg %.2f ms  max %.2f ms",
+                                       juce::roundToInt(static_cast<float>(visible.getWidth()) * lastFrameScale),
+                                       juce::roundToInt(static_cast<float>(visible.getHeight()) * lastFrameScale),
+                                       noteCanvas != nullptr && noteCanvas->isActive() ? "opengl"
+                                       : staticLayerCacheEnabled                          ? "cached"
+                                                                                          : "direct",
+                                       total / numFrameTimes, worst),
+               bounds.reduced(6, 0), juce::Justification::centredRight);
+}
+
 void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
 {
     if (!sequence || sequence->getNumTracks() == 0)
@@ -881,6 +1164,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
                     selectedTempoIndices.erase(pointIndex);
                 else
                     selectedTempoIndices.insert(pointIndex);
+                invalidateStaticLayers();
                 repaint();
                 return;
             }
@@ -916,6 +1200,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
                     sequence->addTempoChange(tempoTick, tempoBpm);
                 }
                 selectedTempoIndices.clear();
+                invalidateStaticLayers();
                 repaint();
                 if (onTempoChanged)
                     onTempoChanged();
@@ -932,6 +1217,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
             tempoSelectBase = e.mods.isShiftDown() ? selectedTempoIndices : std::set<int>{};
             if (!e.mods.isShiftDown())
                 selectedTempoIndices.clear();
+            invalidateStaticLayers();
             repaint();
             return;
         }
@@ -959,7 +1245,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
         {
             if (!e.mods.isRightButtonDown())
             {
-                auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteIndex));
+                auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteId));
                 if (edge != ResizeEdge::None)
                 {
                     beginResize(hit, edge);
@@ -970,11 +1256,11 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
             if (undoManager)
             {
                 undoManager->beginNewTransaction("Delete Note");
-                undoManager->perform(new NoteDeleteAction(sequence, hit.trackIndex, hit.noteIndex));
+                undoManager->perform(new NoteDeleteAction(sequence, hit.trackIndex, hit.noteId));
             }
             else
             {
-                sequence->getTrack(hit.trackIndex).removeNote(hit.noteIndex);
+                sequence->getTrack(hit.trackIndex).removeNote(hit.noteId);
             }
             selectedNote = {};
             selectedNotes.clear();
@@ -1002,13 +1288,11 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
             undoManager->beginNewTransaction("Add Note");
             auto* action = new NoteAddAction(sequence, activeTrackIndex, newNote);
             undoManager->perform(action);
-            selectedNote = {activeTrackIndex, action->getAddedIndex()};
+            selectedNote = {activeTrackIndex, action->getAddedId()};
         }
         else
         {
-            auto& track = sequence->getTrack(activeTrackIndex);
-            track.addNote(newNote);
-            selectedNote = {activeTrackIndex, track.getNumNotes() - 1};
+            selectedNote = {activeTrackIndex, sequence->getTrack(activeTrackIndex).addNote(newNote)};
         }
         selectedNotes.clear();
         selectedNotes.insert(selectedNote);
@@ -1041,16 +1325,8 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
                 }
                 else
                 {
-                    std::map<int, std::vector<int>> toRemove;
                     for (const auto& ref : selectedNotes)
-                        toRemove[ref.trackIndex].push_back(ref.noteIndex);
-
-                    for (auto& [trackIdx, indices] : toRemove)
-                    {
-                        std::sort(indices.begin(), indices.end(), std::greater<int>());
-                        for (int idx : indices)
-                            sequence->getTrack(trackIdx).removeNote(idx);
-                    }
+                        sequence->getTrack(ref.trackIndex).removeNote(ref.noteId);
                 }
 
                 selectedNote = {};
@@ -1068,7 +1344,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
         {
             if (!e.mods.isShiftDown())
             {
-                auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteIndex));
+                auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteId));
                 if (edge != ResizeEdge::None)
                 {
                     beginResize(hit, edge);
@@ -1093,7 +1369,7 @@ void PianoRollComponent::mouseDown(const juce::MouseEvent& e)
                 }
                 beginMove(hit, e);
             }
-            const auto& note = sequence->getTrack(hit.trackIndex).getNote(hit.noteIndex);
+            const auto& note = sequence->getTrack(hit.trackIndex).getNote(hit.noteId);
             startNotePreview(note);
             repaint();
             if (onNoteSelectionChanged)
@@ -1135,6 +1411,7 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
         {
             loopStartTick = start;
             loopEndTick = end;
+            invalidateStaticLayers();
             repaint();
             if (onLoopRegionChanged)
                 onLoopRegionChanged(loopStartTick, loopEndTick);
@@ -1194,6 +1471,7 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
         sequence->setTempoChanges(changes);
 
         tempoDragMoved = (deltaTick != 0) || (deltaBpm != 0.0);
+        invalidateStaticLayers();
         repaint();
         return;
     }
@@ -1212,6 +1490,7 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
             if (changes[i].tick >= tickLo && changes[i].tick <= tickHi)
                 selectedTempoIndices.insert(i);
 
+        invalidateStaticLayers();
         repaint();
         return;
     }
@@ -1255,9 +1534,11 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
             int delta = currentTick - resizeAnchorEndTick;
             for (const auto& t : resizeTargets)
             {
-                auto& note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteIndex);
+                auto& track = sequence->getTrack(t.ref.trackIndex);
+                auto note = track.getNote(t.ref.noteId);
                 note.startTick = t.startTick;
                 note.duration = std::max(minDuration, t.duration + delta);
+                track.setNote(t.ref.noteId, note);
             }
         }
         else if (resizeEdge == ResizeEdge::Left)
@@ -1265,11 +1546,13 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
             int delta = currentTick - resizeAnchorStartTick;
             for (const auto& t : resizeTargets)
             {
-                auto& note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteIndex);
+                auto& track = sequence->getTrack(t.ref.trackIndex);
+                auto note = track.getNote(t.ref.noteId);
                 int endTick = t.startTick + t.duration;
                 int newStart = std::clamp(t.startTick + delta, 0, endTick - minDuration);
                 note.startTick = newStart;
                 note.duration = endTick - newStart;
+                track.setNote(t.ref.noteId, note);
             }
         }
 
@@ -1300,7 +1583,7 @@ void PianoRollComponent::mouseDrag(const juce::MouseEvent& e)
     moveDeltaTick = snappedDeltaTick;
     moveDeltaNote = deltaNote;
 
-    const auto& anchorNote = sequence->getTrack(selectedNote.trackIndex).getNote(selectedNote.noteIndex);
+    const auto& anchorNote = sequence->getTrack(selectedNote.trackIndex).getNote(selectedNote.noteId);
     int previewPitch = anchorNote.noteNumber + moveDeltaNote;
     if (previewPitch != previewNote.noteNumber)
     {
@@ -1351,6 +1634,7 @@ void PianoRollComponent::mouseUp(const juce::MouseEvent&)
         tempoDragBefore.clear();
         tempoDragGroup.clear();
         tempoDragMoved = false;
+        invalidateStaticLayers();
         repaint();
         return;
     }
@@ -1359,6 +1643,7 @@ void PianoRollComponent::mouseUp(const juce::MouseEvent&)
     {
         isTempoRangeSelecting = false;
         tempoSelectBase.clear();
+        invalidateStaticLayers();
         repaint();
         return;
     }
@@ -1386,13 +1671,13 @@ void PianoRollComponent::mouseUp(const juce::MouseEvent&)
             std::vector<NoteModification> mods;
             for (const auto& t : resizeTargets)
             {
-                auto& note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteIndex);
+                const auto note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteId);
                 if (note.startTick == t.startTick && note.duration == t.duration)
                     continue;
 
                 MidiNote beforeNote{note.noteNumber, note.velocity, t.startTick, t.duration};
                 MidiNote afterNote = note;
-                mods.push_back({t.ref.trackIndex, t.ref.noteIndex, beforeNote, afterNote});
+                mods.push_back({t.ref.trackIndex, t.ref.noteId, beforeNote, afterNote});
             }
 
             if (!mods.empty())
@@ -1421,12 +1706,12 @@ void PianoRollComponent::mouseUp(const juce::MouseEvent&)
                 std::vector<NoteModification> mods;
                 for (const auto& t : moveTargets)
                 {
-                    auto& note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteIndex);
+                    const auto note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteId);
                     MidiNote beforeNote{t.noteNumber, note.velocity, t.startTick, note.duration};
                     MidiNote afterNote = beforeNote;
                     afterNote.startTick = t.startTick + moveDeltaTick;
                     afterNote.noteNumber = t.noteNumber + moveDeltaNote;
-                    mods.push_back({t.ref.trackIndex, t.ref.noteIndex, beforeNote, afterNote});
+                    mods.push_back({t.ref.trackIndex, t.ref.noteId, beforeNote, afterNote});
                 }
                 if (!mods.empty())
                     undoManager->perform(new MultiNoteModifyAction(sequence, std::move(mods)));
@@ -1435,11 +1720,12 @@ void PianoRollComponent::mouseUp(const juce::MouseEvent&)
             {
                 for (const auto& t : moveTargets)
                 {
-                    auto& note = sequence->getTrack(t.ref.trackIndex).getNote(t.ref.noteIndex);
+                    auto& track = sequence->getTrack(t.ref.trackIndex);
+                    const auto note = track.getNote(t.ref.noteId);
                     MidiNote afterNote{t.noteNumber, note.velocity, t.startTick, note.duration};
                     afterNote.startTick = t.startTick + moveDeltaTick;
                     afterNote.noteNumber = t.noteNumber + moveDeltaNote;
-                    note = afterNote;
+                    track.setNote(t.ref.noteId, afterNote);
                 }
             }
 
@@ -1473,7 +1759,7 @@ void PianoRollComponent::mouseMove(const juce::MouseEvent& e)
 
     if (hit.isValid())
     {
-        auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteIndex));
+        auto edge = edgeAt(e.x, sequence->getTrack(hit.trackIndex).getNote(hit.noteId));
         if (edge != ResizeEdge::None)
             setMouseCursor(juce::MouseCursor::LeftRightResizeCursor);
         else
@@ -1614,13 +1900,6 @@ void PianoRollComponent::drawLoopBar(juce::Graphics& g)
         g.fillRect(lx2 - 1.0f, static_cast<float>(lbTop + 2), 2.0f, static_cast<float>(loopBarHeight - 4));
     }
 
-    float phX = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    if (phX >= static_cast<float>(kbLeft + keyboardWidth) && phX <= static_cast<float>(getWidth()))
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(lbTop), phX, static_cast<float>(lbTop + loopBarHeight), 1.0f);
-    }
-
     g.restoreState();
 
     g.setColour(border::normal);
@@ -1712,15 +1991,6 @@ void PianoRollComponent::drawRuler(juce::Graphics& g)
         barNumber++;
     }
 
-    float phX = sequence
-                    ? static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth)
-                    : static_cast<float>(keyboardWidth);
-    if (phX >= static_cast<float>(visibleLeft) - 1.0f && phX <= static_cast<float>(visibleRight) + 1.0f)
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(hTop), phX, static_cast<float>(hTop + rulerHeight), 1.0f);
-    }
-
     drawLoopOverlay(g, hTop, rulerHeight, 0.35f);
 
     g.restoreState();
@@ -1906,13 +2176,6 @@ void PianoRollComponent::drawTempoTrack(juce::Graphics& g)
         }
     }
 
-    float phX = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    if (phX >= static_cast<float>(visibleLeft) - 1.0f && phX <= static_cast<float>(visibleRight) + 1.0f)
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(tTop), phX, static_cast<float>(tTop + tempoTrackHeight), 1.0f);
-    }
-
     drawTempoRangeSelection(g);
 
     drawLoopOverlay(g, tTop, tempoTrackHeight, 0.12f);
@@ -2016,13 +2279,6 @@ void PianoRollComponent::drawTimeSignatureTrack(juce::Graphics& g)
         }
     }
 
-    float phX = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    if (phX >= static_cast<float>(visibleLeft) - 1.0f && phX <= static_cast<float>(visibleRight) + 1.0f)
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(tsTop), phX, static_cast<float>(tsTop + timeSignatureTrackHeight), 1.0f);
-    }
-
     drawLoopOverlay(g, tsTop, timeSignatureTrackHeight, 0.12f);
 
     g.restoreState();
@@ -2106,13 +2362,6 @@ void PianoRollComponent::drawKeySignatureTrack(juce::Graphics& g)
         }
     }
 
-    float phX = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    if (phX >= static_cast<float>(visibleLeft) - 1.0f && phX <= static_cast<float>(visibleRight) + 1.0f)
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(ksTop), phX, static_cast<float>(ksTop + keySignatureTrackHeight), 1.0f);
-    }
-
     drawLoopOverlay(g, ksTop, keySignatureTrackHeight, 0.12f);
 
     g.restoreState();
@@ -2191,13 +2440,6 @@ void PianoRollComponent::drawChordTrack(juce::Graphics& g)
         }
     }
 
-    float phX = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    if (phX >= static_cast<float>(visibleLeft) - 1.0f && phX <= static_cast<float>(visibleRight) + 1.0f)
-    {
-        g.setColour(text::t1);
-        g.drawLine(phX, static_cast<float>(ctTop), phX, static_cast<float>(ctTop + chordTrackHeight), 1.0f);
-    }
-
     drawLoopOverlay(g, ctTop, chordTrackHeight, 0.12f);
 
     g.restoreState();
@@ -2300,117 +2542,91 @@ void PianoRollComponent::drawGrid(juce::Graphics& g)
     }
 }
 
+std::vector<NoteId> PianoRollComponent::selectedNoteIds(int trackIndex) const
+{
+    std::vector<NoteId> ids;
+    for (auto it = selectedNotes.lower_bound({trackIndex, NoteId::invalid});
+         it != selectedNotes.end() && it->trackIndex == trackIndex; ++it)
+        ids.push_back(it->noteId);
+    return ids;
+}
+
 void PianoRollComponent::drawNotes(juce::Graphics& g)
 {
     if (!sequence)
         return;
 
-    auto clip = g.getClipBounds();
+    const auto clip = g.getClipBounds();
+    const auto tickRange = tickRangeForPixels(clip.getX(), clip.getRight());
+    const int lowNote = std::clamp(yToNote(clip.getBottom()), 0, totalNotes - 1);
+    const int highNote = std::clamp(yToNote(clip.getY()), 0, totalNotes - 1);
+    const float noteBodyHeight = static_cast<float>(noteHeight - 2);
 
-    for (int trackIdx : selectedTrackIndices)
+    // Each track is drawn as one fill and one stroke per selection state rather than per note. Notes
+    // smaller than kPlainNotePixels in either direction fall back to plain unoutlined rectangles.
+    auto drawTrackNotes = [&](int trackIdx, float alpha)
     {
-        if (trackIdx == activeTrackIndex)
-            continue;
-        if (trackIdx < 0 || trackIdx >= sequence->getNumTracks())
-            continue;
-
         const auto& track = sequence->getTrack(trackIdx);
-        float alpha = 0.4f;
+        track.findNotesInRange(tickRange.first, tickRange.second, visibleNoteIds, lowNote, highNote);
+        if (visibleNoteIds.empty())
+            return;
 
-        for (int i = 0; i < track.getNumNotes(); ++i)
-        {
-            const auto& note = track.getNote(i);
-            auto baseColour = TrackColours::getColour(trackIdx).withAlpha(alpha);
-            int x = tickToX(note.startTick);
-            int y = noteToY(note.noteNumber);
-            int w = tickToWidth(note.duration);
+        const auto selectedIds = selectedNoteIds(trackIdx);
+        const bool isDrum = track.getChannel() == 10;
+        const auto baseColour = TrackColours::getColour(trackIdx).withAlpha(alpha);
+        juce::Path shapes[2];
+        juce::RectangleList<float> plainRects[2];
 
-            if (y + noteHeight < clip.getY() || y > clip.getBottom())
+        for (NoteId id : visibleNoteIds)
+        {
+            const auto note = track.getNote(id);
+            const float x = static_cast<float>(tickToX(note.startTick));
+            const float y = static_cast<float>(noteToY(note.noteNumber) + 1);
+            const auto bounds = isDrum ? juce::Rectangle<float>(x - noteBodyHeight * 0.5f, y, noteBodyHeight,
+                                                                noteBodyHeight)
+                                       : juce::Rectangle<float>(x, y, static_cast<float>(tickToWidth(note.duration)),
+                                                                noteBodyHeight);
+
+            if (bounds.getRight() < static_cast<float>(clip.getX()) ||
+                bounds.getX() > static_cast<float>(clip.getRight()))
                 continue;
 
-            bool isSelected = isNoteSelected({trackIdx, i});
-
-            if (track.getChannel() == 10)
-            {
-                float diameter = static_cast<float>(noteHeight - 2);
-                float cx = static_cast<float>(x);
-                float cy = static_cast<float>(y + 1) + diameter * 0.5f;
-                float left = cx - diameter * 0.5f;
-
-                if (left + diameter < clip.getX() || left > clip.getRight())
-                    continue;
-
-                g.setColour(isSelected ? baseColour.brighter(0.4f) : baseColour);
-                g.fillEllipse(left, cy - diameter * 0.5f, diameter, diameter);
-
-                g.setColour((isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f)).withAlpha(alpha));
-                g.drawEllipse(left, cy - diameter * 0.5f, diameter, diameter, 1.0f);
-            }
+            const int state = std::ranges::binary_search(selectedIds, id) ? 1 : 0;
+            if (bounds.getWidth() < kPlainNotePixels || noteBodyHeight < kPlainNotePixels)
+                plainRects[state].addWithoutMerging(bounds.withWidth(std::max(1.0f, bounds.getWidth())));
+            else if (isDrum)
+                shapes[state].addEllipse(bounds);
             else
-            {
-                if (x + w < clip.getX() || x > clip.getRight())
-                    continue;
-
-                g.setColour(isSelected ? baseColour.brighter(0.4f) : baseColour);
-                g.fillRoundedRectangle(static_cast<float>(x), static_cast<float>(y + 1), static_cast<float>(w),
-                                       static_cast<float>(noteHeight - 2), 2.0f);
-
-                g.setColour((isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f)).withAlpha(alpha));
-                g.drawRoundedRectangle(static_cast<float>(x), static_cast<float>(y + 1), static_cast<float>(w),
-                                       static_cast<float>(noteHeight - 2), 2.0f, 1.0f);
-            }
+                shapes[state].addRoundedRectangle(bounds, 2.0f);
         }
-    }
 
-    if (activeTrackIndex >= 0 && activeTrackIndex < sequence->getNumTracks() &&
-        selectedTrackIndices.contains(activeTrackIndex))
-    {
-        const auto& track = sequence->getTrack(activeTrackIndex);
-
-        for (int i = 0; i < track.getNumNotes(); ++i)
+        for (int state = 0; state < 2; ++state)
         {
-            const auto& note = track.getNote(i);
-            auto baseColour = TrackColours::getColour(activeTrackIndex);
-            int x = tickToX(note.startTick);
-            int y = noteToY(note.noteNumber);
-            int w = tickToWidth(note.duration);
-
-            if (y + noteHeight < clip.getY() || y > clip.getBottom())
+            const bool isSelected = state == 1;
+            g.setColour(isSelected ? baseColour.brighter(0.4f) : baseColour);
+            if (!plainRects[state].isEmpty())
+                g.fillRectList(plainRects[state]);
+            if (shapes[state].isEmpty())
                 continue;
 
-            bool isSelected = isNoteSelected({activeTrackIndex, i});
-
-            if (track.getChannel() == 10)
-            {
-                float diameter = static_cast<float>(noteHeight - 2);
-                float cx = static_cast<float>(x);
-                float cy = static_cast<float>(y + 1) + diameter * 0.5f;
-                float left = cx - diameter * 0.5f;
-
-                if (left + diameter < clip.getX() || left > clip.getRight())
-                    continue;
-
-                g.setColour(isSelected ? baseColour.brighter(0.4f) : baseColour);
-                g.fillEllipse(left, cy - diameter * 0.5f, diameter, diameter);
-
-                g.setColour(isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f));
-                g.drawEllipse(left, cy - diameter * 0.5f, diameter, diameter, 1.0f);
-            }
-            else
-            {
-                if (x + w < clip.getX() || x > clip.getRight())
-                    continue;
-
-                g.setColour(isSelected ? baseColour.brighter(0.4f) : baseColour);
-                g.fillRoundedRectangle(static_cast<float>(x), static_cast<float>(y + 1), static_cast<float>(w),
-                                       static_cast<float>(noteHeight - 2), 2.0f);
-
-                g.setColour(isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f));
-                g.drawRoundedRectangle(static_cast<float>(x), static_cast<float>(y + 1), static_cast<float>(w),
-                                       static_cast<float>(noteHeight - 2), 2.0f, 1.0f);
-            }
+            g.fillPath(shapes[state]);
+            g.setColour((isSelected ? baseColour.brighter(0.7f) : baseColour.darker(0.3f)).withAlpha(alpha));
+            g.strokePath(shapes[state], juce::PathStrokeType(1.0f));
         }
+    };
+
+    for (int trackIdx : selectedTrackIndices)
+    {
+        if (trackIdx == activeTrackIndex)
+            continue;
+        if (trackIdx < 0 || trackIdx >= sequence->getNumTracks())
+            continue;
+        drawTrackNotes(trackIdx, 0.4f);
     }
+
+    if (activeTrackIndex >= 0 && activeTrackIndex < sequence->getNumTracks() &&
+        selectedTrackIndices.contains(activeTrackIndex))
+        drawTrackNotes(activeTrackIndex, 1.0f);
 }
 
 void PianoRollComponent::drawMoveGhosts(juce::Graphics& g)
@@ -2428,7 +2644,7 @@ void PianoRollComponent::drawMoveGhosts(juce::Graphics& g)
             continue;
 
         const auto& track = sequence->getTrack(t.ref.trackIndex);
-        const auto& note = track.getNote(t.ref.noteIndex);
+        const auto& note = track.getNote(t.ref.noteId);
 
         int x = tickToX(t.startTick + moveDeltaTick);
         int y = noteToY(t.noteNumber + moveDeltaNote);
@@ -2471,17 +2687,19 @@ void PianoRollComponent::drawMoveGhosts(juce::Graphics& g)
     }
 }
 
+// One line through the header lanes and the grid, drawn on top of both.
 void PianoRollComponent::drawPlayhead(juce::Graphics& g)
 {
     using namespace calliope::theme;
     if (!sequence)
         return;
-    float x = static_cast<float>(keyboardWidth + playheadTick / sequence->getTicksPerQuarterNote() * beatWidth);
-    auto clip = g.getClipBounds();
-    if (x < static_cast<float>(clip.getX()) - 1.0f || x > static_cast<float>(clip.getRight()) + 1.0f)
+    const int x = getPlayheadX();
+    const auto clip = g.getClipBounds();
+    if (x < clip.getX() || x >= clip.getRight() || x < getKeyboardLeft() + keyboardWidth)
         return;
+
     g.setColour(text::t1);
-    g.drawLine(x, static_cast<float>(clip.getY()), x, static_cast<float>(clip.getBottom()), 1.0f);
+    g.drawVerticalLine(x, static_cast<float>(clip.getY()), static_cast<float>(clip.getBottom()));
 }
 
 void PianoRollComponent::setLoopRegion(bool enabled, int startTick, int endTick)
@@ -2489,6 +2707,7 @@ void PianoRollComponent::setLoopRegion(bool enabled, int startTick, int endTick)
     loopEnabled = enabled;
     loopStartTick = startTick;
     loopEndTick = endTick;
+    invalidateStaticLayers();
     repaint();
 }
 
@@ -2547,6 +2766,9 @@ void PianoRollComponent::updateSize()
         width = std::max(width, vp->getMaximumVisibleWidth());
 
     int height = gridTopOffset + totalNotes * noteHeight;
+    // Called on every scroll; the layers only depend on the size, not the position.
+    if (width != getWidth() || height != getHeight())
+        invalidateStaticLayers();
     setSize(width, height);
 }
 
@@ -2573,6 +2795,11 @@ int PianoRollComponent::tickToWidth(int durationTicks) const
     return static_cast<int>(beats * beatWidth);
 }
 
+std::pair<int, int> PianoRollComponent::tickRangeForPixels(int left, int right) const
+{
+    return {xToTick(left - noteHeight) - 1, xToTick(right + noteHeight) + 1};
+}
+
 int PianoRollComponent::xToTick(int x) const
 {
     if (!sequence)
@@ -2656,6 +2883,7 @@ int PianoRollComponent::floorTickToGrid(int tick) const
 void PianoRollComponent::setQuantizeDenominator(int denom)
 {
     quantizeDenominator = denom;
+    invalidateStaticLayers();
     repaint();
 }
 
@@ -2719,6 +2947,7 @@ void PianoRollComponent::drawTrackGridLines(juce::Graphics& g, int visibleLeft,
 void PianoRollComponent::setBeatWidth(int w)
 {
     beatWidth = juce::jlimit(minBeatWidth, maxBeatWidth, w);
+    invalidateStaticLayers();
     updateSize();
     repaint();
     if (onZoomChanged)
@@ -2728,6 +2957,7 @@ void PianoRollComponent::setBeatWidth(int w)
 void PianoRollComponent::setNoteHeight(int h)
 {
     noteHeight = juce::jlimit(minNoteHeight, maxNoteHeight, h);
+    invalidateStaticLayers();
     updateSize();
     repaint();
     if (onZoomChanged)
@@ -2757,11 +2987,11 @@ void PianoRollComponent::beginResize(const NoteRef& hit, ResizeEdge edge)
     resizeTargets.clear();
     for (const auto& ref : targets)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         resizeTargets.push_back({ref, note.startTick, note.duration});
     }
 
-    const auto& anchor = sequence->getTrack(hit.trackIndex).getNote(hit.noteIndex);
+    const auto& anchor = sequence->getTrack(hit.trackIndex).getNote(hit.noteId);
     resizeAnchorStartTick = anchor.startTick;
     resizeAnchorEndTick = anchor.endTick();
     resizeEdge = edge;
@@ -2775,11 +3005,11 @@ void PianoRollComponent::beginMove(const NoteRef& anchor, const juce::MouseEvent
     moveTargets.clear();
     for (const auto& ref : selectedNotes)
     {
-        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteIndex);
+        const auto& note = sequence->getTrack(ref.trackIndex).getNote(ref.noteId);
         moveTargets.push_back({ref, note.startTick, note.noteNumber});
     }
 
-    const auto& anchorNote = sequence->getTrack(anchor.trackIndex).getNote(anchor.noteIndex);
+    const auto& anchorNote = sequence->getTrack(anchor.trackIndex).getNote(anchor.noteId);
     moveAnchorStartTick = anchorNote.startTick;
     moveDeltaTick = 0;
     moveDeltaNote = 0;
@@ -2794,19 +3024,22 @@ PianoRollComponent::NoteRef PianoRollComponent::hitTestNote(int x, int y) const
     if (!sequence)
         return {};
 
+    const auto [fromTick, toTick] = tickRangeForPixels(x, x);
+
     if (activeTrackIndex >= 0 && activeTrackIndex < sequence->getNumTracks() &&
         selectedTrackIndices.contains(activeTrackIndex))
     {
         const auto& track = sequence->getTrack(activeTrackIndex);
-        for (int i = 0; i < track.getNumNotes(); ++i)
+        track.findNotesInRange(fromTick, toTick, visibleNoteIds);
+        for (NoteId id : visibleNoteIds)
         {
-            const auto& note = track.getNote(i);
+            const auto note = track.getNote(id);
             int nx = tickToX(note.startTick);
             int ny = noteToY(note.noteNumber);
             int nw = tickToWidth(note.duration);
 
             if (x >= nx && x <= nx + nw && y >= ny && y < ny + noteHeight)
-                return {activeTrackIndex, i};
+                return {activeTrackIndex, id};
         }
     }
 
@@ -2818,15 +3051,16 @@ PianoRollComponent::NoteRef PianoRollComponent::hitTestNote(int x, int y) const
             continue;
 
         const auto& track = sequence->getTrack(trackIdx);
-        for (int i = 0; i < track.getNumNotes(); ++i)
+        track.findNotesInRange(fromTick, toTick, visibleNoteIds);
+        for (NoteId id : visibleNoteIds)
         {
-            const auto& note = track.getNote(i);
+            const auto note = track.getNote(id);
             int nx = tickToX(note.startTick);
             int ny = noteToY(note.noteNumber);
             int nw = tickToWidth(note.duration);
 
             if (x >= nx && x <= nx + nw && y >= ny && y < ny + noteHeight)
-                return {trackIdx, i};
+                return {trackIdx, id};
         }
     }
 
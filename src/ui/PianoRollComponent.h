@@ -1,13 +1,21 @@
 #pragma once
 
 #include "../model/MidiSequence.h"
+#include "NoteCanvasGL.h"
 #include <juce_data_structures/juce_data_structures.h>
 #include <juce_gui_basics/juce_gui_basics.h>
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
-class PianoRollComponent : public juce::Component, public MidiSequence::Listener, private juce::Timer
+class PianoRollComponent : public juce::Component,
+                           public MidiSequence::Listener,
+                           private juce::Timer,
+                           private NoteCanvasGL::Source
 {
 public:
     ~PianoRollComponent() override;
@@ -21,8 +29,8 @@ public:
     struct NoteRef
     {
         int trackIndex = -1;
-        int noteIndex = -1;
-        bool isValid() const { return trackIndex >= 0 && noteIndex >= 0; }
+        NoteId noteId = NoteId::invalid;
+        bool isValid() const { return trackIndex >= 0 && noteId != NoteId::invalid; }
         auto operator<=>(const NoteRef&) const = default;
     };
 
@@ -105,6 +113,15 @@ public:
     void setQuantizeDenominator(int denom);
     int getQuantizeDenominator() const { return quantizeDenominator; }
 
+    void setStaticLayerCacheEnabled(bool enabled);
+    bool isStaticLayerCacheEnabled() const { return staticLayerCacheEnabled; }
+    void setShowFrameTimes(bool show);
+    bool isShowingFrameTimes() const { return showFrameTimes; }
+    // Draws the grid and notes through an OpenGL context on the enclosing viewport. Falls back to
+    // software drawing by itself if the context cannot draw instanced geometry.
+    void setOpenGLRenderingEnabled(bool enabled);
+    bool isOpenGLRenderingEnabled() const { return noteCanvas != nullptr; }
+
     int tickToX(int tick) const;
     int noteToY(int noteNumber) const;
     int xToTick(int x) const;
@@ -115,9 +132,11 @@ public:
 
 private:
     void notesChanged(int trackIndex) override;
+    void notesEdited(const std::vector<DirtyTickRange>& ranges) override;
     void tracksChanged() override;
     void tempoChanged() override;
     void timelineMetadataChanged() override;
+    void pruneVanishedSelection();
 
     enum class DragMode
     {
@@ -142,8 +161,37 @@ private:
     void drawLoopRegion(juce::Graphics& g);
     void drawLoopOverlay(juce::Graphics& g, int top, int height, float fillAlpha);
     void drawTrackGridLines(juce::Graphics& g, int visibleLeft, int visibleRight, float top, float bottom);
+    void drawGridLayer(juce::Graphics& g);
+    void drawHeaderLayer(juce::Graphics& g);
+    void drawFrameTimes(juce::Graphics& g);
+
+    // The grid, keyboard and header lanes are rendered into images covering the visible area and
+    // reused until they move or invalidateStaticLayers is called. Anything that changes what they draw
+    // (the timeline, zoom, size, loop, quantize grid, tempo selection or previewed key) must call it.
+    struct StaticLayer
+    {
+        juce::Image image;
+        juce::Rectangle<int> area;
+        float scale = 0.0f;
+        std::uint64_t generation = 0;
+    };
+    using LayerPainter = void (PianoRollComponent::*)(juce::Graphics&);
+    void drawStaticLayer(juce::Graphics& g, StaticLayer& layer, juce::Rectangle<int> area, LayerPainter paintLayer);
+    // Returns true if the layer was redrawn.
+    bool updateStaticLayer(StaticLayer& layer, juce::Rectangle<int> area, float scale, LayerPainter paintLayer);
+    void invalidateStaticLayers() { ++staticLayerGeneration; }
+    void clearStaticLayers();
+    juce::Rectangle<int> getVisibleArea() const;
+    juce::Rectangle<int> getFrameTimesBounds() const;
+
+    bool getNoteCanvasFrame(NoteCanvasGL::Frame& frame, float renderingScale) override;
+    void getNoteInstances(int trackIndex, std::vector<NoteCanvasGL::Instance>& instances) override;
 
     int tickToWidth(int durationTicks) const;
+    // Whole pixel column the playhead line is drawn in.
+    int getPlayheadX() const;
+    // Tick window covering pixels [left, right], padded for drum hits and rounding.
+    std::pair<int, int> tickRangeForPixels(int left, int right) const;
     int roundTickToGrid(int tick) const;
     int floorTickToGrid(int tick) const;
 
@@ -176,6 +224,8 @@ private:
     int activeTrackIndex = 0;
 
     bool isNoteSelected(const NoteRef& ref) const;
+    // Sorted ids of the selected notes in one track.
+    std::vector<NoteId> selectedNoteIds(int trackIndex) const;
     void drawRubberBand(juce::Graphics& g);
     std::vector<NoteRef> findNotesInRect(const juce::Rectangle<int>& rect) const;
 
@@ -256,4 +306,23 @@ private:
     int tempoSelectStartX = 0;
     int tempoSelectCurrentX = 0;
     std::set<int> tempoSelectBase;
+
+    bool staticLayerCacheEnabled = true;
+    std::uint64_t staticLayerGeneration = 1;
+    StaticLayer gridLayer;
+    juce::Image glGridImage;
+    StaticLayer keyboardLayer;
+    StaticLayer headerLayer;
+
+    bool showFrameTimes = false;
+    static constexpr int frameTimeHistory = 120;
+    std::array<double, frameTimeHistory> frameTimesMs{};
+    int numFrameTimes = 0;
+    int nextFrameTime = 0;
+    float lastFrameScale = 1.0f;
+
+    std::unique_ptr<NoteCanvasGL> noteCanvas;
+
+    // Reused by every note range query, so painting and hit tests don't allocate per call.
+    mutable std::vector<NoteId> visibleNoteIds;
 };